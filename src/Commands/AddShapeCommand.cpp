@@ -1,6 +1,8 @@
 #include "AddShapeCommand.h"
 #include <QLoggingCategory>
 #include "CoreSvgEngine/svgdocument.h"
+#include "CoreSvgEngine/svgjournal.h"
+#include "CommandManager.h"
 #include "CommandUtils.h"
 #include "SvgEditor/canvasarea.h"
 
@@ -46,17 +48,13 @@ bool AddShapeCommand::execute()
     }
 
     // Synchronize with SVG document model - essential for proper serialization
+    SvgSceneAdapter* adapter = m_canvasArea->sceneAdapter();
+    bool inDocument = adapter->contains(m_item);
     m_canvasArea->addShapeToDocument(m_item);
-
-    // Store element ID for reliable undo operation - we need this because 
-    // the document structure might change between execute and undo
     CoreSvgEngine* engine = m_canvasArea->getCurrentEngine();
-    if (engine && engine->getCurrentDocument()) {
-        auto& elements = engine->getCurrentDocument()->getElements();
-        if (!elements.empty()) {
-            m_elementId = elements.back()->getID();
-            qCDebug(addShapeCommandLog) << "Stored element ID for undo:" << QString::fromStdString(m_elementId);
-        }
+    SvgJournal* journal = CommandManager::instance()->journal();
+    if (!inDocument && journal && engine && engine->getCurrentDocument()) {
+        journal->recordInsert(*engine->getCurrentDocument(), adapter->elementForItem(m_item));
     }
 
     // Transfer ownership to the scene to ensure proper Qt object lifecycle
@@ -83,9 +81,16 @@ bool AddShapeCommand::undo()
     }
 
     // Remove from document first to maintain model-view consistency
-    if (!m_elementId.empty()) {
-        qCDebug(addShapeCommandLog) << "Removing element with ID:" << QString::fromStdString(m_elementId);
-        engine->getCurrentDocument()->removeElementById(m_elementId);
+    SvgSceneAdapter* adapter = m_canvasArea->sceneAdapter();
+    SvgElement* element = adapter->elementForItem(m_item);
+    if (element) {
+        if (SvgJournal* journal = CommandManager::instance()->journal()) {
+            journal->recordRemove(*engine->getCurrentDocument(), element);
+        }
+        adapter->unbind(m_item);
+        engine->getCurrentDocument()->removeElement(element);
+    } else {
+        qCWarning(addShapeCommandLog) << "Item has no element in the document";
     }
 
     if (m_item && m_item->scene()) {
@@ -20,5 +20,4 @@ private:
     QGraphicsItem* m_item;
     ShapeType m_shapeType;
     bool m_itemOwned; // Track ownership to prevent double-deletion during command lifecycle
-    std::string m_elementId; // Store ID for safe removal from document model during undo
 };
@@ -1,4 +1,5 @@
 #include "CommandManager.h"
+#include "CoreSvgEngine/svgjournal.h"
 
 Q_LOGGING_CATEGORY(commandManagerLog, "CommandManager")
 
@@ -97,6 +98,16 @@ bool CommandManager::redo()
     return false;
 }
 
+void CommandManager::setJournal(SvgJournal* journal)
+{
+    m_journal = journal;
+}
+
+SvgJournal* CommandManager::journal() const
+{
+    return m_journal && m_journal->isOpen() ? m_journal : nullptr;
+}
+
 bool CommandManager::canUndo() const
 {
     return !m_undoStack.isEmpty();
@@ -5,6 +5,8 @@
 #include <QLoggingCategory>
 #include "Command.h"
 
+class SvgJournal;
+
 Q_DECLARE_LOGGING_CATEGORY(commandManagerLog)
 
 class CommandManager : public QObject {
@@ -29,6 +31,11 @@ public:
 
     void clear();
 
+    // Journal that commands append their document changes to; nullptr stops journaling
+    void setJournal(SvgJournal* journal);
+    // nullptr while there is no open journal
+    SvgJournal* journal() const;
+
 signals:
 
     void undoRedoChanged();
@@ -48,5 +55,7 @@ private:
     QList<Command*> m_undoStack;
     QList<Command*> m_redoStack;
 
+    SvgJournal* m_journal = nullptr;
+
     static CommandManager* m_instance;
 };
@@ -2,7 +2,9 @@
 #include <QLoggingCategory>
 #include <algorithm> // For std::find
 #include "CoreSvgEngine/svgdocument.h"
+#include "CoreSvgEngine/svgjournal.h"
 #include "CoreSvgEngine/svgshapes.h"
+#include "CommandManager.h"
 #include "CommandUtils.h"
 #include "SvgEditor/canvasarea.h"
 
@@ -48,13 +50,18 @@ bool RemoveShapeCommand::execute()
     // Preserve original position for accurate restoration during undo
     m_sceneIndex = m_canvasArea->scene()->items().indexOf(m_item);
 
-    // Maintain synchronization between document model and graphics scene
-    auto it = std::find(doc->m_graphicsItems.begin(), doc->m_graphicsItems.end(), m_item);
-    if (it != doc->m_graphicsItems.end()) {
-        doc->m_graphicsItems.erase(it);
-        qCDebug(removeShapeCommandLog) << "Removed item from document's graphics items list";
+    // Detach the element from the document; the command keeps it for undo
+    SvgSceneAdapter* adapter = m_canvasArea->sceneAdapter();
+    SvgElement* element = adapter->elementForItem(m_item);
+    if (element) {
+        if (SvgJournal* journal = CommandManager::instance()->journal()) {
+            journal->recordRemove(*doc, element);
+        }
+        adapter->unbind(m_item);
+        m_svgElement = doc->takeElement(element, &m_elementSlot);
+        qCDebug(removeShapeCommandLog) << "Removed element from document";
     } else {
-        qCWarning(removeShapeCommandLog) << "Item not found in document's graphics items list";
+        qCWarning(removeShapeCommandLog) << "Item has no element in the document";
     }
 
     m_canvasArea->scene()->removeItem(m_item);
@@ -83,12 +90,17 @@ bool RemoveShapeCommand::undo()
 
     m_canvasArea->scene()->addItem(m_item);
 
-    // Restore document model consistency - avoid duplicates
-    if (std::find(doc->m_graphicsItems.begin(), doc->m_graphicsItems.end(), m_item) == doc->m_graphicsItems.end()) {
-        doc->m_graphicsItems.push_back(m_item);
-        qCDebug(removeShapeCommandLog) << "Added item back to document's graphics items list";
+    // Put the element back where it was and rebind it to the item
+    if (m_svgElement) {
+        SvgElement* element = m_svgElement.get();
+        doc->insertElement(m_elementSlot, std::move(m_svgElement));
+        m_canvasArea->sceneAdapter()->bind(m_item, element);
+        if (SvgJournal* journal = CommandManager::instance()->journal()) {
+            journal->recordInsert(*doc, element);
+        }
+        qCDebug(removeShapeCommandLog) << "Restored element in document";
     } else {
-        qCWarning(removeShapeCommandLog) << "Item already in document's graphics items list";
+        qCWarning(removeShapeCommandLog) << "No element to restore in document";
     }
 
     // Transfer ownership back to the scene
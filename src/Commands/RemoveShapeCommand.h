@@ -23,5 +23,6 @@ private:
 
     // Preserve SVG element state for complete restoration
     std::unique_ptr<SvgElement> m_svgElement;
+    SvgDocument::ElementSlot m_elementSlot;
     int m_sceneIndex; // Preserve original Z-order for accurate undo positioning
 };
@@ -55,6 +55,22 @@ void ConfigManager::setDefaultCanvasBackgroundColor(const QColor& color)
     emit settingsChanged();
 }
 
+QString ConfigManager::getRecoveryFilePath() const
+{
+    return m_settings->value("recovery/file").toString();
+}
+
+void ConfigManager::setRecoveryFilePath(const QString& filePath)
+{
+    if (filePath.isEmpty()) {
+        m_settings->remove("recovery/file");
+    } else {
+        m_settings->setValue("recovery/file", filePath);
+    }
+    // Must be on disk before the journal it points to matters, i.e. before a crash
+    m_settings->sync();
+}
+
 bool ConfigManager::hasExistingSettings() const
 {
     // Existence check prevents overwriting user customizations during startup
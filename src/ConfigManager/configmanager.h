@@ -19,6 +19,10 @@ public:
     QColor getDefaultCanvasBackgroundColor() const;
     void setDefaultCanvasBackgroundColor(const QColor& color);
     
+    // File whose edit journal should be offered for recovery at startup; empty when none
+    QString getRecoveryFilePath() const;
+    void setRecoveryFilePath(const QString& filePath);
+    
     // Check if settings exist in registry
     bool hasExistingSettings() const;
     
@@ -1,12 +1,32 @@
 ﻿#include "coresvgengine.h"
+#include "svgbinaryformat.h"
+#include "svggzip.h"
+#include "svgmappedfile.h"
+#include "svgwriter.h"
+#include <cctype>
+#include <chrono>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <QLoggingCategory>
 #include <QString>
+#include <QSaveFile>
 Q_DECLARE_LOGGING_CATEGORY(coreSvgEngineLog)
 Q_LOGGING_CATEGORY(coreSvgEngineLog, "CoreSvgEngine")
 
+// Case-insensitive; the save format follows the extension (.svgb, .svgz)
+static bool hasExtension(const std::string& filePath, std::string_view extension) {
+    if (filePath.size() < extension.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < extension.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(filePath[filePath.size() - extension.size() + i])) != extension[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
 CoreSvgEngine::CoreSvgEngine() : m_document(new SvgDocument()) {
     qCDebug(coreSvgEngineLog) << "Creating CoreSvgEngine instance with default document";
     createNewDocument(600, 800);
@@ -19,6 +39,14 @@ CoreSvgEngine::~CoreSvgEngine() {
 void CoreSvgEngine::createNewDocument(double width, double height, Color bgColor) {
     qCDebug(coreSvgEngineLog) << "Creating new document: width=" << width << ", height=" << height;
     m_document = std::make_unique<SvgDocument>(width, height, bgColor);
+    m_document->setFragmentCacheEnabled(m_fragmentCache);
+}
+
+void CoreSvgEngine::setFragmentCacheEnabled(bool enabled) {
+    m_fragmentCache = enabled;
+    if (m_document) {
+        m_document->setFragmentCacheEnabled(enabled);
+    }
 }
 
 bool CoreSvgEngine::loadSvgFile(const std::string& filePath) {
@@ -27,20 +55,42 @@ bool CoreSvgEngine::loadSvgFile(const std::string& filePath) {
     if (!m_document) {
         qCDebug(coreSvgEngineLog) << "No document instance, creating new document";
         m_document = std::make_unique<SvgDocument>();
+        m_document->setFragmentCacheEnabled(m_fragmentCache);
     } else {
         qCDebug(coreSvgEngineLog) << "Clearing elements from existing document";
         m_document->clearElements();
     }
-    std::ifstream file(filePath);
-    if (!file.is_open()) {
+    auto startTime = std::chrono::steady_clock::now();
+    // Map the file (or read it into one buffer) and let the parser view the bytes in place
+    SvgMappedFile file;
+    if (!file.open(filePath)) {
         qCWarning(coreSvgEngineLog) << "Failed to open file:" << QString::fromStdString(filePath);
         std::cerr << "Error: Could not open file " << filePath << std::endl;
         return false;
-    }    
-    std::stringstream buffer;
-    buffer << file.rdbuf();
+    }
+    m_document->setParseThreadCount(m_parseThreads);
+    // Binary and gzip-compressed documents are recognized by content, whatever the file is called
+    bool binary = svgIsBinaryContent(file.bytes());
+    bool compressed = svgIsGzipContent(file.bytes());
+    bool result = false;
+    if (binary) {
+        result = m_document->parseBinaryContent(file.bytes());
+    } else if (compressed) {
+        // Inflated a chunk at a time as the parser asks for more
+        SvgGzipDecoder decoder(file.bytes());
+        result = m_document->parseSvgStream([&decoder](char* dst, size_t capacity) {
+            return decoder.read(dst, capacity);
+        });
+        result = result && decoder.ok();
+    } else {
+        result = m_document->parseSvgContent(file.bytes());
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    qCDebug(coreSvgEngineLog) << "Loaded" << file.size() << "bytes in" << seconds * 1000.0 << "ms"
+                              << "(" << (seconds > 0.0 ? file.size() / seconds / (1024.0 * 1024.0) : 0.0) << "MiB/s,"
+                              << (file.isMapped() ? "mmap" : "buffered")
+                              << (binary ? ", binary" : compressed ? ", gzip" : "") << ")";
     file.close();
-    bool result = m_document->parseSvgContent(buffer.str());
     if (result) {
         qCDebug(coreSvgEngineLog) << "Successfully parsed SVG file content";
     } else {
@@ -55,14 +105,51 @@ bool CoreSvgEngine::saveSvgFile(const std::string& filePath) const {
         qCWarning(coreSvgEngineLog) << "No document instance, cannot save";
         return false;
     }
-    std::ofstream file(filePath);
-    if (!file.is_open()) {
-        qCWarning(coreSvgEngineLog) << "Failed to open file for writing:" << QString::fromStdString(filePath);
+    return writeSvgFile(*m_document, filePath, m_saveThreads);
+}
+
+std::unique_ptr<SvgDocument> CoreSvgEngine::snapshotDocument() const {
+    return m_document ? m_document->clone() : nullptr;
+}
+
+bool CoreSvgEngine::writeSvgFile(const SvgDocument& document, const std::string& filePath, int threads) {
+    auto startTime = std::chrono::steady_clock::now();
+    // QSaveFile writes to a temporary file; commit() syncs it to disk and renames it over the target
+    QSaveFile file(QString::fromStdString(filePath));
+    bool binary = hasExtension(filePath, ".svgb");
+    bool compressed = hasExtension(filePath, ".svgz");
+    if (!file.open(binary || compressed ? QIODevice::WriteOnly : QIODevice::WriteOnly | QIODevice::Text)) {
+        qCWarning(coreSvgEngineLog) << "Failed to open file for writing:" << QString::fromStdString(filePath) << file.errorString();
         std::cerr << "Error: Could not open file for writing " << filePath << std::endl;
         return false;
     }
-    file << m_document->generateSvgContent();
-    file.close();
-    qCDebug(coreSvgEngineLog) << "Successfully saved SVG file:" << QString::fromStdString(filePath);
+    // Each full writer buffer goes straight to the file instead of building the whole document string
+    SvgWriter::Sink fileSink = [&file](std::string_view chunk) {
+        return file.write(chunk.data(), static_cast<qint64>(chunk.size())) == static_cast<qint64>(chunk.size());
+    };
+    // For .svgz the buffers are deflated on their way to the file
+    std::unique_ptr<SvgGzipEncoder> encoder;
+    if (compressed) {
+        encoder = std::make_unique<SvgGzipEncoder>(fileSink);
+    }
+    SvgWriter writer(encoder ? SvgWriter::Sink([&encoder](std::string_view chunk) { return encoder->write(chunk); })
+                             : fileSink);
+    if (binary) {
+        document.writeBinaryContent(writer);
+    } else {
+        document.writeSvgContent(writer, threads);
+    }
+    bool written = writer.flush() && (!encoder || encoder->finish());
+    if (!written) {
+        // commit() then discards the temporary file and leaves the target untouched
+        file.cancelWriting();
+    }
+    if (!file.commit()) {
+        qCWarning(coreSvgEngineLog) << "Failed to write file:" << QString::fromStdString(filePath) << file.errorString();
+        return false;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    qCDebug(coreSvgEngineLog) << "Successfully saved SVG file:" << QString::fromStdString(filePath)
+                              << "in" << seconds * 1000.0 << "ms";
     return true;
 }
\ No newline at end of file
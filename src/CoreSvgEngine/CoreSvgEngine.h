@@ -21,6 +21,12 @@ class CORESVGENGINE_EXPORT CoreSvgEngine {
 private:
     // unique_ptr ensures automatic cleanup and prevents accidental copying
     std::unique_ptr<SvgDocument> m_document;
+    // Applied to each loaded document; see SvgDocument::setParseThreadCount
+    int m_parseThreads = 1;
+    // Passed to SvgDocument::writeSvgContent on save
+    int m_saveThreads = 1;
+    // Applied to each document; see SvgDocument::setFragmentCacheEnabled
+    bool m_fragmentCache = false;
 
 public:
     CoreSvgEngine();
@@ -33,6 +39,26 @@ public:
     SvgDocument* getCurrentDocument() const { return m_document.get(); }
     void createNewDocument(double width, double height, Color bgColor = {255,255,255,255});
 
+    // Loads SVG or, detected by content, gzip-compressed SVG (.svgz) or the
+    // native binary format (.svgb)
     bool loadSvgFile(const std::string& filePath);
+    // Opt-in: parse independent top-level groups of loaded files on this many threads (0 = all cores)
+    void setParseThreadCount(int threads) { m_parseThreads = threads; }
+    int getParseThreadCount() const { return m_parseThreads; }
+    // Opt-in: serialize large documents on this many threads when saving (0 = all cores)
+    void setSaveThreadCount(int threads) { m_saveThreads = threads; }
+    int getSaveThreadCount() const { return m_saveThreads; }
+    // Opt-in: keep serialized elements between saves, for a document that is saved repeatedly
+    void setFragmentCacheEnabled(bool enabled);
+    bool isFragmentCacheEnabled() const { return m_fragmentCache; }
     bool saveSvgFile(const std::string& filePath) const;
+
+    // Copy of the current document that another thread can save with
+    // writeSvgFile while this one keeps being edited
+    std::unique_ptr<SvgDocument> snapshotDocument() const;
+    // Writes to a temporary file next to filePath, syncs it to disk and renames
+    // it over the target, so a crash mid-save never leaves a truncated file.
+    // Safe to call from any thread for a document no other thread is touching.
+    // A path ending in .svgz selects gzip-compressed SVG, .svgb the native binary format.
+    static bool writeSvgFile(const SvgDocument& document, const std::string& filePath, int threads = 1);
 };
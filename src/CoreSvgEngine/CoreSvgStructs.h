@@ -2,8 +2,9 @@
 #include <string>
 #include <iostream>
 #include <sstream>
-#include <algorithm> // Required for std::transform
-#include <map> // Required for color name mapping
+#include <algorithm>
+#include <string_view>
+#include <vector>
 
 enum class SvgElementType {
     Line,
@@ -23,6 +24,32 @@ struct Point {
     double y = 0.0;
 };
 
+// Axis-aligned bounds in user units; transforms and stroke width are not included
+struct BoundingBox {
+    double minX = 0.0;
+    double minY = 0.0;
+    double maxX = 0.0;
+    double maxY = 0.0;
+
+    bool intersects(const BoundingBox& other) const {
+        return minX <= other.maxX && other.minX <= maxX && minY <= other.maxY && other.minY <= maxY;
+    }
+
+    static BoundingBox fromPoints(const std::vector<Point>& points) {
+        if (points.empty()) {
+            return {};
+        }
+        BoundingBox box{points[0].x, points[0].y, points[0].x, points[0].y};
+        for (const auto& p : points) {
+            box.minX = std::min(box.minX, p.x);
+            box.minY = std::min(box.minY, p.y);
+            box.maxX = std::max(box.maxX, p.x);
+            box.maxY = std::max(box.maxY, p.y);
+        }
+        return box;
+    }
+};
+
 struct Color {
     int r = 0;
     int g = 0;
@@ -39,107 +66,91 @@ struct Color {
         return ss.str();
     }
 
-    static Color fromString(const std::string& s_in) {
-        Color c;
-        std::string s = s_in;
-        // Case-insensitive comparison required for SVG color name standards
-        std::transform(s.begin(), s.end(), s.begin(), ::tolower);
-
-        // SVG 1.1 standard color names mapping
-        static const std::map<std::string, Color> colorNameToHex = {
-            {"black", {0, 0, 0, 255}}, {"silver", {192, 192, 192, 255}},
-            {"gray", {128, 128, 128, 255}}, {"white", {255, 255, 255, 255}},
-            {"maroon", {128, 0, 0, 255}}, {"red", {255, 0, 0, 255}},
-            {"purple", {128, 0, 128, 255}}, {"fuchsia", {255, 0, 255, 255}},
-            {"green", {0, 128, 0, 255}}, {"lime", {0, 255, 0, 255}},
-            {"olive", {128, 128, 0, 255}}, {"yellow", {255, 255, 0, 255}},
-            {"navy", {0, 0, 128, 255}}, {"blue", {0, 0, 255, 255}},
-            {"teal", {0, 128, 128, 255}}, {"aqua", {0, 255, 255, 255}},
-            {"transparent", {0, 0, 0, 0}}
-        };
-
-        // SVG specification: empty or "none" means transparent
-        if (s.empty() || s == "none") {
-            c.alpha = 0;
-            return c;
-        }
+    // Parses a fill/stroke value; unknown values give transparent black.
+    // Defined in SvgColorParser.cpp
+    static Color fromString(std::string_view s);
+};
 
-        auto it = colorNameToHex.find(s);
-        if (it != colorNameToHex.end()) {
-            return it->second;
-        }
+// SVG affine transform, stored as the matrix(a b c d e f) that maps
+// (x, y) to (a*x + c*y + e, b*x + d*y + f). Operations compose in SVG list
+// order: t.translate(...) then t.rotate(...) equals "translate(...) rotate(...)".
+struct Transform {
+    double a = 1.0;
+    double b = 0.0;
+    double c = 0.0;
+    double d = 1.0;
+    double e = 0.0;
+    double f = 0.0;
+    // Attribute text this transform was parsed from, written back verbatim on
+    // save as long as the matrix is unchanged; every modifier clears it
+    std::string source;
 
-        if (s.rfind("rgba", 0) == 0) {
-            double alpha_double;
-            if (sscanf(s.c_str(), "rgba(%d,%d,%d,%lf)", &c.r, &c.g, &c.b, &alpha_double) == 4) {
-                c.alpha = static_cast<int>(alpha_double * 255.0);
-            } else {
-                // Malformed rgba format - default to transparent for safety
-                c.alpha = 0; 
-            }
-        } else if (s.rfind("rgb", 0) == 0) {
-            if (sscanf(s.c_str(), "rgb(%d,%d,%d)", &c.r, &c.g, &c.b) == 3) {
-                c.alpha = 255;
-            } else {
-                c.alpha = 0;
-            }
-        } else if (s[0] == '#') {
-            // Standard hex formats: #RGB, #RGBA, #RRGGBB, #RRGGBBAA
-            if (s.length() == 7) {
-                sscanf(s.c_str(), "#%02x%02x%02x", &c.r, &c.g, &c.b);
-                c.alpha = 255;
-            } else if (s.length() == 9) {
-                 sscanf(s.c_str(), "#%02x%02x%02x%02x", &c.r, &c.g, &c.b, &c.alpha);
-            } else if (s.length() == 4) {
-                // Short hex format requires expansion (e.g., #RGB -> #RRGGBB)
-                int r_short, g_short, b_short;
-                sscanf(s.c_str(), "#%1x%1x%1x", &r_short, &g_short, &b_short);
-                c.r = r_short * 16 + r_short;
-                c.g = g_short * 16 + g_short;
-                c.b = b_short * 16 + b_short;
-                c.alpha = 255;
-            } else if (s.length() == 5) {
-                int r_short, g_short, b_short, a_short;
-                sscanf(s.c_str(), "#%1x%1x%1x%1x", &r_short, &g_short, &b_short, &a_short);
-                c.r = r_short * 16 + r_short;
-                c.g = g_short * 16 + g_short;
-                c.b = b_short * 16 + b_short;
-                c.alpha = a_short * 16 + a_short;
-            }
-             else {
-                c.alpha = 0;
-            }
-        } else {
-            // Unknown format - default to transparent for graceful degradation
-            c.r = 0; c.g = 0; c.b = 0; c.alpha = 0;
+    bool isIdentity() const {
+        return a == 1.0 && b == 0.0 && c == 0.0 && d == 1.0 && e == 0.0 && f == 0.0;
+    }
+
+    Point map(const Point& p) const {
+        return {a * p.x + c * p.y + e, b * p.x + d * p.y + f};
+    }
+
+    // Bounds of the transformed box, i.e. of its four mapped corners
+    BoundingBox mapBoundingBox(const BoundingBox& box) const {
+        if (isIdentity()) {
+            return box;
         }
-        return c;
+        return BoundingBox::fromPoints({map({box.minX, box.minY}), map({box.maxX, box.minY}),
+                                        map({box.minX, box.maxY}), map({box.maxX, box.maxY})});
+    }
+
+    // this * other: applies `other` first, then this
+    Transform operator*(const Transform& other) const {
+        Transform result;
+        result.a = a * other.a + c * other.b;
+        result.b = b * other.a + d * other.b;
+        result.c = a * other.c + c * other.d;
+        result.d = b * other.c + d * other.d;
+        result.e = a * other.e + c * other.f + e;
+        result.f = b * other.e + d * other.f + f;
+        return result;
+    }
+
+    void multiply(const Transform& other) {
+        multiply(other.a, other.b, other.c, other.d, other.e, other.f);
+    }
+
+    // multiply() by matrix(a2 b2 c2 d2 e2 f2), without building a Transform
+    void multiply(double a2, double b2, double c2, double d2, double e2, double f2) {
+        double na = a * a2 + c * b2;
+        double nb = b * a2 + d * b2;
+        double nc = a * c2 + c * d2;
+        double nd = b * c2 + d * d2;
+        e += a * e2 + c * f2;
+        f += b * e2 + d * f2;
+        a = na;
+        b = nb;
+        c = nc;
+        d = nd;
+        source.clear();
     }
-};
 
-struct Transform {
-    std::string transform_str;
-    
     void translate(double tx, double ty) {
-        std::stringstream ss;
-        ss << "translate(" << tx << "," << ty << ")";
-        if (!transform_str.empty()) {
-            transform_str += " ";
-        }
-        transform_str += ss.str();
+        multiply(1, 0, 0, 1, tx, ty);
     }
-    
-    void rotate(double angle, double cx = -1, double cy = -1) {
-        std::stringstream ss;
-        ss << "rotate(" << angle;
-        // Center point is optional for rotation
-        if (cx != -1 && cy != -1) {
-            ss << "," << cx << "," << cy;
-        }
-        ss << ")";
-        if (!transform_str.empty()) {
-            transform_str += " ";
-        }
-        transform_str += ss.str();
+
+    void scale(double sx, double sy) {
+        multiply(sx, 0, 0, sy, 0, 0);
     }
+
+    // Angle in degrees, about (cx, cy)
+    void rotate(double angle, double cx = 0, double cy = 0);
+    void skewX(double angle);
+    void skewY(double angle);
+
+    // Parses an SVG transform list, e.g. "translate(10,20) rotate(45 5 5)".
+    // The remaining members are defined in SvgTransform.cpp
+    static bool parse(std::string_view text, Transform& transform);
+    // Shortest canonical form: "" for identity, else translate/scale/rotate/matrix
+    std::string toString() const;
+    // What a save writes: the parsed source if still valid, else toString()
+    std::string toSvgString() const;
 };
@@ -0,0 +1,172 @@
+﻿#include "svgattributestore.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+// Lookups run on every save for every extra attribute, from all workers at
+// once, so they take no lock. svgInternAtom appends under the mutex and
+// publishes with release stores; names and hash tables are never moved or
+// freed while the process runs, so readers can always finish with what they loaded.
+static constexpr std::size_t ATOM_CHUNK_BITS = 10;
+static constexpr std::size_t ATOM_CHUNK_SIZE = std::size_t{1} << ATOM_CHUNK_BITS;
+static constexpr std::size_t ATOM_MAX_CHUNKS = 65536;
+static constexpr std::size_t ATOM_INITIAL_BUCKETS = 256;
+
+// Open addressing at most half full; a bucket holds (hash << 32 | atom), 0 when empty
+struct SvgAtomHashTable {
+    std::size_t mask;
+    std::unique_ptr<std::atomic<std::uint64_t>[]> buckets;
+};
+
+struct SvgAtomTable {
+    std::mutex mutex;
+    // Index 0 is SVG_NO_ATOM, which has no name
+    std::atomic<SvgAtom> count{1};
+    std::atomic<std::string*> chunks[ATOM_MAX_CHUNKS] = {};
+    std::atomic<SvgAtomHashTable*> hash{nullptr};
+    // Owners of the above; superseded hash tables stay for readers still probing them
+    std::vector<std::unique_ptr<std::string[]>> chunkStorage;
+    std::vector<std::unique_ptr<SvgAtomHashTable>> hashStorage;
+};
+
+static SvgAtomTable& atomTable() {
+    static SvgAtomTable table;
+    return table;
+}
+
+static std::uint32_t atomHash(std::string_view name) {
+    return static_cast<std::uint32_t>(std::hash<std::string_view>()(name));
+}
+
+static SvgAtom probeAtom(const SvgAtomHashTable& hash, std::string_view name, std::uint32_t key) {
+    for (std::size_t i = key & hash.mask;; i = (i + 1) & hash.mask) {
+        std::uint64_t bucket = hash.buckets[i].load(std::memory_order_acquire);
+        if (bucket == 0) {
+            return SVG_NO_ATOM;
+        }
+        SvgAtom atom = static_cast<SvgAtom>(bucket);
+        if (bucket >> 32 == key && svgAtomName(atom) == name) {
+            return atom;
+        }
+    }
+}
+
+// Called with the mutex held
+static void insertAtom(SvgAtomHashTable& hash, std::uint32_t key, SvgAtom atom) {
+    std::size_t i = key & hash.mask;
+    while (hash.buckets[i].load(std::memory_order_relaxed) != 0) {
+        i = (i + 1) & hash.mask;
+    }
+    hash.buckets[i].store(std::uint64_t{key} << 32 | atom, std::memory_order_release);
+}
+
+SvgAtom svgFindAtom(std::string_view name) {
+    const SvgAtomHashTable* hash = atomTable().hash.load(std::memory_order_acquire);
+    return hash ? probeAtom(*hash, name, atomHash(name)) : SVG_NO_ATOM;
+}
+
+SvgAtom svgInternAtom(std::string_view name) {
+    SvgAtom atom = svgFindAtom(name);
+    if (atom != SVG_NO_ATOM) {
+        return atom;
+    }
+    SvgAtomTable& table = atomTable();
+    std::lock_guard lock(table.mutex);
+    // Another thread may have added it since the lookup
+    std::uint32_t key = atomHash(name);
+    SvgAtomHashTable* current = table.hash.load(std::memory_order_relaxed);
+    if (current) {
+        atom = probeAtom(*current, name, key);
+        if (atom != SVG_NO_ATOM) {
+            return atom;
+        }
+    }
+
+    atom = table.count.load(std::memory_order_relaxed);
+    std::size_t chunk = atom >> ATOM_CHUNK_BITS;
+    if (chunk >= ATOM_MAX_CHUNKS) {
+        throw std::length_error("Too many attribute names");
+    }
+    if (!table.chunks[chunk].load(std::memory_order_relaxed)) {
+        table.chunkStorage.push_back(std::make_unique<std::string[]>(ATOM_CHUNK_SIZE));
+        table.chunks[chunk].store(table.chunkStorage.back().get(), std::memory_order_release);
+    }
+    table.chunks[chunk].load(std::memory_order_relaxed)[atom & (ATOM_CHUNK_SIZE - 1)] = std::string(name);
+    table.count.store(atom + 1, std::memory_order_release);
+
+    std::size_t buckets = current ? current->mask + 1 : 0;
+    if (2 * (static_cast<std::size_t>(atom) + 1) > buckets) {
+        // Grow into a fresh table and publish it whole; readers of the old one still find every older atom
+        auto grown = std::make_unique<SvgAtomHashTable>();
+        std::size_t size = std::max(2 * buckets, ATOM_INITIAL_BUCKETS);
+        grown->mask = size - 1;
+        grown->buckets = std::make_unique<std::atomic<std::uint64_t>[]>(size);
+        for (SvgAtom other = 1; other <= atom; ++other) {
+            insertAtom(*grown, atomHash(svgAtomName(other)), other);
+        }
+        table.hashStorage.push_back(std::move(grown));
+        table.hash.store(table.hashStorage.back().get(), std::memory_order_release);
+    } else {
+        insertAtom(*current, key, atom);
+    }
+    return atom;
+}
+
+std::string_view svgAtomName(SvgAtom atom) {
+    SvgAtomTable& table = atomTable();
+    if (atom == SVG_NO_ATOM || atom >= table.count.load(std::memory_order_acquire)) {
+        return std::string_view();
+    }
+    return table.chunks[atom >> ATOM_CHUNK_BITS].load(std::memory_order_acquire)[atom & (ATOM_CHUNK_SIZE - 1)];
+}
+
+const SvgAttributeValue* SvgAttributeStore::find(std::string_view name) const {
+    SvgAtom atom = svgFindAtom(name);
+    if (atom == SVG_NO_ATOM) {
+        return nullptr;
+    }
+    for (const auto& entry : m_entries) {
+        if (entry.atom == atom) {
+            return &entry.value;
+        }
+    }
+    return nullptr;
+}
+
+void SvgAttributeStore::set(std::string_view name, const SvgAttributeValue& value) {
+    SvgAtom atom = svgInternAtom(name);
+    for (auto& entry : m_entries) {
+        if (entry.atom == atom) {
+            entry.value = value;
+            return;
+        }
+    }
+    m_entries.push_back({atom, value});
+}
+
+bool SvgAttributeStore::remove(std::string_view name) {
+    SvgAtom atom = svgFindAtom(name);
+    if (atom == SVG_NO_ATOM) {
+        return false;
+    }
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        if (it->atom == atom) {
+            m_entries.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+std::size_t SvgAttributeStore::memoryUsage() const {
+    std::size_t bytes = m_entries.capacity() * sizeof(Entry);
+    for (const Entry& entry : m_entries) {
+        if (const std::string* text = std::get_if<std::string>(&entry.value)) {
+            bytes += svgHeapBytes(*text);
+        }
+    }
+    return bytes;
+}
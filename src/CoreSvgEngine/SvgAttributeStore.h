@@ -0,0 +1,54 @@
+﻿#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+using SvgAttributeValue = std::variant<std::string, double, int>;
+
+// Heap bytes behind a string; 0 while it fits the small-string buffer
+inline std::size_t svgHeapBytes(const std::string& text) {
+    return text.capacity() > std::string().capacity() ? text.capacity() + 1 : 0;
+}
+
+// Interned attribute name. Atoms are process-wide and never freed, so two
+// elements with a "stroke-dasharray" attribute share one copy of the name.
+using SvgAtom = std::uint32_t;
+constexpr SvgAtom SVG_NO_ATOM = 0;
+
+// Returns the atom for `name`, adding it to the table on first use; thread-safe
+SvgAtom svgInternAtom(std::string_view name);
+// Returns the atom for `name` if it was ever interned, SVG_NO_ATOM otherwise.
+// This and svgAtomName are lock-free.
+SvgAtom svgFindAtom(std::string_view name);
+std::string_view svgAtomName(SvgAtom atom);
+
+// Attributes without a dedicated SvgElement field, kept as one contiguous
+// array of (atom, value) pairs. Elements rarely carry more than a handful,
+// so a linear scan beats a tree, and an element without extra attributes
+// costs no allocation at all.
+class SvgAttributeStore {
+public:
+    struct Entry {
+        SvgAtom atom;
+        SvgAttributeValue value;
+
+        std::string_view name() const { return svgAtomName(atom); }
+    };
+
+    const SvgAttributeValue* find(std::string_view name) const;
+    void set(std::string_view name, const SvgAttributeValue& value);
+    bool remove(std::string_view name);
+
+    bool empty() const { return m_entries.empty(); }
+    std::size_t size() const { return m_entries.size(); }
+    std::vector<Entry>::const_iterator begin() const { return m_entries.begin(); }
+    std::vector<Entry>::const_iterator end() const { return m_entries.end(); }
+
+    // Heap bytes held by the entries, names excluded as atoms are shared
+    std::size_t memoryUsage() const;
+
+private:
+    std::vector<Entry> m_entries;
+};
@@ -0,0 +1,394 @@
+﻿#include "svgbinaryformat.h"
+#include "svgdocument.h"
+#include "svgshapes.h"
+#include "svgtext.h"
+#include "svgwriter.h"
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <QLoggingCategory>
+#include <QString>
+Q_DECLARE_LOGGING_CATEGORY(svgDocumentLog)
+
+// Deduplicating string table for the writer; index 0 is the empty string
+class SvgBinaryStrings {
+public:
+    uint32_t add(const std::string& text) {
+        if (text.empty()) {
+            return SVGB_NO_STRING;
+        }
+        auto [it, inserted] = m_indices.emplace(text, static_cast<uint32_t>(count()));
+        if (inserted) {
+            m_data += text;
+            m_offsets.push_back(m_data.size());
+        }
+        return it->second;
+    }
+
+    uint64_t count() const { return m_offsets.size() - 1; }
+    const std::vector<uint64_t>& offsets() const { return m_offsets; }
+    const std::string& data() const { return m_data; }
+
+private:
+    std::unordered_map<std::string, uint32_t> m_indices;
+    // String i spans [m_offsets[i], m_offsets[i + 1]) of m_data
+    std::vector<uint64_t> m_offsets = {0, 0};
+    std::string m_data;
+};
+
+static void copyColor(const Color& color, uint8_t out[4]) {
+    out[0] = static_cast<uint8_t>(color.r);
+    out[1] = static_cast<uint8_t>(color.g);
+    out[2] = static_cast<uint8_t>(color.b);
+    out[3] = static_cast<uint8_t>(color.alpha);
+}
+
+static Color readColor(const uint8_t in[4]) {
+    return {in[0], in[1], in[2], in[3]};
+}
+
+template <typename T>
+static std::string_view sectionBytes(const std::vector<T>& records) {
+    return {reinterpret_cast<const char*>(records.data()), records.size() * sizeof(T)};
+}
+
+static void appendPoints(const std::vector<Point>& points, SvgBinaryElement& record,
+                         std::vector<SvgBinaryPoint>& out) {
+    record.firstPoint = out.size();
+    record.pointCount = static_cast<uint32_t>(points.size());
+    for (const Point& point : points) {
+        out.push_back({point.x, point.y});
+    }
+}
+
+void SvgDocument::writeBinaryContent(SvgWriter& writer) const {
+    SvgBinaryStrings strings;
+    std::vector<SvgBinaryElement> elements;
+    std::vector<SvgBinaryPoint> points;
+    std::vector<SvgBinaryAttribute> attributes;
+    elements.reserve(getElementCount());
+
+    for (const auto& element : m_elements) {
+        if (!element) {
+            continue;
+        }
+        SvgBinaryElement record = {};
+        record.type = static_cast<uint8_t>(element->getType());
+        record.id = strings.add(element->m_id);
+        copyColor(element->m_strokeColor, record.stroke);
+        copyColor(element->m_fillColor, record.fill);
+        record.strokeWidth = element->m_strokeWidth;
+        record.opacity = element->m_opacity;
+        const Transform& transform = element->m_transform;
+        double matrix[6] = {transform.a, transform.b, transform.c, transform.d, transform.e, transform.f};
+        std::memcpy(record.transform, matrix, sizeof(matrix));
+        record.transformSource = strings.add(transform.source);
+
+        record.firstAttribute = attributes.size();
+        record.attributeCount = static_cast<uint32_t>(element->m_attributes.size());
+        for (const auto& entry : element->m_attributes) {
+            SvgBinaryAttribute attribute = {};
+            attribute.name = strings.add(std::string(entry.name()));
+            attribute.kind = static_cast<uint32_t>(entry.value.index());
+            if (const auto* text = std::get_if<std::string>(&entry.value)) {
+                attribute.string = strings.add(*text);
+            } else if (const auto* number = std::get_if<double>(&entry.value)) {
+                attribute.number = *number;
+            } else {
+                attribute.integer = std::get<int>(entry.value);
+            }
+            attributes.push_back(attribute);
+        }
+
+        switch (element->getType()) {
+        case SvgElementType::Line: {
+            auto* line = static_cast<const SvgLine*>(element.get());
+            double geometry[] = {line->getP1().x, line->getP1().y, line->getP2().x, line->getP2().y};
+            std::memcpy(record.geometry, geometry, sizeof(geometry));
+            break;
+        }
+        case SvgElementType::Rectangle: {
+            auto* rect = static_cast<const SvgRectangle*>(element.get());
+            double geometry[] = {rect->getTopLeft().x, rect->getTopLeft().y, rect->getWidth(),
+                                 rect->getHeight(), rect->getRx(), rect->getRy()};
+            std::memcpy(record.geometry, geometry, sizeof(geometry));
+            break;
+        }
+        case SvgElementType::Circle: {
+            auto* circle = static_cast<const SvgCircle*>(element.get());
+            double geometry[] = {circle->getCenter().x, circle->getCenter().y, circle->getRadius()};
+            std::memcpy(record.geometry, geometry, sizeof(geometry));
+            break;
+        }
+        case SvgElementType::Ellipse: {
+            auto* ellipse = static_cast<const SvgEllipse*>(element.get());
+            double geometry[] = {ellipse->getCenter().x, ellipse->getCenter().y, ellipse->getRx(), ellipse->getRy()};
+            std::memcpy(record.geometry, geometry, sizeof(geometry));
+            break;
+        }
+        case SvgElementType::Polygon:
+        case SvgElementType::Pentagon:
+        case SvgElementType::Hexagon:
+        case SvgElementType::Star:
+            appendPoints(static_cast<const SvgPolygon*>(element.get())->getPoints(), record, points);
+            break;
+        case SvgElementType::Polyline:
+            appendPoints(static_cast<const SvgPolyline*>(element.get())->getPoints(), record, points);
+            break;
+        case SvgElementType::Text: {
+            auto* text = static_cast<const SvgText*>(element.get());
+            double geometry[] = {text->getPosition().x, text->getPosition().y, text->getFontSize()};
+            std::memcpy(record.geometry, geometry, sizeof(geometry));
+            record.text = strings.add(text->getTextContent());
+            record.fontFamily = strings.add(text->getFontFamily());
+            record.flags = static_cast<uint8_t>((text->isBold() ? SVGB_TEXT_BOLD : 0) |
+                                                (text->isItalic() ? SVGB_TEXT_ITALIC : 0) |
+                                                (static_cast<int>(text->getTextAnchor()) << SVGB_TEXT_ANCHOR_SHIFT));
+            break;
+        }
+        }
+        elements.push_back(record);
+    }
+
+    SvgBinaryHeader header = {};
+    std::memcpy(header.magic, SVGB_MAGIC, sizeof(SVGB_MAGIC));
+    header.version = SVGB_VERSION;
+    header.headerSize = sizeof(SvgBinaryHeader);
+    copyColor(m_backgroundColor, header.background);
+    header.width = m_width;
+    header.height = m_height;
+    header.elementCount = elements.size();
+    header.pointCount = points.size();
+    header.attributeCount = attributes.size();
+    header.stringCount = strings.count();
+    // Every record size is a multiple of 8, so each section stays 8-byte aligned
+    header.elementsOffset = sizeof(SvgBinaryHeader);
+    header.pointsOffset = header.elementsOffset + elements.size() * sizeof(SvgBinaryElement);
+    header.attributesOffset = header.pointsOffset + points.size() * sizeof(SvgBinaryPoint);
+    header.stringOffsetsOffset = header.attributesOffset + attributes.size() * sizeof(SvgBinaryAttribute);
+    header.stringDataOffset = header.stringOffsetsOffset + strings.offsets().size() * sizeof(uint64_t);
+    header.stringDataSize = strings.data().size();
+
+    writer.write(std::string_view(reinterpret_cast<const char*>(&header), sizeof(header)));
+    writer.writeBlock(sectionBytes(elements));
+    writer.writeBlock(sectionBytes(points));
+    writer.writeBlock(sectionBytes(attributes));
+    writer.writeBlock(sectionBytes(strings.offsets()));
+    writer.writeBlock(strings.data());
+
+    qCInfo(svgDocumentLog) << "Wrote binary document:" << elements.size() << "elements," << points.size()
+                           << "points," << strings.count() << "strings";
+}
+
+// True if [offset, offset + count * size) lies within `fileSize`, without overflowing
+static bool sectionFits(uint64_t offset, uint64_t count, uint64_t size, uint64_t fileSize) {
+    return offset <= fileSize && (size == 0 || count <= (fileSize - offset) / size);
+}
+
+// String lookups over the mapped string section
+class SvgBinaryStringView {
+public:
+    SvgBinaryStringView(const char* offsets, uint64_t count, std::string_view data)
+        : m_offsets(offsets), m_count(count), m_data(data) {}
+
+    bool valid(uint32_t index) const {
+        if (index >= m_count) {
+            return false;
+        }
+        uint64_t begin = offset(index);
+        uint64_t end = offset(index + 1);
+        return begin <= end && end <= m_data.size();
+    }
+    // Callers check valid() first
+    std::string_view get(uint32_t index) const {
+        uint64_t begin = offset(index);
+        return m_data.substr(begin, offset(index + 1) - begin);
+    }
+
+private:
+    uint64_t offset(uint64_t index) const {
+        uint64_t value;
+        std::memcpy(&value, m_offsets + index * sizeof(uint64_t), sizeof(value));
+        return value;
+    }
+
+    const char* m_offsets;
+    uint64_t m_count;
+    std::string_view m_data;
+};
+
+bool SvgDocument::parseBinaryContent(std::string_view content) {
+    qCInfo(svgDocumentLog) << "Parsing binary document, content length: " + QString::fromStdString(std::to_string(content.size()));
+
+    clearElements();
+
+    if (!svgIsBinaryContent(content) || content.size() < sizeof(SvgBinaryHeader)) {
+        qCWarning(svgDocumentLog) << "Not a binary SVG document";
+        return false;
+    }
+    SvgBinaryHeader header;
+    std::memcpy(&header, content.data(), sizeof(header));
+    if (header.version == 0 || header.version > SVGB_VERSION) {
+        qCWarning(svgDocumentLog) << "Unsupported binary document version:" << header.version;
+        return false;
+    }
+    uint64_t size = content.size();
+    if (header.headerSize < sizeof(SvgBinaryHeader) || header.headerSize > size ||
+        !sectionFits(header.elementsOffset, header.elementCount, sizeof(SvgBinaryElement), size) ||
+        !sectionFits(header.pointsOffset, header.pointCount, sizeof(SvgBinaryPoint), size) ||
+        !sectionFits(header.attributesOffset, header.attributeCount, sizeof(SvgBinaryAttribute), size) ||
+        header.stringCount == 0 || header.stringCount == UINT64_MAX ||
+        !sectionFits(header.stringOffsetsOffset, header.stringCount + 1, sizeof(uint64_t), size) ||
+        !sectionFits(header.stringDataOffset, header.stringDataSize, 1, size)) {
+        qCWarning(svgDocumentLog) << "Truncated or corrupt binary document";
+        return false;
+    }
+
+    SvgBinaryStringView strings(content.data() + header.stringOffsetsOffset, header.stringCount,
+                                content.substr(header.stringDataOffset, header.stringDataSize));
+    auto string = [&](uint32_t index, std::string_view& out) {
+        if (!strings.valid(index)) {
+            return false;
+        }
+        out = strings.get(index);
+        return true;
+    };
+
+    setWidth(header.width);
+    setHeight(header.height);
+    setBackgroundColor(readColor(header.background));
+
+    SvgElementPool::Scope poolScope(m_pool.get());
+    m_elements.reserve(header.elementCount);
+    const char* elementData = content.data() + header.elementsOffset;
+    const char* pointData = content.data() + header.pointsOffset;
+    const char* attributeData = content.data() + header.attributesOffset;
+
+    for (uint64_t i = 0; i < header.elementCount; ++i) {
+        SvgBinaryElement record;
+        std::memcpy(&record, elementData + i * sizeof(SvgBinaryElement), sizeof(record));
+
+        std::vector<Point> points;
+        if (record.pointCount > 0) {
+            if (record.firstPoint > header.pointCount || record.pointCount > header.pointCount - record.firstPoint) {
+                qCWarning(svgDocumentLog) << "Binary element" << i << "has points out of range";
+                clearElements();
+                return false;
+            }
+            // Point and SvgBinaryPoint share the same x, y layout
+            points.resize(record.pointCount);
+            std::memcpy(points.data(), pointData + record.firstPoint * sizeof(SvgBinaryPoint),
+                        record.pointCount * sizeof(SvgBinaryPoint));
+        }
+        const double* g = record.geometry;
+
+        std::unique_ptr<SvgElement> element;
+        std::string_view text;
+        std::string_view fontFamily;
+        switch (static_cast<SvgElementType>(record.type)) {
+        case SvgElementType::Line:
+            element = std::make_unique<SvgLine>(Point{g[0], g[1]}, Point{g[2], g[3]});
+            break;
+        case SvgElementType::Rectangle:
+            element = std::make_unique<SvgRectangle>(Point{g[0], g[1]}, g[2], g[3], g[4], g[5]);
+            break;
+        case SvgElementType::Circle:
+            element = std::make_unique<SvgCircle>(Point{g[0], g[1]}, g[2]);
+            break;
+        case SvgElementType::Ellipse:
+            element = std::make_unique<SvgEllipse>(Point{g[0], g[1]}, g[2], g[3]);
+            break;
+        case SvgElementType::Polygon:
+            element = std::make_unique<SvgPolygon>(std::move(points));
+            break;
+        case SvgElementType::Polyline:
+            element = std::make_unique<SvgPolyline>(std::move(points));
+            break;
+        case SvgElementType::Pentagon:
+        case SvgElementType::Hexagon:
+        case SvgElementType::Star: {
+            // Keep the subtype; the stored points replace the generated ones
+            std::unique_ptr<SvgPolygon> polygon;
+            if (record.type == static_cast<uint8_t>(SvgElementType::Pentagon)) {
+                polygon = std::make_unique<SvgPentagon>();
+            } else if (record.type == static_cast<uint8_t>(SvgElementType::Hexagon)) {
+                polygon = std::make_unique<SvgHexagon>();
+            } else {
+                polygon = std::make_unique<SvgStar>();
+            }
+            polygon->setPoints(points);
+            element = std::move(polygon);
+            break;
+        }
+        case SvgElementType::Text:
+            if (!string(record.text, text) || !string(record.fontFamily, fontFamily)) {
+                break;
+            }
+            {
+                auto svgText = std::make_unique<SvgText>(Point{g[0], g[1]}, std::string(text));
+                svgText->setFontFamily(std::string(fontFamily));
+                svgText->setFontSize(g[2]);
+                svgText->setBold(record.flags & SVGB_TEXT_BOLD);
+                svgText->setItalic(record.flags & SVGB_TEXT_ITALIC);
+                int anchor = (record.flags >> SVGB_TEXT_ANCHOR_SHIFT) & 3;
+                if (anchor <= static_cast<int>(TextAnchor::End)) {
+                    svgText->setTextAnchor(static_cast<TextAnchor>(anchor));
+                    element = std::move(svgText);
+                }
+            }
+            break;
+        }
+        std::string_view id;
+        std::string_view transformSource;
+        if (!element || !string(record.id, id) || !string(record.transformSource, transformSource) ||
+            record.firstAttribute > header.attributeCount ||
+            record.attributeCount > header.attributeCount - record.firstAttribute) {
+            qCWarning(svgDocumentLog) << "Binary element" << i << "is corrupt";
+            clearElements();
+            return false;
+        }
+
+        // Direct member access: the setters' bookkeeping is for edits, not loads
+        element->m_id = id;
+        element->m_strokeColor = readColor(record.stroke);
+        element->m_fillColor = readColor(record.fill);
+        element->m_strokeWidth = record.strokeWidth;
+        element->m_opacity = record.opacity;
+        Transform& transform = element->m_transform;
+        transform.a = record.transform[0];
+        transform.b = record.transform[1];
+        transform.c = record.transform[2];
+        transform.d = record.transform[3];
+        transform.e = record.transform[4];
+        transform.f = record.transform[5];
+        transform.source = transformSource;
+
+        for (uint32_t a = 0; a < record.attributeCount; ++a) {
+            SvgBinaryAttribute attribute;
+            std::memcpy(&attribute, attributeData + (record.firstAttribute + a) * sizeof(SvgBinaryAttribute),
+                        sizeof(attribute));
+            std::string_view name;
+            std::string_view value;
+            if (!string(attribute.name, name) || name.empty() || attribute.kind > 2 ||
+                (attribute.kind == 0 && !string(attribute.string, value))) {
+                qCWarning(svgDocumentLog) << "Binary element" << i << "has a corrupt attribute";
+                clearElements();
+                return false;
+            }
+            if (attribute.kind == 0) {
+                element->m_attributes.set(name, std::string(value));
+            } else if (attribute.kind == 1) {
+                element->m_attributes.set(name, attribute.number);
+            } else {
+                element->m_attributes.set(name, attribute.integer);
+            }
+        }
+
+        m_elements.push_back(std::move(element));
+        indexElement(m_elements.size() - 1);
+    }
+
+    qCInfo(svgDocumentLog) << "Binary document parsed successfully with " + QString::fromStdString(std::to_string(m_elements.size())) + " elements";
+    return true;
+}
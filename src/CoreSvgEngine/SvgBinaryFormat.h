@@ -0,0 +1,97 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Layout of the native binary document format (.svgb). It holds exactly what
+// SvgDocument holds, so SVG -> .svgb -> SVG reproduces the SVG writer's output
+// byte for byte.
+//
+// The file is a fixed header followed by flat sections of fixed-size records,
+// each starting 8-byte aligned: elements, points, extra attributes, string
+// offsets and string bytes. Loading maps the file and builds elements straight
+// from the records; there is no text to tokenize or numbers to parse. All
+// fields are little-endian, matching every supported target.
+//
+// Readers reject versions newer than their own. A change that only appends
+// fields to the header keeps the version and grows headerSize; anything else
+// bumps SVGB_VERSION.
+
+constexpr char SVGB_MAGIC[4] = {'S', 'V', 'G', 'B'};
+constexpr uint32_t SVGB_VERSION = 1;
+// String index 0 is always the empty string, used for absent values
+constexpr uint32_t SVGB_NO_STRING = 0;
+
+struct SvgBinaryHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t headerSize;
+    uint8_t background[4];       // r, g, b, alpha
+    double width;
+    double height;
+    uint64_t elementCount;
+    uint64_t pointCount;
+    uint64_t attributeCount;
+    uint64_t stringCount;
+    // Byte offsets from the start of the file
+    uint64_t elementsOffset;
+    uint64_t pointsOffset;
+    uint64_t attributesOffset;
+    uint64_t stringOffsetsOffset;  // stringCount + 1 offsets into the string bytes
+    uint64_t stringDataOffset;
+    uint64_t stringDataSize;
+};
+
+enum SvgBinaryElementFlags : uint8_t {
+    SVGB_TEXT_BOLD = 1 << 0,
+    SVGB_TEXT_ITALIC = 1 << 1,
+    // TextAnchor value in bits 2-3
+    SVGB_TEXT_ANCHOR_SHIFT = 2,
+};
+
+struct SvgBinaryElement {
+    uint8_t type;                // SvgElementType
+    uint8_t flags;               // SvgBinaryElementFlags, text only
+    uint16_t reserved;
+    uint32_t id;                 // string index
+    uint8_t stroke[4];
+    uint8_t fill[4];
+    double strokeWidth;
+    double opacity;
+    double transform[6];         // a, b, c, d, e, f
+    uint32_t transformSource;    // string index of the original attribute text
+    uint32_t attributeCount;
+    uint64_t firstAttribute;
+    uint64_t firstPoint;         // polygons, polylines and the shapes derived from them
+    uint32_t pointCount;
+    uint32_t text;               // string index, text only
+    uint32_t fontFamily;         // string index, text only
+    uint32_t reserved2;
+    // line: x1 y1 x2 y2; rect: x y width height rx ry; circle: cx cy r;
+    // ellipse: cx cy rx ry; text: x y font-size
+    double geometry[6];
+};
+
+// Coordinates of all elements as one contiguous x, y array
+struct SvgBinaryPoint {
+    double x;
+    double y;
+};
+
+struct SvgBinaryAttribute {
+    uint32_t name;               // string index
+    uint32_t kind;               // index of the SvgAttributeValue alternative
+    double number;
+    uint32_t string;             // string index
+    int32_t integer;
+};
+
+static_assert(sizeof(SvgBinaryHeader) == 112, "SvgBinaryHeader layout changed");
+static_assert(sizeof(SvgBinaryElement) == 168, "SvgBinaryElement layout changed");
+static_assert(sizeof(SvgBinaryPoint) == 16, "SvgBinaryPoint layout changed");
+static_assert(sizeof(SvgBinaryAttribute) == 24, "SvgBinaryAttribute layout changed");
+
+// True if `content` starts like a .svgb file rather than XML
+inline bool svgIsBinaryContent(std::string_view content) {
+    return content.size() >= sizeof(SVGB_MAGIC) && content.substr(0, sizeof(SVGB_MAGIC)) == std::string_view(SVGB_MAGIC, sizeof(SVGB_MAGIC));
+}
@@ -0,0 +1,16 @@
+﻿#pragma once
+#include "coresvgstructs.h"
+#include <string_view>
+
+// Paint color parsing for fill and stroke values. Nothing is copied or
+// allocated: keywords are matched case-insensitively in place through a
+// compile-time perfect hash, and numeric forms are parsed by hand.
+
+// Looks up one of the 147 SVG/CSS color keywords, rebeccapurple or transparent
+bool lookupSvgColorKeyword(std::string_view name, Color& color);
+
+// Parses a keyword, #RGB, #RGBA, #RRGGBB, #RRGGBBAA, or rgb()/rgba() with
+// integer, fractional or percentage channels and an optional alpha given as a
+// number in [0, 1] or a percentage. Surrounding whitespace is ignored.
+// "none" and the empty string are transparent. Returns false for anything else.
+bool parseSvgColor(std::string_view text, Color& color);
@@ -2,116 +2,796 @@
 #include "svgelement.h"
 #include "svgshapes.h"
 #include "svgtext.h"
+#include "svgnumberparser.h"
+#include "svgparallel.h"
+#include "svgwriter.h"
+#include "svgtrace.h"
 #include <iostream>
 #include <sstream>
 #include <algorithm>
+#include <atomic>
 #include <tinyxml2.h>
 // #include "../LoggingService/LoggingService.h"
 #include <memory>
 #include <QLoggingCategory>
 #include <QString>
-#include <QPen>
-#include <QBrush>
-#include <QFont>
-#include <QColor>
-#include <QPointF>
-#include <QPolygonF>
-#include <QPainterPath>
-#include <QGraphicsLineItem>
-#include <QGraphicsRectItem>
-#include <QGraphicsEllipseItem>
-#include <QGraphicsPolygonItem>
-#include <QGraphicsPathItem>
-#include <QGraphicsSimpleTextItem>
 Q_DECLARE_LOGGING_CATEGORY(svgDocumentLog)
 Q_LOGGING_CATEGORY(svgDocumentLog, "SvgDocument")
 
+// Unlike geometry, where "10px" reads as 10, an extra attribute is only
+// stored as a number when nothing else follows, so "4 2" stays text
+static bool isWholeNumber(std::string_view text, double& value) {
+    auto isSpace = [](char ch) { return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r'; };
+    size_t pos = 0;
+    while (pos < text.size() && isSpace(text[pos])) ++pos;
+    if (!parseSvgNumber(text, pos, value)) {
+        return false;
+    }
+    while (pos < text.size() && isSpace(text[pos])) ++pos;
+    return pos == text.size();
+}
+
+// Byte ranges of the root's children, scanning from `pos` (just past the root's
+// start tag) to its end tag. Only tags, comments, CDATA, processing
+// instructions and quoted attribute values are told apart, which is far
+// cheaper than tokenizing; whoever parses the ranges reports malformed markup.
+static bool findTopLevelChildren(std::string_view content, size_t pos, std::vector<std::pair<size_t, size_t>>& children) {
+    int depth = 0;
+    size_t childBegin = 0;
+    while (true) {
+        pos = content.find('<', pos);
+        if (pos == std::string_view::npos) {
+            return false;
+        }
+        std::string_view rest = content.substr(pos);
+        size_t close = 0;
+        if (rest.starts_with("<!--")) {
+            close = content.find("-->", pos + 4);
+            if (close == std::string_view::npos) return false;
+            pos = close + 3;
+            continue;
+        }
+        if (rest.starts_with("<![CDATA[")) {
+            close = content.find("]]>", pos + 9);
+            if (close == std::string_view::npos) return false;
+            pos = close + 3;
+            continue;
+        }
+        if (rest.starts_with("<?")) {
+            close = content.find("?>", pos + 2);
+            if (close == std::string_view::npos) return false;
+            pos = close + 2;
+            continue;
+        }
+        if (rest.starts_with("<!")) {
+            close = content.find('>', pos + 2);
+            if (close == std::string_view::npos) return false;
+            pos = close + 1;
+            continue;
+        }
+
+        // Start or end tag; '>' may appear inside quoted attribute values
+        char quote = 0;
+        for (close = pos + 1; close < content.size(); ++close) {
+            char c = content[close];
+            if (quote) {
+                if (c == quote) quote = 0;
+            } else if (c == '"' || c == '\'') {
+                quote = c;
+            } else if (c == '>') {
+                break;
+            }
+        }
+        if (close == content.size()) {
+            return false;
+        }
+        if (rest.size() > 1 && rest[1] == '/') {
+            if (depth == 0) {
+                // The root's end tag
+                return true;
+            }
+            if (--depth == 0) {
+                children.push_back({childBegin, close + 1});
+            }
+        } else if (content[close - 1] != '/') {
+            if (depth++ == 0) {
+                childBegin = pos;
+            }
+        } else if (depth == 0) {
+            children.push_back({pos, close + 1});
+        }
+        pos = close + 1;
+    }
+}
+
+// Adapts a tinyxml2 element to the node view the parse handlers consume
+static SvgXmlNode makeXmlNode(const tinyxml2::XMLElement* element) {
+    SvgXmlNode node;
+    node.name = element->Name();
+    for (const tinyxml2::XMLAttribute* attr = element->FirstAttribute(); attr; attr = attr->Next()) {
+        node.attributes.push_back({attr->Name(), attr->Value()});
+    }
+    const char* text = element->GetText();
+    if (text) {
+        node.text = text;
+    }
+    return node;
+}
+
 SvgDocument::~SvgDocument() {
-    qCDebug(svgDocumentLog) << "Destroying SVG document with" << m_elements.size() << "elements";
+    qCDebug(svgDocumentLog) << "Destroying SVG document with" << getElementCount() << "elements";
+}
+
+std::unique_ptr<SvgDocument> SvgDocument::clone() const {
+    auto copy = std::make_unique<SvgDocument>(m_width, m_height, m_backgroundColor);
+    copy->m_parseThreads = m_parseThreads;
+    copy->m_fragmentCacheEnabled = m_fragmentCacheEnabled;
+    copy->m_tombstones = m_tombstones;
+    copy->m_layoutVersion = m_layoutVersion;
+
+    SvgElementPool::Scope poolScope(copy->m_pool.get());
+    copy->m_elements.reserve(m_elements.size());
+    if (m_fragmentCacheEnabled) {
+        copy->m_fragments.resize(m_elements.size());
+    }
+    for (size_t i = 0; i < m_elements.size(); ++i) {
+        const SvgElement* element = m_elements[i].get();
+        if (!element) {
+            copy->m_elements.emplace_back();
+            continue;
+        }
+        copy->m_elements.push_back(element->clone());
+        copy->indexElement(i);
+        // Clones keep the generation, so a valid entry stays valid for the copy
+        if (m_fragmentCacheEnabled && i < m_fragments.size()) {
+            const CachedFragment& fragment = m_fragments[i];
+            if (fragment.element == element && fragment.generation == element->getGeneration()) {
+                copy->m_fragments[i] = {copy->m_elements[i].get(), fragment.generation, fragment.text};
+            }
+        }
+    }
+    return copy;
 }
 
 void SvgDocument::addElement(std::unique_ptr<SvgElement> element) {
     if (element) {
-        qCInfo(svgDocumentLog) << "Adding new element to document, type: " +
-            QString::fromStdString(std::to_string(static_cast<int>(element->getType()))) +
-            QString::fromStdString(element->getID().empty() ? "" : ", ID: " + element->getID());
+        SVG_TRACE(SVG_TRACE_ELEMENT, "Document {} add {} type {}", this, element.get(), element->getType());
         m_elements.push_back(std::move(element));
+        indexElement(m_elements.size() - 1);
     }
 }
 
+void SvgDocument::indexElement(size_t position) {
+    m_elements[position]->m_documentPosition = position;
+    const std::string& id = m_elements[position]->getID();
+    if (!id.empty()) {
+        m_idIndex.emplace(id, position);
+    }
+}
+
+size_t SvgDocument::findElementPosition(const SvgElement* element) const {
+    // The stored position only counts if it points back at the element, which
+    // rules out elements of other documents and ones already removed
+    size_t position = element->m_documentPosition;
+    if (position < m_elements.size() && m_elements[position].get() == element) {
+        return position;
+    }
+    return m_elements.size();
+}
+
+void SvgDocument::unindexId(size_t position) {
+    auto range = m_idIndex.equal_range(m_elements[position]->getID());
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == position) {
+            m_idIndex.erase(it);
+            break;
+        }
+    }
+}
+
+void SvgDocument::unindexElement(size_t position) {
+    unindexId(position);
+    bindViewItem(m_elements[position].get(), nullptr);
+    if (position < m_fragments.size()) {
+        m_fragments[position] = CachedFragment();
+    }
+}
+
+std::unique_ptr<SvgElement> SvgDocument::eraseElementAt(size_t position) {
+    unindexElement(position);
+    std::unique_ptr<SvgElement> element = std::move(m_elements[position]);
+    ++m_tombstones;
+
+    // Trailing tombstones cost nothing to drop, which keeps undo of the last add clean
+    while (!m_elements.empty() && !m_elements.back()) {
+        m_elements.pop_back();
+        --m_tombstones;
+    }
+    return element;
+}
+
+void SvgDocument::compactIfSparse() {
+    // Compaction is linear, so only do it once tombstones outnumber live elements
+    static constexpr size_t MIN_TOMBSTONES_TO_COMPACT = 64;
+    if (m_tombstones >= MIN_TOMBSTONES_TO_COMPACT && m_tombstones * 2 > m_elements.size()) {
+        compactElements();
+    }
+}
+
+void SvgDocument::compactElements() {
+    if (m_tombstones == 0) {
+        return;
+    }
+    qCDebug(svgDocumentLog) << "Compacting" << m_tombstones << "removed elements";
+    if (m_fragments.size() == m_elements.size()) {
+        // Keep cached fragments lined up with their elements
+        size_t kept = 0;
+        for (size_t i = 0; i < m_elements.size(); ++i) {
+            if (m_elements[i]) {
+                m_fragments[kept++] = std::move(m_fragments[i]);
+            }
+        }
+        m_fragments.resize(kept);
+    } else {
+        m_fragments.clear();
+    }
+    m_elements.erase(std::remove(m_elements.begin(), m_elements.end(), nullptr), m_elements.end());
+    m_tombstones = 0;
+    ++m_layoutVersion;
+    ++m_compactions;
+    m_idIndex.clear();
+    for (size_t i = 0; i < m_elements.size(); ++i) {
+        indexElement(i);
+    }
+}
+
+SvgElement* SvgDocument::findElementById(const std::string& id) {
+    return const_cast<SvgElement*>(static_cast<const SvgDocument*>(this)->findElementById(id));
+}
+
+const SvgElement* SvgDocument::findElementById(const std::string& id) const {
+    auto it = m_idIndex.find(id);
+    if (it == m_idIndex.end()) {
+        return nullptr;
+    }
+    return m_elements[it->second].get();
+}
+
+void SvgDocument::setElementId(SvgElement* element, const std::string& id) {
+    size_t position = findElementPosition(element);
+    if (position == m_elements.size()) {
+        element->setID(id);
+        return;
+    }
+    unindexId(position);
+    element->setID(id);
+    indexElement(position);
+}
+
 bool SvgDocument::removeElementById(const std::string& id) {
-    qCInfo(svgDocumentLog) << "Removing element by ID: " + QString::fromStdString(id);
-    auto it = std::remove_if(m_elements.begin(), m_elements.end(),
-                             [&id](const std::unique_ptr<SvgElement>& elem){ return elem && elem->getID() == id; });
-    if (it != m_elements.end()) {
-        int removedCount = std::distance(it, m_elements.end());
-        m_elements.erase(it, m_elements.end());
-        qCInfo(svgDocumentLog) << "Successfully removed " + QString::fromStdString(std::to_string(removedCount)) + " element(s) with ID: " + QString::fromStdString(id);
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Document {} remove by id, {} bytes", this, id.size());
+    auto range = m_idIndex.equal_range(id);
+    std::vector<size_t> positions;
+    for (auto it = range.first; it != range.second; ++it) {
+        positions.push_back(it->second);
+    }
+    if (!positions.empty()) {
+        // Highest position first, so trimming trailing tombstones cannot move the others
+        std::sort(positions.rbegin(), positions.rend());
+        for (size_t position : positions) {
+            eraseElementAt(position);
+        }
+        compactIfSparse();
+        SVG_TRACE(SVG_TRACE_ELEMENT, "Document {} removed {} element(s) by id", this, positions.size());
         return true;
     }
-    qCInfo(svgDocumentLog) << "No element found with ID: " + QString::fromStdString(id);
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Document {} remove by id: no match", this);
     return false;
 }
 
 bool SvgDocument::removeElement(const SvgElement* element_ptr) {
     if (element_ptr) {
-        qCInfo(svgDocumentLog) << "Removing element by pointer, type: " + QString::fromStdString(std::to_string(static_cast<int>(element_ptr->getType()))) +
-            (element_ptr->getID().empty() ? "" : ", ID: " + QString::fromStdString(element_ptr->getID()));
+        SVG_TRACE(SVG_TRACE_ELEMENT, "Document {} remove {} type {}", this, element_ptr, element_ptr->getType());
     } else {
         qCWarning(svgDocumentLog) << "Attempt to remove null element pointer";
         return false;
     }
 
-    auto it = std::find_if(m_elements.begin(), m_elements.end(),
-                           [element_ptr](const std::unique_ptr<SvgElement>& elem){ return elem.get() == element_ptr; });
-    if (it != m_elements.end()) {
-        m_elements.erase(it);
-        qCInfo(svgDocumentLog) << "Element successfully removed";
+    size_t position = findElementPosition(element_ptr);
+    if (position < m_elements.size()) {
+        eraseElementAt(position);
+        compactIfSparse();
+        SVG_TRACE(SVG_TRACE_ELEMENT, "Document {} removed element at {}", this, position);
         return true;
     }
     qCWarning(svgDocumentLog) << "Element not found in document";
     return false;
 }
 
+std::unique_ptr<SvgElement> SvgDocument::takeElement(const SvgElement* element, ElementSlot* slot) {
+    size_t found = element ? findElementPosition(element) : m_elements.size();
+    if (found == m_elements.size()) {
+        qCWarning(svgDocumentLog) << "Cannot take element: not found in document";
+        return nullptr;
+    }
+    if (slot) {
+        slot->position = found;
+        slot->layoutVersion = m_layoutVersion;
+        slot->next = nullptr;
+        for (size_t i = found + 1; i < m_elements.size(); ++i) {
+            if (m_elements[i]) {
+                slot->next = m_elements[i].get();
+                break;
+            }
+        }
+    }
+    // No compaction here, so the slot's position stays a tombstone to refill
+    return eraseElementAt(found);
+}
+
+std::vector<std::unique_ptr<SvgElement>> SvgDocument::takeAllElements() {
+    clearViewItems();
+    std::vector<std::unique_ptr<SvgElement>> elements;
+    elements.reserve(getElementCount());
+    for (auto& element : m_elements) {
+        if (element) {
+            elements.push_back(std::move(element));
+        }
+    }
+    m_elements.clear();
+    m_idIndex.clear();
+    m_fragments.clear();
+    m_tombstones = 0;
+    return elements;
+}
+
+void SvgDocument::insertElement(const ElementSlot& slot, std::unique_ptr<SvgElement> element) {
+    if (!element) {
+        return;
+    }
+    size_t position = slot.position;
+    if (slot.layoutVersion != m_layoutVersion) {
+        // Positions have moved since the element was taken; go in front of its old successor
+        position = slot.next ? findElementPosition(slot.next) : m_elements.size();
+    }
+    insertElementAt(position, std::move(element));
+}
+
+void SvgDocument::insertElementAt(size_t position, std::unique_ptr<SvgElement> element) {
+    if (!element) {
+        return;
+    }
+    if (position >= m_elements.size()) {
+        // Was last, or the tombstones behind it have been trimmed
+        addElement(std::move(element));
+        return;
+    }
+    if (!m_elements[position]) {
+        // The tombstone left by takeElement is still there
+        m_elements[position] = std::move(element);
+        --m_tombstones;
+        indexElement(position);
+        return;
+    }
+
+    // Linear, but only needed once positions have moved since the element was taken
+    qCDebug(svgDocumentLog) << "Inserting element at" << position << "of" << m_elements.size();
+    m_elements.insert(m_elements.begin() + static_cast<std::ptrdiff_t>(position), std::move(element));
+    if (m_fragments.size() + 1 == m_elements.size()) {
+        m_fragments.insert(m_fragments.begin() + static_cast<std::ptrdiff_t>(position), CachedFragment());
+    } else {
+        m_fragments.clear();
+    }
+    ++m_layoutVersion;
+    m_idIndex.clear();
+    for (size_t i = 0; i < m_elements.size(); ++i) {
+        if (m_elements[i]) {
+            indexElement(i);
+        }
+    }
+}
+
+void SvgDocument::replaceElementAt(size_t position, std::unique_ptr<SvgElement> element) {
+    if (!element || position >= m_elements.size() || !m_elements[position]) {
+        qCWarning(svgDocumentLog) << "Cannot replace element: no element at" << position;
+        return;
+    }
+    unindexElement(position);
+    m_elements[position] = std::move(element);
+    indexElement(position);
+}
+
+size_t SvgDocument::getMemoryUsage() const {
+    // Hash containers: one node per entry plus the bucket array
+    constexpr size_t NODE_OVERHEAD = 2 * sizeof(void*);
+    size_t bytes = sizeof(*this) + m_elements.capacity() * sizeof(m_elements[0]);
+    for (const auto& element : m_elements) {
+        if (element) {
+            bytes += element->getMemoryUsage();
+        }
+    }
+    bytes += m_idIndex.bucket_count() * sizeof(void*);
+    for (const auto& entry : m_idIndex) {
+        bytes += sizeof(entry) + NODE_OVERHEAD + svgHeapBytes(entry.first);
+    }
+    bytes += m_viewIndex.bucket_count() * sizeof(void*) +
+             m_viewIndex.size() * (sizeof(std::pair<const void*, SvgElement*>) + NODE_OVERHEAD);
+    bytes += m_fragments.capacity() * sizeof(CachedFragment);
+    for (const CachedFragment& fragment : m_fragments) {
+        if (fragment.text) {
+            // The string and its reference count share one allocation
+            bytes += sizeof(std::string) + NODE_OVERHEAD + svgHeapBytes(*fragment.text);
+        }
+    }
+    return bytes;
+}
+
+void SvgDocument::bindViewItem(SvgElement* element, const void* item) {
+    if (!element) {
+        return;
+    }
+    if (element->m_viewItem) {
+        m_viewIndex.erase(element->m_viewItem);
+    }
+    element->m_viewItem = item;
+    if (item) {
+        m_viewIndex[item] = element;
+    }
+}
+
+SvgElement* SvgDocument::findElementByViewItem(const void* item) const {
+    auto it = m_viewIndex.find(item);
+    return it != m_viewIndex.end() ? it->second : nullptr;
+}
+
+void SvgDocument::clearViewItems() {
+    for (const auto& entry : m_viewIndex) {
+        entry.second->m_viewItem = nullptr;
+    }
+    m_viewIndex.clear();
+}
+
 void SvgDocument::clearElements() {
-    qCInfo(svgDocumentLog) << "Clearing all elements from document, count: " + QString::fromStdString(std::to_string(m_elements.size()));
+    qCInfo(svgDocumentLog) << "Clearing all elements from document, count: " + QString::fromStdString(std::to_string(getElementCount()));
     m_elements.clear();
+    m_idIndex.clear();
+    m_viewIndex.clear();
+    m_fragments.clear();
+    m_tombstones = 0;
+    // Returns the pool's chunks in one step unless taken elements still use them
+    m_pool = SvgElementPool::create();
+}
 
-    for (auto* item : m_graphicsItems) {
-        if (item && item->scene() == nullptr) {
-            delete item;
+std::string SvgDocument::generateSvgContent(int threads) const {
+    SvgWriter writer;
+    writeSvgContent(writer, threads);
+    return writer.takeString();
+}
+
+void SvgDocument::setFragmentCacheEnabled(bool enabled) {
+    m_fragmentCacheEnabled = enabled;
+    if (!enabled) {
+        m_fragments.clear();
+        m_fragments.shrink_to_fit();
+    }
+}
+
+SvgDocument::FragmentCache SvgDocument::takeFragmentCache() {
+    return std::move(m_fragments);
+}
+
+void SvgDocument::adoptFragmentCache(FragmentCache cache) {
+    if (!m_fragmentCacheEnabled) {
+        return;
+    }
+    m_fragments.resize(m_elements.size());
+    size_t adopted = 0;
+    for (size_t i = 0; i < std::min(cache.size(), m_elements.size()); ++i) {
+        const SvgElement* element = m_elements[i].get();
+        CachedFragment& current = m_fragments[i];
+        if (!element || !cache[i].text || cache[i].generation != element->getGeneration() ||
+            (current.element == element && current.generation == cache[i].generation)) {
+            continue;
         }
+        current = {element, cache[i].generation, std::move(cache[i].text)};
+        ++adopted;
     }
-    m_graphicsItems.clear();
+    qCDebug(svgDocumentLog) << "Adopted" << adopted << "cached fragments";
 }
 
-std::string SvgDocument::generateSvgContent() const {
-    qCInfo(svgDocumentLog) << "Generating SVG content for document with " + QString::fromStdString(std::to_string(m_elements.size())) + " elements";
-    std::stringstream ss;
-    ss << "<svg width=\"" << m_width << "\" height=\"" << m_height << "\" xmlns=\"http://www.w3.org/2000/svg\">\n";
+size_t SvgDocument::writeElementRange(SvgWriter& writer, size_t begin, size_t end) const {
+    size_t hits = 0;
+    for (size_t i = begin; i < end; ++i) {
+        const SvgElement* elem = m_elements[i].get();
+        if (!elem) {
+            continue;
+        }
+        if (!m_fragmentCacheEnabled) {
+            writer.write("  ");
+            elem->writeSvg(writer);
+            writer.write('\n');
+            continue;
+        }
+        // Checking the pointer as well catches slots whose element was replaced
+        CachedFragment& fragment = m_fragments[i];
+        if (fragment.element != elem || fragment.generation != elem->getGeneration() || !fragment.text) {
+            SvgWriter fragmentWriter;
+            fragmentWriter.write("  ");
+            elem->writeSvg(fragmentWriter);
+            fragmentWriter.write('\n');
+            fragment.element = elem;
+            fragment.generation = elem->getGeneration();
+            fragment.text = std::make_shared<const std::string>(fragmentWriter.takeString());
+        } else {
+            ++hits;
+        }
+        writer.write(*fragment.text);
+    }
+    return hits;
+}
+
+void SvgDocument::writeSvgContent(SvgWriter& writer, int threads) const {
+    qCInfo(svgDocumentLog) << "Generating SVG content for document with " + QString::fromStdString(std::to_string(getElementCount())) + " elements";
+    writer.write("<svg");
+    writer.writeAttribute("width", m_width);
+    writer.writeAttribute("height", m_height);
+    writer.write(" xmlns=\"http://www.w3.org/2000/svg\">\n");
 
     if (m_backgroundColor.alpha > 0 &&
         !(m_backgroundColor.r == 255 && m_backgroundColor.g == 255 &&
           m_backgroundColor.b == 255 && m_backgroundColor.alpha == 255)) {
-         ss << "  <rect width=\"100%\" height=\"100%\" fill=\"" << m_backgroundColor.toString() << "\" />\n";
+        writer.write("  <rect width=\"100%\" height=\"100%\"");
+        writer.writeAttribute("fill", m_backgroundColor);
+        writer.write(" />\n");
     }
 
-    for (const auto& elem : m_elements) {
-        if (elem) {
-            ss << "  " << elem->toSvgString() << "\n";
+    size_t count = m_elements.size();
+    if (m_fragmentCacheEnabled) {
+        // Elements appended since the last write get empty slots; positions that
+        // no longer match their element simply miss
+        m_fragments.resize(count);
+    }
+    size_t hits = 0;
+    int workers = threads == 1 ? 1 : svgResolveThreadCount(threads);
+    if (workers <= 1 || count < PARALLEL_WRITE_MIN_ELEMENTS) {
+        hits = writeElementRange(writer, 0, count);
+    } else {
+        // Contiguous ranges are rendered into separate buffers, then appended in
+        // order. Working in waves of a few chunks per thread bounds the memory
+        // held at once to a fraction of the document.
+        size_t chunkCount = (count + PARALLEL_WRITE_CHUNK_ELEMENTS - 1) / PARALLEL_WRITE_CHUNK_ELEMENTS;
+        size_t waveSize = static_cast<size_t>(workers) * 2;
+        std::vector<std::string> buffers(std::min(chunkCount, waveSize));
+        std::atomic<size_t> parallelHits{0};
+        for (size_t waveStart = 0; waveStart < chunkCount; waveStart += waveSize) {
+            size_t waveChunks = std::min(waveSize, chunkCount - waveStart);
+            // Chunks cover disjoint positions, so each touches only its own cache slots
+            svgParallelFor(waveChunks, workers, [&](size_t i) {
+                size_t begin = (waveStart + i) * PARALLEL_WRITE_CHUNK_ELEMENTS;
+                size_t end = std::min(begin + PARALLEL_WRITE_CHUNK_ELEMENTS, count);
+                SvgWriter chunkWriter;
+                parallelHits.fetch_add(writeElementRange(chunkWriter, begin, end), std::memory_order_relaxed);
+                buffers[i] = chunkWriter.takeString();
+            });
+            for (size_t i = 0; i < waveChunks; ++i) {
+                writer.writeBlock(buffers[i]);
+            }
         }
+        hits = parallelHits.load();
+    }
+    writer.write("</svg>");
+    if (m_fragmentCacheEnabled) {
+        size_t elements = getElementCount();
+        qCInfo(svgDocumentLog) << "Fragment cache:" << hits << "of" << elements << "elements reused ("
+                               << (elements > 0 ? 100.0 * hits / elements : 0.0) << "% hit rate)";
     }
-    ss << "</svg>";
-    return ss.str();
 }
 
-bool SvgDocument::parseSvgContent(const std::string& content) {
+bool SvgDocument::parseSvgContent(std::string_view content) {
     qCInfo(svgDocumentLog) << "Parsing SVG content, content length: " + QString::fromStdString(std::to_string(content.length()));
 
     clearElements();
 
+    if (m_parseThreads != 1) {
+        if (parseSvgContentParallel(content)) {
+            qCInfo(svgDocumentLog) << "SVG content parsed successfully with " + QString::fromStdString(std::to_string(m_elements.size())) + " elements";
+            return true;
+        }
+        // Retry serially so malformed input gets the same diagnostics and DOM fallback
+        clearElements();
+    }
+
+    SvgXmlReader reader(content);
+    if (parseSvgTokens(reader)) {
+        qCInfo(svgDocumentLog) << "SVG content parsed successfully with " + QString::fromStdString(std::to_string(m_elements.size())) + " elements";
+        return true;
+    }
+
+    // The in-memory buffer is still available, so give tinyxml2 a chance at input the reader rejects
+    qCWarning(svgDocumentLog) << "Streaming parse failed, falling back to DOM parser: " + QString::fromStdString(reader.errorString());
+    clearElements();
+    if (!parseSvgContentDom(content)) {
+        return false;
+    }
+    qCInfo(svgDocumentLog) << "SVG content parsed successfully with " + QString::fromStdString(std::to_string(m_elements.size())) + " elements";
+    return true;
+}
+
+bool SvgDocument::parseSvgStream(const SvgByteSource& source) {
+    qCInfo(svgDocumentLog) << "Parsing SVG content from stream";
+
+    clearElements();
+
+    SvgXmlReader reader(source);
+    if (!parseSvgTokens(reader)) {
+        qCWarning(svgDocumentLog) << "Failed to parse SVG stream: " + QString::fromStdString(reader.errorString());
+        return false;
+    }
+    qCInfo(svgDocumentLog) << "SVG stream parsed successfully with " + QString::fromStdString(std::to_string(m_elements.size())) + " elements, " + QString::fromStdString(std::to_string(reader.offset())) + " bytes";
+    return true;
+}
+
+bool SvgDocument::parseSvgTokens(SvgXmlReader& reader) {
+    // Prolog, comments and DOCTYPE are consumed by the reader, so the first element is the root
+    SvgXmlReader::Token token = reader.next();
+    while (token == SvgXmlReader::Token::Text) {
+        token = reader.next();
+    }
+    if (token != SvgXmlReader::Token::StartElement || reader.node().name != "svg") {
+        qCWarning(svgDocumentLog) << "Failed to find <svg> root element";
+        return false;
+    }
+    parseRootAttributes(reader.node());
+    return parseSvgBody(reader, false);
+}
+
+bool SvgDocument::parseSvgBody(SvgXmlReader& reader, bool fragment) {
+    // Children of the root sit at depth 2; in a fragment slice they are top level
+    const int childDepth = fragment ? 1 : 2;
+    bool firstChild = !fragment;
+    SvgElementPool::Scope poolScope(m_pool.get());
+    while (true) {
+        SvgXmlReader::Token token = reader.next();
+        if (token == SvgXmlReader::Token::Error) {
+            return false;
+        }
+        if (token == SvgXmlReader::Token::EndOfDocument) {
+            // The reader reports unclosed elements as errors, so a fragment ends cleanly here
+            return fragment;
+        }
+        if (token == SvgXmlReader::Token::EndElement) {
+            if (!fragment && reader.depth() == 0) {
+                return true;
+            }
+            continue;
+        }
+        if (token != SvgXmlReader::Token::StartElement) {
+            continue;
+        }
+
+        const SvgXmlNode& node = reader.node();
+        bool isFirstChild = firstChild && reader.depth() == childDepth;
+        firstChild = false;
+
+        // Full-size first rect is the document background, not a content element
+        if (isFirstChild && isBackgroundRect(node)) {
+            setBackgroundColor(Color::fromString(node.attribute("fill")));
+            if (!reader.skipElement()) return false;
+            continue;
+        }
+
+        if (node.name == "g") {
+            // Descend: the group's children arrive as the following tokens
+            continue;
+        }
+
+        if (node.name == "text") {
+            // Text content follows the start tag, so keep the attributes alive while reading it
+            SvgXmlNode textNode = node;
+            textNode.detach();
+            std::string content = reader.readElementText();
+            if (!reader.errorString().empty()) return false;
+            textNode.text = content;
+            parseSvgText(textNode);
+            continue;
+        }
+
+        parseSvgElement(node);
+        // Children of shapes and of unsupported containers (defs, symbol, ...) are not rendered
+        if (!reader.skipElement()) return false;
+    }
+}
+
+bool SvgDocument::parseSvgContentParallel(std::string_view content) {
+    // Byte range of one or more top-level children of the root
+    struct Segment {
+        size_t begin;
+        size_t end;
+        bool group;
+    };
+    std::vector<Segment> segments;
+    size_t groupCount = 0;
+
+    SvgXmlReader reader(content);
+    SvgXmlReader::Token token = reader.next();
+    while (token == SvgXmlReader::Token::Text) {
+        token = reader.next();
+    }
+    if (token != SvgXmlReader::Token::StartElement || reader.node().name != "svg") {
+        return false;
+    }
+    parseRootAttributes(reader.node());
+
+    // Serial pre-scan: only find where each top-level child starts and ends,
+    // leaving the tokenizing to the workers
+    std::vector<std::pair<size_t, size_t>> children;
+    if (!findTopLevelChildren(content, reader.offset(), children)) {
+        return false;
+    }
+
+    bool firstChild = true;
+    for (const auto& [begin, end] : children) {
+        std::string_view child = content.substr(begin, end - begin);
+        if (firstChild) {
+            firstChild = false;
+            SvgXmlReader childReader(child);
+            if (childReader.next() == SvgXmlReader::Token::StartElement && isBackgroundRect(childReader.node())) {
+                setBackgroundColor(Color::fromString(childReader.node().attribute("fill")));
+                continue;
+            }
+        }
+
+        bool group = child.substr(1, child.find_first_of(" \t\r\n/>", 1) - 1) == "g";
+        if (!group && !segments.empty() && !segments.back().group) {
+            // Runs of plain siblings are cheap, so they share one segment
+            segments.back().end = end;
+        } else {
+            segments.push_back({begin, end, group});
+            if (group) ++groupCount;
+        }
+    }
+
+    // Each segment is parsed into its own scratch document, so workers share no state
+    std::vector<std::unique_ptr<SvgDocument>> parts(segments.size());
+    std::vector<char> succeeded(segments.size(), 0);
+    int threads = groupCount > 1 ? m_parseThreads : 1;
+    svgParallelFor(segments.size(), threads, [&](size_t i) {
+        auto part = std::make_unique<SvgDocument>(m_width, m_height, m_backgroundColor);
+        SvgXmlReader segmentReader(content.substr(segments[i].begin, segments[i].end - segments[i].begin));
+        succeeded[i] = part->parseSvgBody(segmentReader, true);
+        parts[i] = std::move(part);
+    });
+
+    bool ok = std::all_of(succeeded.begin(), succeeded.end(), [](char value) { return value != 0; });
+    size_t total = 0;
+    for (const auto& part : parts) {
+        total += part->m_elements.size();
+    }
+    if (!ok) {
+        for (auto& part : parts) {
+            part->clearElements();
+        }
+        return false;
+    }
+
+    // Splice in segment order so the result does not depend on scheduling
+    m_elements.reserve(m_elements.size() + total);
+    for (auto& part : parts) {
+        for (auto& element : part->m_elements) {
+            m_elements.push_back(std::move(element));
+            indexElement(m_elements.size() - 1);
+        }
+        part->clearElements();
+    }
+    qCInfo(svgDocumentLog) << "Parsed" << segments.size() << "segments (" << groupCount << "groups ) on"
+                           << svgResolveThreadCount(threads) << "threads";
+    return true;
+}
+
+bool SvgDocument::parseSvgContentDom(std::string_view content) {
+    SvgElementPool::Scope poolScope(m_pool.get());
     tinyxml2::XMLDocument doc;
-    if (doc.Parse(content.c_str(), content.size()) != tinyxml2::XML_SUCCESS) {
+    if (doc.Parse(content.data(), content.size()) != tinyxml2::XML_SUCCESS) {
         qCWarning(svgDocumentLog) << "Failed to parse SVG content: " + QString::fromStdString(std::string(doc.ErrorStr()));
         return false;
     }
@@ -122,247 +802,175 @@ bool SvgDocument::parseSvgContent(const std::string& content) {
         return false;
     }
 
-    const char* widthStr = svgRootElement->Attribute("width");
-    if (widthStr) {
-        std::string width(widthStr);
-        if (width.find("px") != std::string::npos) width = width.substr(0, width.find("px"));
-        try { setWidth(std::stod(width)); } catch (const std::exception& e) {
-            qCWarning(svgDocumentLog) << "Failed to parse SVG width: " + QString::fromStdString(std::string(e.what()));
+    parseRootAttributes(makeXmlNode(svgRootElement));
+
+    tinyxml2::XMLElement* childElementToParse = svgRootElement->FirstChildElement();
+
+    // Detect if first rect element represents document background
+    if (childElementToParse) {
+        SvgXmlNode firstNode = makeXmlNode(childElementToParse);
+        if (isBackgroundRect(firstNode)) {
+            setBackgroundColor(Color::fromString(firstNode.attribute("fill")));
+            childElementToParse = childElementToParse->NextSiblingElement();
         }
     }
 
-    const char* heightStr = svgRootElement->Attribute("height");
-    if (heightStr) {
-        std::string height(heightStr);
-        if (height.find("px") != std::string::npos) height = height.substr(0, height.find("px"));
-        try { setHeight(std::stod(height)); } catch (const std::exception& e) {
-            qCWarning(svgDocumentLog) << "Failed to parse SVG height: " + QString::fromStdString(std::string(e.what()));
+    parseChildElements(childElementToParse);
+    return true;
+}
+
+void SvgDocument::parseRootAttributes(const SvgXmlNode& root) {
+    // Unit suffixes such as "px" are ignored; only the leading number is used
+    double width = 0;
+    if (root.hasAttribute("width")) {
+        if (root.queryDouble("width", width)) {
+            setWidth(width);
+        } else {
+            qCWarning(svgDocumentLog) << "Failed to parse SVG width: " + QString::fromStdString(std::string(root.attribute("width")));
         }
     }
 
-    tinyxml2::XMLElement* childElementToParse = svgRootElement->FirstChildElement();
+    double height = 0;
+    if (root.hasAttribute("height")) {
+        if (root.queryDouble("height", height)) {
+            setHeight(height);
+        } else {
+            qCWarning(svgDocumentLog) << "Failed to parse SVG height: " + QString::fromStdString(std::string(root.attribute("height")));
+        }
+    }
+}
 
-    // Detect if first rect element represents document background
+bool SvgDocument::isBackgroundRect(const SvgXmlNode& node) const {
     // This heuristic identifies background rects by checking for full-size dimensions
-    if (childElementToParse && strcmp(childElementToParse->Name(), "rect") == 0) {
-        const char* rectWidthAttr = childElementToParse->Attribute("width");
-        const char* rectHeightAttr = childElementToParse->Attribute("height");
-        const char* rectFillAttr = childElementToParse->Attribute("fill");
-
-        if (rectWidthAttr && rectHeightAttr && rectFillAttr) {
-            std::string widthVal(rectWidthAttr);
-            std::string heightVal(rectHeightAttr);
-            bool isFullWidth = (widthVal == "100%");
-            // Fallback to numeric comparison for absolute values
-            if (!isFullWidth) try { isFullWidth = (std::stod(widthVal) >= m_width); } catch (...) {}
-
-            bool isFullHeight = (heightVal == "100%");
-            if (!isFullHeight) try { isFullHeight = (std::stod(heightVal) >= m_height); } catch (...) {}
-
-            // Full-size rect is treated as background, not content element
-            if (isFullWidth && isFullHeight) {
-                setBackgroundColor(Color::fromString(rectFillAttr));
-                childElementToParse = childElementToParse->NextSiblingElement();
-            }
-        }
+    if (node.name != "rect" || !node.hasAttribute("width") || !node.hasAttribute("height") || !node.hasAttribute("fill")) {
+        return false;
     }
 
-    parseChildElements(childElementToParse);
+    double value = 0;
+    bool isFullWidth = (node.attribute("width") == "100%");
+    // Fallback to numeric comparison for absolute values
+    if (!isFullWidth && node.queryDouble("width", value)) isFullWidth = (value >= m_width);
 
-    qCInfo(svgDocumentLog) << "SVG content parsed successfully with " + QString::fromStdString(std::to_string(m_elements.size())) + " elements";
-    return true;
+    bool isFullHeight = (node.attribute("height") == "100%");
+    if (!isFullHeight && node.queryDouble("height", value)) isFullHeight = (value >= m_height);
+
+    return isFullWidth && isFullHeight;
 }
 
 void SvgDocument::setWidth(double w) {
-    qCInfo(svgDocumentLog) << "Setting document width: " + QString::fromStdString(std::to_string(m_width)) + " to " + QString::fromStdString(std::to_string(w > 0 ? w : 1));
+    SVG_TRACE(SVG_TRACE_DOCUMENT, "Document {} width {} -> {}", this, m_width, w > 0 ? w : 1.0);
     m_width = (w > 0 ? w : 1);
 }
 
 void SvgDocument::setHeight(double h) {
-    qCInfo(svgDocumentLog) << "Setting document height: " + QString::fromStdString(std::to_string(m_height)) + " to " + QString::fromStdString(std::to_string(h > 0 ? h : 1));
+    SVG_TRACE(SVG_TRACE_DOCUMENT, "Document {} height {} -> {}", this, m_height, h > 0 ? h : 1.0);
     m_height = (h > 0 ? h : 1);
 }
 
 void SvgDocument::setBackgroundColor(const Color& color) {
-    qCInfo(svgDocumentLog) << "Setting document background color: " + QString::fromStdString(m_backgroundColor.toString()) + " to " + QString::fromStdString(color.toString());
+    SVG_TRACE(SVG_TRACE_DOCUMENT, "Document {} background {} -> {}", this, m_backgroundColor, color);
     m_backgroundColor = color;
 }
 
 void SvgDocument::parseChildElements(tinyxml2::XMLElement* element) {
     while (element) {
-        std::string elementName = element->Name();
-
-        if (elementName == "line") {
-            parseSvgLine(element);
-        } else if (elementName == "rect") {
-            parseSvgRectangle(element);
-        } else if (elementName == "circle") {
-            parseSvgCircle(element);
-        } else if (elementName == "ellipse") {
-            parseSvgEllipse(element);
-        } else if (elementName == "polygon") {
-            parseSvgPolygon(element);
-        } else if (elementName == "polyline") {
-            parseSvgPolyline(element);
-        } else if (elementName == "text") {
-            parseSvgText(element);
-        } else if (elementName == "g") {
+        if (strcmp(element->Name(), "g") == 0) {
             parseChildElements(element->FirstChildElement());
+        } else {
+            parseSvgElement(makeXmlNode(element));
         }
 
         element = element->NextSiblingElement();
     }
 }
 
-void SvgDocument::setGraphicsItemFlags(QGraphicsItem* item) {
-    if (item) {
-        // Set the item to be selectable
-        item->setFlag(QGraphicsItem::ItemIsSelectable, true);
-        // Also make it movable when selected
-        item->setFlag(QGraphicsItem::ItemIsMovable, true);
+bool SvgDocument::parseSvgElement(const SvgXmlNode& node) {
+    const std::string_view& elementName = node.name;
+
+    if (elementName == "line") {
+        parseSvgLine(node);
+    } else if (elementName == "rect") {
+        parseSvgRectangle(node);
+    } else if (elementName == "circle") {
+        parseSvgCircle(node);
+    } else if (elementName == "ellipse") {
+        parseSvgEllipse(node);
+    } else if (elementName == "polygon") {
+        parseSvgPolygon(node);
+    } else if (elementName == "polyline") {
+        parseSvgPolyline(node);
+    } else if (elementName == "text") {
+        parseSvgText(node);
+    } else {
+        return false;
     }
+    return true;
 }
 
-void SvgDocument::parseSvgLine(tinyxml2::XMLElement* element) {
+void SvgDocument::parseSvgLine(const SvgXmlNode& node) {
     double x1 = 0, y1 = 0, x2 = 0, y2 = 0;
-    element->QueryDoubleAttribute("x1", &x1);
-    element->QueryDoubleAttribute("y1", &y1);
-    element->QueryDoubleAttribute("x2", &x2);
-    element->QueryDoubleAttribute("y2", &y2);
+    node.queryDouble("x1", x1);
+    node.queryDouble("y1", y1);
+    node.queryDouble("x2", x2);
+    node.queryDouble("y2", y2);
 
     auto line = std::make_unique<SvgLine>(Point{x1, y1}, Point{x2, y2});
-    parseCommonAttributes(element, line.get());
-
-    auto graphicsItem = new QGraphicsLineItem(x1, y1, x2, y2);
-
-    QPen pen;
-    pen.setWidth(line->getStrokeWidth());
-    Color strokeColor = line->getStrokeColor();
-    pen.setColor(QColor(strokeColor.r, strokeColor.g, strokeColor.b, strokeColor.alpha));
-    graphicsItem->setPen(pen);
-    graphicsItem->setOpacity(line->getOpacity());
-
-    setGraphicsItemFlags(graphicsItem);
+    parseCommonAttributes(node, line.get());
 
-    // Store graphics item for Qt rendering system
-    m_graphicsItems.push_back(graphicsItem);
     addElement(std::move(line));
 }
 
-void SvgDocument::parseSvgRectangle(tinyxml2::XMLElement* element) {
+void SvgDocument::parseSvgRectangle(const SvgXmlNode& node) {
     double x = 0, y = 0, width = 0, height = 0, rx = 0, ry = 0;
-    element->QueryDoubleAttribute("x", &x);
-    element->QueryDoubleAttribute("y", &y);
-    element->QueryDoubleAttribute("width", &width);
-    element->QueryDoubleAttribute("height", &height);
-    element->QueryDoubleAttribute("rx", &rx);
-    element->QueryDoubleAttribute("ry", &ry);
+    node.queryDouble("x", x);
+    node.queryDouble("y", y);
+    node.queryDouble("width", width);
+    node.queryDouble("height", height);
+    node.queryDouble("rx", rx);
+    node.queryDouble("ry", ry);
 
     auto rect = std::make_unique<SvgRectangle>(Point{x, y}, width, height, rx, ry);
-    parseCommonAttributes(element, rect.get());
-
-    auto graphicsItem = new QGraphicsRectItem(x, y, width, height);
-
-    QPen pen;
-    pen.setWidth(rect->getStrokeWidth());
-    Color strokeColor = rect->getStrokeColor();
-    pen.setColor(QColor(strokeColor.r, strokeColor.g, strokeColor.b, strokeColor.alpha));
-    graphicsItem->setPen(pen);
-
-    Color fillColor = rect->getFillColor();
-    graphicsItem->setBrush(QBrush(QColor(fillColor.r, fillColor.g, fillColor.b, fillColor.alpha)));
-
-    graphicsItem->setOpacity(rect->getOpacity());
+    parseCommonAttributes(node, rect.get());
 
-    // Set the item flags
-    setGraphicsItemFlags(graphicsItem);
-
-    m_graphicsItems.push_back(graphicsItem);
     addElement(std::move(rect));
 }
 
-void SvgDocument::parseSvgCircle(tinyxml2::XMLElement* element) {
+void SvgDocument::parseSvgCircle(const SvgXmlNode& node) {
     double cx = 0, cy = 0, r = 0;
-    element->QueryDoubleAttribute("cx", &cx);
-    element->QueryDoubleAttribute("cy", &cy);
-    element->QueryDoubleAttribute("r", &r);
+    node.queryDouble("cx", cx);
+    node.queryDouble("cy", cy);
+    node.queryDouble("r", r);
 
     auto circle = std::make_unique<SvgCircle>(Point{cx, cy}, r);
-    parseCommonAttributes(element, circle.get());
-
-    auto graphicsItem = new QGraphicsEllipseItem(cx-r, cy-r, 2*r, 2*r);
-
-    QPen pen;
-    pen.setWidth(circle->getStrokeWidth());
-    Color strokeColor = circle->getStrokeColor();
-    pen.setColor(QColor(strokeColor.r, strokeColor.g, strokeColor.b, strokeColor.alpha));
-    graphicsItem->setPen(pen);
-
-    Color fillColor = circle->getFillColor();
-    graphicsItem->setBrush(QBrush(QColor(fillColor.r, fillColor.g, fillColor.b, fillColor.alpha)));
-
-    graphicsItem->setOpacity(circle->getOpacity());
+    parseCommonAttributes(node, circle.get());
 
-    // Set the item flags
-    setGraphicsItemFlags(graphicsItem);
-
-    m_graphicsItems.push_back(graphicsItem);
     addElement(std::move(circle));
 }
 
-void SvgDocument::parseSvgEllipse(tinyxml2::XMLElement* element) {
+void SvgDocument::parseSvgEllipse(const SvgXmlNode& node) {
     double cx = 0, cy = 0, rx = 0, ry = 0;
-    element->QueryDoubleAttribute("cx", &cx);
-    element->QueryDoubleAttribute("cy", &cy);
-    element->QueryDoubleAttribute("rx", &rx);
-    element->QueryDoubleAttribute("ry", &ry);
+    node.queryDouble("cx", cx);
+    node.queryDouble("cy", cy);
+    node.queryDouble("rx", rx);
+    node.queryDouble("ry", ry);
 
     auto ellipse = std::make_unique<SvgEllipse>(Point{cx, cy}, rx, ry);
-    parseCommonAttributes(element, ellipse.get());
-
-    auto graphicsItem = new QGraphicsEllipseItem(cx-rx, cy-ry, 2*rx, 2*ry);
-
-    QPen pen;
-    pen.setWidth(ellipse->getStrokeWidth());
-    Color strokeColor = ellipse->getStrokeColor();
-    pen.setColor(QColor(strokeColor.r, strokeColor.g, strokeColor.b, strokeColor.alpha));
-    graphicsItem->setPen(pen);
-
-    Color fillColor = ellipse->getFillColor();
-    graphicsItem->setBrush(QBrush(QColor(fillColor.r, fillColor.g, fillColor.b, fillColor.alpha)));
+    parseCommonAttributes(node, ellipse.get());
 
-    graphicsItem->setOpacity(ellipse->getOpacity());
-
-    // Set the item flags
-    setGraphicsItemFlags(graphicsItem);
-
-    m_graphicsItems.push_back(graphicsItem);
     addElement(std::move(ellipse));
 }
 
-void SvgDocument::parseSvgPolygon(tinyxml2::XMLElement* element) {
-    const char* pointsStr = element->Attribute("points");
-    if (!pointsStr) {
+void SvgDocument::parseSvgPolygon(const SvgXmlNode& node) {
+    const SvgXmlAttribute* pointsAttr = node.findAttribute("points");
+    if (!pointsAttr) {
         qCWarning(svgDocumentLog) << "Polygon element missing 'points' attribute";
         return;
     }
 
     std::vector<Point> points;
-    std::istringstream pointStream(pointsStr);
-    std::string pointPair;
-
-    while (std::getline(pointStream, pointPair, ' ')) {
-        if (pointPair.empty()) continue;
-        size_t commaPos = pointPair.find(',');
-        if (commaPos != std::string::npos) {
-            try {
-                double x = std::stod(pointPair.substr(0, commaPos));
-                double y = std::stod(pointPair.substr(commaPos + 1));
-                points.push_back({x, y});
-            } catch (const std::exception& e) {
-                qCWarning(svgDocumentLog) << "Failed to parse polygon point: " + QString::fromStdString(std::string(e.what()));
-            }
-        }
+    size_t errorOffset = 0;
+    if (!parseSvgPointList(pointsAttr->value, points, &errorOffset)) {
+        qCWarning(svgDocumentLog) << "Malformed polygon points at offset" << errorOffset << ", keeping" << points.size() << "points";
     }
 
     if (points.size() < 3) {
@@ -370,56 +978,23 @@ void SvgDocument::parseSvgPolygon(tinyxml2::XMLElement* element) {
         return;
     }
 
-    auto polygon = std::make_unique<SvgPolygon>(points);
-    parseCommonAttributes(element, polygon.get());
-
-    QPolygonF qPolygon;
-    for (const auto& point : points) {
-        qPolygon << QPointF(point.x, point.y);
-    }
-
-    auto graphicsItem = new QGraphicsPolygonItem(qPolygon);
-
-    QPen pen;
-    pen.setWidth(polygon->getStrokeWidth());
-    Color strokeColor = polygon->getStrokeColor();
-    pen.setColor(QColor(strokeColor.r, strokeColor.g, strokeColor.b, strokeColor.alpha));
-    graphicsItem->setPen(pen);
-    Color fillColor = polygon->getFillColor();
-    graphicsItem->setBrush(QBrush(QColor(fillColor.r, fillColor.g, fillColor.b, fillColor.alpha)));
-
-    graphicsItem->setOpacity(polygon->getOpacity());
+    auto polygon = std::make_unique<SvgPolygon>(std::move(points));
+    parseCommonAttributes(node, polygon.get());
 
-    // Set the item flags
-    setGraphicsItemFlags(graphicsItem);
-
-    m_graphicsItems.push_back(graphicsItem);
     addElement(std::move(polygon));
 }
 
-void SvgDocument::parseSvgPolyline(tinyxml2::XMLElement* element) {
-    const char* pointsStr = element->Attribute("points");
-    if (!pointsStr) {
+void SvgDocument::parseSvgPolyline(const SvgXmlNode& node) {
+    const SvgXmlAttribute* pointsAttr = node.findAttribute("points");
+    if (!pointsAttr) {
         qCWarning(svgDocumentLog) << "Polyline element missing 'points' attribute";
         return;
     }
 
     std::vector<Point> points;
-    std::istringstream pointStream(pointsStr);
-    std::string pointPair;
-
-    while (std::getline(pointStream, pointPair, ' ')) {
-        if (pointPair.empty()) continue;
-        size_t commaPos = pointPair.find(',');
-        if (commaPos != std::string::npos) {
-            try {
-                double x = std::stod(pointPair.substr(0, commaPos));
-                double y = std::stod(pointPair.substr(commaPos + 1));
-                points.push_back({x, y});
-            } catch (const std::exception& e) {
-                qCWarning(svgDocumentLog) << "Failed to parse polyline point: " + QString::fromStdString(std::string(e.what()));
-            }
-        }
+    size_t errorOffset = 0;
+    if (!parseSvgPointList(pointsAttr->value, points, &errorOffset)) {
+        qCWarning(svgDocumentLog) << "Malformed polyline points at offset" << errorOffset << ", keeping" << points.size() << "points";
     }
 
     if (points.size() < 2) {
@@ -427,136 +1002,75 @@ void SvgDocument::parseSvgPolyline(tinyxml2::XMLElement* element) {
         return;
     }
 
-    auto polyline = std::make_unique<SvgPolyline>(points);
-    parseCommonAttributes(element, polyline.get());
-
-    QPainterPath path;
-
-    if (!points.empty()) {
-        path.moveTo(points[0].x, points[0].y);
-
-        for (size_t i = 1; i < points.size(); ++i) {
-            path.lineTo(points[i].x, points[i].y);
-        }
-    }
-
-    auto graphicsItem = new QGraphicsPathItem(path);
+    auto polyline = std::make_unique<SvgPolyline>(std::move(points));
+    parseCommonAttributes(node, polyline.get());
 
-    QPen pen;
-    pen.setWidth(polyline->getStrokeWidth());
-    Color strokeColor = polyline->getStrokeColor();
-    pen.setColor(QColor(strokeColor.r, strokeColor.g, strokeColor.b, strokeColor.alpha));
-    graphicsItem->setPen(pen);
-
-    Color fillColor = polyline->getFillColor();
-    graphicsItem->setBrush(Qt::NoBrush);
-
-    graphicsItem->setOpacity(polyline->getOpacity());
-
-    // Set the item flags
-    setGraphicsItemFlags(graphicsItem);
-
-    m_graphicsItems.push_back(graphicsItem);
     addElement(std::move(polyline));
 }
 
-void SvgDocument::parseSvgText(tinyxml2::XMLElement* element) {
+void SvgDocument::parseSvgText(const SvgXmlNode& node) {
     double x = 0, y = 0;
-    element->QueryDoubleAttribute("x", &x);
-    element->QueryDoubleAttribute("y", &y);
+    node.queryDouble("x", x);
+    node.queryDouble("y", y);
 
-    const char* textContent = element->GetText();
-    std::string text = textContent ? textContent : "";
+    std::string text(node.text);
 
     auto textElement = std::make_unique<SvgText>(Point{x, y}, text);
 
-    const char* fontFamily = element->Attribute("font-family");
+    const SvgXmlAttribute* fontFamily = node.findAttribute("font-family");
     if (fontFamily) {
-        textElement->setFontFamily(fontFamily);
+        textElement->setFontFamily(std::string(fontFamily->value));
     }
 
     double fontSize = 12.0;
-    if (element->QueryDoubleAttribute("font-size", &fontSize) == tinyxml2::XML_SUCCESS) {
+    if (node.queryDouble("font-size", fontSize)) {
         textElement->setFontSize(fontSize);
     }
 
-    parseCommonAttributes(element, textElement.get());
-
-    auto graphicsItem = new QGraphicsSimpleTextItem(QString::fromStdString(text));
-    graphicsItem->setPos(x, y);
+    parseCommonAttributes(node, textElement.get());
 
-    QFont font;
-    if (fontFamily) {
-        font.setFamily(QString::fromStdString(textElement->getFontFamily()));
-    }
-    font.setPointSizeF(textElement->getFontSize());
-    graphicsItem->setFont(font);
-
-    // �����ı���ɫ (ʹ�����ɫ��Ϊ�ı���ɫ)
-    Color textColor = textElement->getFillColor();
-    if (textColor.alpha > 0) {
-        graphicsItem->setBrush(QBrush(QColor(textColor.r, textColor.g, textColor.b, textColor.alpha)));
-    } else {
-        Color strokeColor = textElement->getStrokeColor();
-        graphicsItem->setBrush(QBrush(QColor(strokeColor.r, strokeColor.g, strokeColor.b, strokeColor.alpha)));
-    }
-
-    QPen pen;
-    Color strokeColor = textElement->getStrokeColor();
-    if (strokeColor.alpha > 0 && textElement->getStrokeWidth() > 0) {
-        pen.setWidth(textElement->getStrokeWidth());
-        pen.setColor(QColor(strokeColor.r, strokeColor.g, strokeColor.b, strokeColor.alpha));
-        graphicsItem->setPen(pen);
-    } else {
-        graphicsItem->setPen(Qt::NoPen); // Ĭ��������
-    }
-
-    graphicsItem->setOpacity(textElement->getOpacity());
-
-    // Set the item flags
-    setGraphicsItemFlags(graphicsItem);
-
-    m_graphicsItems.push_back(graphicsItem);
     addElement(std::move(textElement));
 }
 
-void SvgDocument::parseCommonAttributes(tinyxml2::XMLElement* element, SvgElement* svgElement) {
-    const char* id = element->Attribute("id");
+void SvgDocument::parseCommonAttributes(const SvgXmlNode& node, SvgElement* svgElement) {
+    const SvgXmlAttribute* id = node.findAttribute("id");
     if (id) {
-        svgElement->setID(id);
+        svgElement->setID(std::string(id->value));
     }
 
-    const char* fill = element->Attribute("fill");
+    const SvgXmlAttribute* fill = node.findAttribute("fill");
     if (fill) {
-        svgElement->setFillColor(Color::fromString(fill));
+        svgElement->setFillColor(Color::fromString(fill->value));
     }
 
-    const char* stroke = element->Attribute("stroke");
+    const SvgXmlAttribute* stroke = node.findAttribute("stroke");
     if (stroke) {
-        svgElement->setStrokeColor(Color::fromString(stroke));
+        svgElement->setStrokeColor(Color::fromString(stroke->value));
     }
 
     double strokeWidth = 1.0;
-    if (element->QueryDoubleAttribute("stroke-width", &strokeWidth) == tinyxml2::XML_SUCCESS) {
+    if (node.queryDouble("stroke-width", strokeWidth)) {
         svgElement->setStrokeWidth(strokeWidth);
     }
 
     double opacity = 1.0;
-    if (element->QueryDoubleAttribute("opacity", &opacity) == tinyxml2::XML_SUCCESS) {
+    if (node.queryDouble("opacity", opacity)) {
         svgElement->setOpacity(opacity);
     }
 
-    const char* transform = element->Attribute("transform");
+    const SvgXmlAttribute* transform = node.findAttribute("transform");
     if (transform) {
         Transform t;
-        t.transform_str = transform;
+        if (!Transform::parse(transform->value, t)) {
+            // Keep the text so a save does not drop it, but draw untransformed
+            qCWarning(svgDocumentLog) << "Ignoring malformed transform: " + QString::fromStdString(std::string(transform->value));
+            t.source = std::string(transform->value);
+        }
         svgElement->setTransform(t);
     }
 
-    const tinyxml2::XMLAttribute* attr = element->FirstAttribute();
-    while (attr) {
-        std::string name = attr->Name();
-        std::string value = attr->Value();
+    for (const auto& attr : node.attributes) {
+        const std::string_view& name = attr.name;
 
         if (name != "id" && name != "fill" && name != "stroke" &&
             name != "stroke-width" && name != "opacity" && name != "transform" &&
@@ -565,13 +1079,12 @@ void SvgDocument::parseCommonAttributes(tinyxml2::XMLElement* element, SvgElemen
             name != "cx" && name != "cy" && name != "r" && name != "rx" && name != "ry" &&
             name != "points" && name != "font-family" && name != "font-size") {
 
-            try {
-                double numValue = std::stod(value);
-                svgElement->setAttribute(name, numValue);
-            } catch (const std::exception&) {
-                svgElement->setAttribute(name, value);
+            double numValue = 0;
+            if (isWholeNumber(attr.value, numValue)) {
+                svgElement->setAttribute(std::string(name), numValue);
+            } else {
+                svgElement->setAttribute(std::string(name), std::string(attr.value));
             }
         }
-        attr = attr->Next();
     }
 }
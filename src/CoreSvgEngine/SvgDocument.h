@@ -2,38 +2,88 @@
 #include <vector>
 #include <string>
 #include <memory>
-#include <QGraphicsItem>
-#include <QGraphicsLineItem>
-#include <QGraphicsRectItem>
-#include <QGraphicsEllipseItem>
-#include <QGraphicsPolygonItem>
-#include <QGraphicsSimpleTextItem>
+#include <unordered_map>
 #include "svgelement.h"
+#include "svgxmlreader.h"
+#include "svgelementpool.h"
 
 namespace tinyxml2 {
     class XMLElement;
 }
 
 class SvgDocument {
+public:
+    // Serialized line of one element, reused by later writes while the element's
+    // generation is unchanged
+    struct CachedFragment {
+        const SvgElement* element = nullptr;
+        uint64_t generation = 0;
+        // Shared with clones, so a snapshot copies no text
+        std::shared_ptr<const std::string> text;
+    };
+    // Indexed by position in the element list
+    using FragmentCache = std::vector<CachedFragment>;
+
 private:
+    // Parsed elements are allocated here; declared first so it outlives them
+    SvgElementPool::Handle m_pool = SvgElementPool::create();
     std::vector<std::unique_ptr<SvgElement>> m_elements;
+    // id -> position in m_elements; ids are not required to be unique
+    std::unordered_multimap<std::string, size_t> m_idIndex;
+    // Removed elements leave a null entry until the next compaction
+    size_t m_tombstones = 0;
+    // Bumped whenever elements already in the list move to another position
+    uint64_t m_layoutVersion = 0;
+    // Compactions that dropped removed entries
+    uint64_t m_compactions = 0;
+    // View object -> element; the reverse direction is SvgElement::getViewItem
+    std::unordered_map<const void*, SvgElement*> m_viewIndex;
     double m_width;
     double m_height;
     Color m_backgroundColor;
+    // Worker threads used to parse top-level groups; 1 keeps parsing serial
+    int m_parseThreads = 1;
 
-    // SVG parsing helper methods to handle different element types
+    mutable FragmentCache m_fragments;
+    bool m_fragmentCacheEnabled = false;
+
+    // Below this many elements a parallel write is not worth starting threads for
+    static constexpr size_t PARALLEL_WRITE_MIN_ELEMENTS = 8192;
+    static constexpr size_t PARALLEL_WRITE_CHUNK_ELEMENTS = 4096;
+
+    // Streaming parse driven by SvgXmlReader tokens; no DOM is built
+    bool parseSvgTokens(SvgXmlReader& reader);
+    // Element tokens below the root, or every top-level element of a fragment slice
+    bool parseSvgBody(SvgXmlReader& reader, bool fragment);
+    // Parses top-level children as independent slices on worker threads
+    bool parseSvgContentParallel(std::string_view content);
+    // tinyxml2 DOM parse, kept as a fallback for input the streaming reader rejects
+    bool parseSvgContentDom(std::string_view content);
     void parseChildElements(tinyxml2::XMLElement* parentElement);
-    void parseSvgLine(tinyxml2::XMLElement* element);
-    void parseSvgRectangle(tinyxml2::XMLElement* element);
-    void parseSvgCircle(tinyxml2::XMLElement* element);
-    void parseSvgEllipse(tinyxml2::XMLElement* element);
-    void parseSvgPolygon(tinyxml2::XMLElement* element);
-    void parseSvgPolyline(tinyxml2::XMLElement* element);
-    void parseSvgText(tinyxml2::XMLElement* element);
-    void parseCommonAttributes(tinyxml2::XMLElement* element, SvgElement* svgElement);
-
-    // Configure graphics items with consistent behavior
-    void setGraphicsItemFlags(QGraphicsItem* item);
+
+    // SVG parsing helper methods to handle different element types
+    void parseRootAttributes(const SvgXmlNode& root);
+    bool isBackgroundRect(const SvgXmlNode& node) const;
+    bool parseSvgElement(const SvgXmlNode& node);
+    void parseSvgLine(const SvgXmlNode& node);
+    void parseSvgRectangle(const SvgXmlNode& node);
+    void parseSvgCircle(const SvgXmlNode& node);
+    void parseSvgEllipse(const SvgXmlNode& node);
+    void parseSvgPolygon(const SvgXmlNode& node);
+    void parseSvgPolyline(const SvgXmlNode& node);
+    void parseSvgText(const SvgXmlNode& node);
+    void parseCommonAttributes(const SvgXmlNode& node, SvgElement* svgElement);
+
+    // Records `position` in the element and in the id index
+    void indexElement(size_t position);
+    // Drops only the id index entry of the element at `position`
+    void unindexId(size_t position);
+    // Drops the id index entry, view binding and cached fragment of the element at `position`
+    void unindexElement(size_t position);
+    // Leaves a tombstone and returns the element, unbound from its view item
+    std::unique_ptr<SvgElement> eraseElementAt(size_t position);
+    // Writes the lines for m_elements[begin, end); returns how many came from the fragment cache
+    size_t writeElementRange(SvgWriter& writer, size_t begin, size_t end) const;
 
     public:
     // Default to standard A4-like dimensions with white background
@@ -45,20 +95,104 @@ private:
     // Prevent copying to avoid element ownership conflicts
     SvgDocument(const SvgDocument&) = delete;
     SvgDocument& operator=(const SvgDocument&) = delete;
-    QVector<QGraphicsItem*> m_graphicsItems;
 
     SvgDocument(SvgDocument&&) = default;
     SvgDocument& operator=(SvgDocument&&) = default;
 
+    // Deep copy without view bindings, e.g. so a worker thread can save it while
+    // this document keeps being edited. Removed entries stay as such, so positions
+    // match this document's; valid cached fragments are shared.
+    std::unique_ptr<SvgDocument> clone() const;
+
     void addElement(std::unique_ptr<SvgElement> element);
     bool removeElementById(const std::string& id);
     bool removeElement(const SvgElement* element_ptr);
     void clearElements();
-    std::string generateSvgContent() const;
-    bool parseSvgContent(const std::string& content);
+    // Where takeElement found an element. Usable by insertElement after later
+    // edits and compactions, as long as elements go back in reverse order of taking.
+    struct ElementSlot {
+        size_t position = 0;
+        // The element that followed it, to find the place again once positions have moved
+        const SvgElement* next = nullptr;
+        uint64_t layoutVersion = 0;
+    };
+    // Detaches an element without destroying it, e.g. to restore it on undo;
+    // `slot` receives its place for insertElement. Never compacts.
+    std::unique_ptr<SvgElement> takeElement(const SvgElement* element, ElementSlot* slot = nullptr);
+    // Empties the document and hands over its elements in order, without destroying them
+    std::vector<std::unique_ptr<SvgElement>> takeAllElements();
+    // Puts an element back where takeElement found it. Refills its tombstone
+    // when positions are unchanged; after a compaction it is inserted in front
+    // of the element that followed it, which moves the elements behind it.
+    void insertElement(const ElementSlot& slot, std::unique_ptr<SvgElement> element);
+    // Puts an element at `position` of getElements(): refills a tombstone there,
+    // appends at or past the end, and otherwise moves the elements behind it
+    void insertElementAt(size_t position, std::unique_ptr<SvgElement> element);
+    // Swaps the live element at `position` for another one
+    void replaceElementAt(size_t position, std::unique_ptr<SvgElement> element);
+    // Position of `element` in getElements(), or its size if the element is not
+    // in this document. Constant time through the position stored in the element.
+    size_t findElementPosition(const SvgElement* element) const;
+    // Drops removed entries once they outnumber live elements. Removing by
+    // pointer or id does this itself; takeElement leaves it to the caller.
+    void compactIfSparse();
+    // Drops all removed entries and renumbers the rest; does nothing without any
+    void compactElements();
+    // Number of compactions so far, for callers that keep positions elsewhere
+    uint64_t getCompactionCount() const { return m_compactions; }
+    // Hash lookup; ids of elements already in the document change through
+    // setElementId so the index follows
+    SvgElement* findElementById(const std::string& id);
+    const SvgElement* findElementById(const std::string& id) const;
+    // SvgElement::setID plus the id index update when `element` is in this document
+    void setElementId(SvgElement* element, const std::string& id);
+    // Number of elements, not counting removed entries awaiting compaction
+    size_t getElementCount() const { return m_elements.size() - m_tombstones; }
+    // Estimated bytes held by the document: elements, indexes and cached fragments
+    size_t getMemoryUsage() const;
+
+    // Item <-> element mapping for the view layer. The document stays free of
+    // widget types, so view objects are opaque pointers here. Binding nullptr
+    // unbinds; removing or clearing elements drops their bindings.
+    void bindViewItem(SvgElement* element, const void* item);
+    SvgElement* findElementByViewItem(const void* item) const;
+    void clearViewItems();
+    // `threads` other than 1 serializes large documents in parallel (0 = one
+    // per core); the output is byte-identical to the serial path
+    std::string generateSvgContent(int threads = 1) const;
+    // Streams the document into `writer`; with a sink-backed writer the output
+    // never has to fit in memory at once. With the fragment cache enabled this
+    // updates the cache despite being const, so two writes of one document must
+    // not run at the same time.
+    void writeSvgContent(SvgWriter& writer, int threads = 1) const;
+    // Reuses the serialized form of unchanged elements on the next write. Off by
+    // default: it only pays off for a document written repeatedly, such as the
+    // editor's, and costs roughly one extra copy of the serialized document.
+    void setFragmentCacheEnabled(bool enabled);
+    bool isFragmentCacheEnabled() const { return m_fragmentCacheEnabled; }
+    // Hands over the cache, e.g. from a clone() written on another thread
+    FragmentCache takeFragmentCache();
+    // Keeps the entries of `cache`, taken from a clone() of this document, that
+    // are valid for the element now at their position. Generations are unique
+    // per element state, so edits and removals since the clone only cost hits.
+    void adoptFragmentCache(FragmentCache cache);
+    // Native binary form, see svgbinaryformat.h; lossless against the SVG path
+    void writeBinaryContent(SvgWriter& writer) const;
+    bool parseSvgContent(std::string_view content);
+    bool parseBinaryContent(std::string_view content);
+    // Parse straight from a chunked byte source, e.g. a file, without buffering the whole input
+    bool parseSvgStream(const SvgByteSource& source);
+
+    // Opt-in parallel parsing for in-memory content: top-level <g> subtrees are
+    // parsed on `threads` workers (0 = one per core) and spliced back in
+    // document order, so the result is identical to a serial parse
+    void setParseThreadCount(int threads) { m_parseThreads = threads; }
+    int getParseThreadCount() const { return m_parseThreads; }
 
+    // Removed elements may show up as null entries until the document compacts itself
     const std::vector<std::unique_ptr<SvgElement>>& getElements() const { return m_elements; }
-    // Non-const version for direct modification when needed
+    // Non-const version for modifying elements in place; add and remove through
+    // the methods above so the id index stays in sync
     std::vector<std::unique_ptr<SvgElement>>& getElements() { return m_elements; }
 
     double getWidth() const { return m_width; }
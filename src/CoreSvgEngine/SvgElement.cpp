@@ -1,35 +1,83 @@
 ﻿#include <string>
-#include <sstream>
 #include "svgelement.h"
-// #include "../LoggingService/LoggingService.h"
-#include <QLoggingCategory>
-#include <QString>
-Q_DECLARE_LOGGING_CATEGORY(svgElementLog)
-Q_LOGGING_CATEGORY(svgElementLog, "SvgElement")
-
-std::string SvgElement::getCommonAttributesString() const {
-    std::stringstream ss;
-    if (!getID().empty()) {
-        ss << " id=\"" << getID() << "\"";
+#include "svgwriter.h"
+#include "svgelementpool.h"
+#include "svgtrace.h"
+#include <atomic>
+
+void* SvgElement::operator new(std::size_t size) {
+    return SvgElementPool::allocateElement(size);
+}
+
+void SvgElement::operator delete(void* pointer) {
+    SvgElementPool::freeElement(pointer);
+}
+
+SvgElement::SvgElement(const SvgElement& other)
+    : m_id(other.m_id), m_strokeColor(other.m_strokeColor), m_strokeWidth(other.m_strokeWidth),
+      m_fillColor(other.m_fillColor), m_transform(other.m_transform), m_opacity(other.m_opacity),
+      m_attributes(other.m_attributes), m_generation(other.m_generation) {
+}
+
+uint64_t SvgElement::nextGeneration() {
+    // Threads take generations in blocks, so setters stay off the shared counter
+    static constexpr uint64_t BLOCK = 4096;
+    static std::atomic<uint64_t> nextBlock{1};
+    thread_local uint64_t next = 0;
+    thread_local uint64_t end = 0;
+    if (next == end) {
+        next = nextBlock.fetch_add(BLOCK, std::memory_order_relaxed);
+        end = next + BLOCK;
     }
-    ss << " stroke=\"" << getStrokeColor().toString() << "\"";
-    ss << " stroke-width=\"" << getStrokeWidth() << "\"";
+    return next++;
+}
+
+std::size_t SvgElement::getMemoryUsage() const {
+    return SvgElementPool::blockSize(this) + svgHeapBytes(m_id) + svgHeapBytes(m_transform.source) +
+           m_attributes.memoryUsage() + getOwnedMemoryUsage();
+}
+
+std::string SvgElement::toSvgString() const {
+    SvgWriter writer;
+    writeSvg(writer);
+    return writer.takeString();
+}
+
+void SvgElement::writeCommonAttributes(SvgWriter& writer, bool fillNone) const {
+    if (!m_id.empty()) {
+        writer.writeAttribute("id", m_id);
+    }
+    writer.writeAttribute("stroke", m_strokeColor);
+    writer.writeAttribute("stroke-width", m_strokeWidth);
     // SVG specification requires "none" for transparent fill
-    ss << " fill=\"" << (getFillColor().alpha == 0 ? "none" : getFillColor().toString()) << "\"";
+    if (fillNone || m_fillColor.alpha == 0) {
+        writer.writeAttribute("fill", "none");
+    } else {
+        writer.writeAttribute("fill", m_fillColor);
+    }
     // Only output opacity when different from default to minimize SVG size
-    if (getOpacity() < 1.0) {
-        ss << " opacity=\"" << getOpacity() << "\"";
+    if (m_opacity < 1.0) {
+        writer.writeAttribute("opacity", m_opacity);
     }
-    if (!getTransform().transform_str.empty()) {
-        ss << " transform=\"" << getTransform().transform_str << "\"";
+    if (!m_transform.source.empty()) {
+        writer.writeAttribute("transform", m_transform.source);
+    } else if (!m_transform.isIdentity()) {
+        writer.writeAttribute("transform", m_transform.toString());
     }
     // 可以添加其他通用属性
     for (const auto& attr : m_attributes) {
-        ss << " " << attr.first << "=\"";
-        std::visit([&ss](const auto& value){ ss << value; }, attr.second);
-        ss << "\"";
+        writer.write(' ');
+        writer.write(attr.name());
+        writer.write("=\"");
+        if (const std::string* text = std::get_if<std::string>(&attr.value)) {
+            writer.writeEscaped(*text);
+        } else if (const double* number = std::get_if<double>(&attr.value)) {
+            writer.writeNumber(*number);
+        } else {
+            writer.writeInteger(std::get<int>(attr.value));
+        }
+        writer.write('"');
     }
-    return ss.str();
 }
 
 // 默认实现为空，子类需要重写这个方法
@@ -43,8 +91,9 @@ std::string SvgElement::getID() const {
 }
 
 void SvgElement::setID(const std::string& id) {
-    qCInfo(svgElementLog) << "Setting element ID: '" + QString::fromStdString(m_id) + "' to '" + QString::fromStdString(id) + "'";
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Element {} id set, {} bytes", this, id.size());
     m_id = id;
+    markChanged();
 }
 
 Color SvgElement::getStrokeColor() const {
@@ -52,8 +101,9 @@ Color SvgElement::getStrokeColor() const {
 }
 
 void SvgElement::setStrokeColor(const Color& color) {
-    qCInfo(svgElementLog) << "Setting element stroke color: " + QString::fromStdString(m_strokeColor.toString()) + " to " + QString::fromStdString(color.toString());
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Element {} stroke {} -> {}", this, m_strokeColor, color);
     m_strokeColor = color;
+    markChanged();
 }
 
 double SvgElement::getStrokeWidth() const {
@@ -61,9 +111,10 @@ double SvgElement::getStrokeWidth() const {
 }
 
 void SvgElement::setStrokeWidth(double width) {
-    qCInfo(svgElementLog) << "Setting element stroke width: " + QString::fromStdString(std::to_string(m_strokeWidth)) + " to " + QString::fromStdString(std::to_string((width < 0) ? 0 : width));
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Element {} stroke-width {} -> {}", this, m_strokeWidth, (width < 0) ? 0.0 : width);
     // Negative stroke width is invalid in SVG specification
     m_strokeWidth = (width < 0) ? 0 : width;
+    markChanged();
 }
 
 Color SvgElement::getFillColor() const {
@@ -71,8 +122,9 @@ Color SvgElement::getFillColor() const {
 }
 
 void SvgElement::setFillColor(const Color& color) {
-    qCInfo(svgElementLog) << "Setting element fill color: " + QString::fromStdString(m_fillColor.toString()) + " to " + QString::fromStdString(color.toString());
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Element {} fill {} -> {}", this, m_fillColor, color);
     m_fillColor = color;
+    markChanged();
 }
 
 Transform SvgElement::getTransform() const {
@@ -80,11 +132,10 @@ Transform SvgElement::getTransform() const {
 }
 
 void SvgElement::setTransform(const Transform& transform) {
-    qCInfo(svgElementLog) << "Setting element transform: " + 
-        (m_transform.transform_str.empty() ? "none" : QString::fromStdString(m_transform.transform_str)) + 
-        " to " + 
-        (transform.transform_str.empty() ? "none" : QString::fromStdString(transform.transform_str));
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Element {} transform -> matrix({} {} {} {} {} {})", this,
+              transform.a, transform.b, transform.c, transform.d, transform.e, transform.f);
     m_transform = transform;
+    markChanged();
 }
 
 double SvgElement::getOpacity() const {
@@ -94,6 +145,7 @@ double SvgElement::getOpacity() const {
 void SvgElement::setOpacity(double opacity) {
     // SVG opacity must be clamped to [0.0, 1.0] range
     double newOpacity = (opacity < 0.0) ? 0.0 : (opacity > 1.0 ? 1.0 : opacity);
-    qCInfo(svgElementLog) << "Setting element opacity: " + QString::fromStdString(std::to_string(m_opacity)) + " to " + QString::fromStdString(std::to_string(newOpacity));
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Element {} opacity {} -> {}", this, m_opacity, newOpacity);
     m_opacity = newOpacity;
+    markChanged();
 }
\ No newline at end of file
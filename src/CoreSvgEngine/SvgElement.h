@@ -1,9 +1,14 @@
 ﻿#pragma once
 #include "coresvgstructs.h"
+#include "svgattributestore.h"
 #include <string>
 #include <map>
 #include <variant>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 
+class SvgWriter;
 
 class SvgElement {
 private:
@@ -13,32 +18,64 @@ private:
     Color m_fillColor = {0,0,0,0};
     Transform m_transform;
     double m_opacity = 1.0;
-    std::map<std::string, std::variant<std::string, double, int>> m_attributes;
+    SvgAttributeStore m_attributes;
+    // View object presenting this element, bound through SvgDocument::bindViewItem
+    const void* m_viewItem = nullptr;
+    // Index in the owning SvgDocument's element list, kept current by the document
+    std::size_t m_documentPosition = 0;
+    // Renewed by every setter so SvgDocument can reuse the serialized form of
+    // unchanged elements. Unique across the process, except that copies keep it.
+    uint64_t m_generation;
+
+    friend class SvgDocument;
+
+protected:
+    SvgElement() : m_generation(nextGeneration()) {}
+    // Copies share no view binding; see clone()
+    SvgElement(const SvgElement& other);
+
+    void markChanged() { m_generation = nextGeneration(); }
+    static uint64_t nextGeneration();
+    // Heap bytes held by members of the derived class, for getMemoryUsage()
+    virtual std::size_t getOwnedMemoryUsage() const { return 0; }
 
 public:
     virtual ~SvgElement() = default;
 
+    // Elements come from the SvgElementPool installed on the parsing thread, if any
+    static void* operator new(std::size_t size);
+    static void operator delete(void* pointer);
+
     virtual SvgElementType getType() const = 0;
     virtual void draw() const;
-    virtual std::string toSvgString() const = 0;
+    // Serializes the element as one SVG tag straight into `writer`
+    virtual void writeSvg(SvgWriter& writer) const = 0;
+    // Independent copy of the same type, e.g. for a document snapshot
+    virtual std::unique_ptr<SvgElement> clone() const = 0;
+    // writeSvg into a fresh string, for callers that need a single element
+    std::string toSvgString() const;
+    // Geometric extent used for spatial queries such as viewport culling
+    virtual BoundingBox getBoundingBox() const = 0;
     virtual void parseFromSvgAttributes(const std::map<std::string, std::string>& attributes) {};    
     
     std::variant<std::string, double, int> getAttribute(const std::string& name) const {
-        auto it = m_attributes.find(name);
-        if (it != m_attributes.end()) {
-            return it->second;
-        }
-        return {};
+        const SvgAttributeValue* value = m_attributes.find(name);
+        return value ? *value : SvgAttributeValue();
     }
     void setAttribute(const std::string& name, const std::variant<std::string, double, int>& value) {
-        m_attributes[name] = value;
+        m_attributes.set(name, value);
+        markChanged();
     }
-    const std::map<std::string, std::variant<std::string, double, int>>& getAllAttributes() const {
+    const SvgAttributeStore& getAllAttributes() const {
         return m_attributes;
     }
 
-    std::string getCommonAttributesString() const;
+    // id, paint, opacity, transform and extra attributes, each with a leading
+    // space; `fillNone` forces fill="none" for shapes that are never filled
+    void writeCommonAttributes(SvgWriter& writer, bool fillNone = false) const;
     std::string getID() const;
+    // For an element already in a document use SvgDocument::setElementId, which
+    // keeps the document's id index current
     void setID(const std::string& id);
 
     Color getStrokeColor() const;
@@ -55,4 +92,13 @@ public:
 
     double getOpacity() const;
     void setOpacity(double opacity);
+
+    uint64_t getGeneration() const { return m_generation; }
+
+    // Bytes this element occupies, heap-allocated members included; allocator
+    // bookkeeping outside the element pool is not counted
+    std::size_t getMemoryUsage() const;
+
+    // Opaque back-pointer to the view object (e.g. a QGraphicsItem) showing this element
+    const void* getViewItem() const { return m_viewItem; }
 };
@@ -0,0 +1,88 @@
+﻿#include "svgelementpool.h"
+#include <new>
+
+// Precedes every element block; keeps the element itself 16-byte aligned
+struct alignas(16) BlockHeader {
+    SvgElementPool* pool;  // nullptr for heap blocks
+    std::size_t sizeClass;
+};
+
+static thread_local SvgElementPool* currentPool = nullptr;
+
+SvgElementPool::Handle SvgElementPool::create() {
+    return Handle(new SvgElementPool());
+}
+
+SvgElementPool::Scope::Scope(SvgElementPool* pool) : m_previous(currentPool) {
+    currentPool = pool;
+}
+
+SvgElementPool::Scope::~Scope() {
+    currentPool = m_previous;
+}
+
+void* SvgElementPool::allocateElement(std::size_t size) {
+    std::size_t total = sizeof(BlockHeader) + size;
+    std::size_t sizeClass = (total + GRANULE - 1) / GRANULE - 1;
+    SvgElementPool* pool = currentPool;
+
+    BlockHeader* header;
+    if (pool && sizeClass < SIZE_CLASSES) {
+        header = static_cast<BlockHeader*>(pool->allocate(sizeClass));
+        pool->m_refs.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        header = static_cast<BlockHeader*>(::operator new(total));
+        pool = nullptr;
+    }
+    header->pool = pool;
+    header->sizeClass = sizeClass;
+    return header + 1;
+}
+
+void SvgElementPool::freeElement(void* pointer) {
+    if (!pointer) {
+        return;
+    }
+    BlockHeader* header = static_cast<BlockHeader*>(pointer) - 1;
+    SvgElementPool* pool = header->pool;
+    if (!pool) {
+        ::operator delete(header);
+        return;
+    }
+    pool->deallocate(header, header->sizeClass);
+    pool->unref();
+}
+
+std::size_t SvgElementPool::blockSize(const void* pointer) {
+    // Heap blocks record their size class too, so both kinds are covered
+    const BlockHeader* header = static_cast<const BlockHeader*>(pointer) - 1;
+    return (header->sizeClass + 1) * GRANULE;
+}
+
+void* SvgElementPool::allocate(std::size_t sizeClass) {
+    if (void* block = m_freeLists[sizeClass]) {
+        m_freeLists[sizeClass] = *static_cast<void**>(block);
+        return block;
+    }
+    std::size_t blockSize = (sizeClass + 1) * GRANULE;
+    if (static_cast<std::size_t>(m_end - m_cursor) < blockSize) {
+        // Not value-initialized: blocks are constructed over before use
+        m_chunks.emplace_back(new std::byte[CHUNK_SIZE]);
+        m_cursor = m_chunks.back().get();
+        m_end = m_cursor + CHUNK_SIZE;
+    }
+    void* block = m_cursor;
+    m_cursor += blockSize;
+    return block;
+}
+
+void SvgElementPool::deallocate(void* block, std::size_t sizeClass) {
+    *static_cast<void**>(block) = m_freeLists[sizeClass];
+    m_freeLists[sizeClass] = block;
+}
+
+void SvgElementPool::unref() {
+    if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete this;
+    }
+}
@@ -0,0 +1,66 @@
+﻿#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Size-class pool for SvgElement objects. SvgElement's operator new draws from
+// the pool installed on the current thread by a Scope and falls back to the
+// heap otherwise, so std::unique_ptr<SvgElement> and plain delete keep working.
+//
+// A pool is reference counted by its owner and by every live element it holds.
+// Freed elements go on a per-size free list for reuse; the chunks themselves
+// are returned in one step once the owner has released the pool and the last
+// element is gone, even if that element outlived the document (e.g. in undo).
+//
+// Only the reference count is atomic; the free lists and the chunk cursor are
+// not. A pool's elements must be allocated and freed by one thread at a time.
+// The background save keeps to this by freeing only its clone's own pool.
+class SvgElementPool {
+public:
+    // Deleter for the owning handle: drops the owner's reference
+    struct OwnerRelease {
+        void operator()(SvgElementPool* pool) const { pool->unref(); }
+    };
+    using Handle = std::unique_ptr<SvgElementPool, OwnerRelease>;
+
+    static Handle create();
+
+    // Installs a pool for element allocations on this thread until destroyed
+    class Scope {
+    public:
+        explicit Scope(SvgElementPool* pool);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        SvgElementPool* m_previous;
+    };
+
+    // Used by SvgElement's class-level operator new/delete
+    static void* allocateElement(std::size_t size);
+    static void freeElement(void* pointer);
+    // Bytes reserved for an element from allocateElement, header included
+    static std::size_t blockSize(const void* pointer);
+
+    std::size_t chunkCount() const { return m_chunks.size(); }
+
+private:
+    SvgElementPool() = default;
+    ~SvgElementPool() = default;
+
+    void* allocate(std::size_t sizeClass);
+    void deallocate(void* block, std::size_t sizeClass);
+    void unref();
+
+    static constexpr std::size_t GRANULE = 16;
+    static constexpr std::size_t SIZE_CLASSES = 32; // blocks up to 512 bytes
+    static constexpr std::size_t CHUNK_SIZE = 64 * 1024;
+
+    std::atomic<std::size_t> m_refs{1};
+    std::vector<std::unique_ptr<std::byte[]>> m_chunks;
+    std::byte* m_cursor = nullptr;
+    std::byte* m_end = nullptr;
+    void* m_freeLists[SIZE_CLASSES] = {};
+};
@@ -0,0 +1,137 @@
+﻿#include "svggzip.h"
+#include <algorithm>
+#include <climits>
+#include <zlib.h>
+#include <QLoggingCategory>
+#include <QString>
+Q_DECLARE_LOGGING_CATEGORY(svgGzipLog)
+Q_LOGGING_CATEGORY(svgGzipLog, "SvgGzip")
+
+// 15-bit window plus 16 selects the gzip wrapper instead of raw zlib
+static constexpr int GZIP_WINDOW_BITS = 15 + 16;
+static constexpr std::size_t GZIP_OUTPUT_CHUNK = 64 * 1024;
+// zlib counts in uInt; feed larger inputs in pieces
+static constexpr std::size_t GZIP_MAX_INPUT = UINT_MAX;
+
+SvgGzipDecoder::SvgGzipDecoder(std::string_view compressed)
+    : m_stream(std::make_unique<z_stream_s>()), m_input(compressed) {
+    if (inflateInit2(m_stream.get(), GZIP_WINDOW_BITS) != Z_OK) {
+        m_stream.reset();
+        m_ok = false;
+        m_error = "Failed to initialize gzip decoder";
+    }
+}
+
+SvgGzipDecoder::~SvgGzipDecoder() {
+    if (m_stream) {
+        inflateEnd(m_stream.get());
+    }
+}
+
+std::size_t SvgGzipDecoder::read(char* dst, std::size_t capacity) {
+    if (!m_ok || m_finished || capacity == 0) {
+        return 0;
+    }
+    z_stream_s& stream = *m_stream;
+    stream.next_out = reinterpret_cast<Bytef*>(dst);
+    stream.avail_out = static_cast<uInt>(std::min(capacity, GZIP_MAX_INPUT));
+
+    while (stream.avail_out > 0) {
+        if (stream.avail_in == 0) {
+            if (m_input.empty()) {
+                // The input ended inside a member
+                m_ok = false;
+                m_error = "Unexpected end of gzip data";
+                break;
+            }
+            std::size_t size = std::min(m_input.size(), GZIP_MAX_INPUT);
+            stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(m_input.data()));
+            stream.avail_in = static_cast<uInt>(size);
+            m_input.remove_prefix(size);
+        }
+
+        int result = inflate(&stream, Z_NO_FLUSH);
+        if (result == Z_STREAM_END) {
+            // Another member may follow; anything else after the last one is ignored.
+            // Its start is either still pending in the stream or next in m_input.
+            std::string_view rest = stream.avail_in > 0
+                ? std::string_view(reinterpret_cast<const char*>(stream.next_in), stream.avail_in)
+                : m_input;
+            if (!svgIsGzipContent(rest)) {
+                m_finished = true;
+                break;
+            }
+            inflateReset(&stream);
+        } else if (result != Z_OK && result != Z_BUF_ERROR) {
+            m_ok = false;
+            m_error = stream.msg ? stream.msg : "Corrupt gzip data";
+            break;
+        }
+    }
+
+    if (!m_ok) {
+        qCWarning(svgGzipLog) << "Failed to decompress:" << QString::fromStdString(m_error);
+        return 0;
+    }
+    return std::min(capacity, GZIP_MAX_INPUT) - stream.avail_out;
+}
+
+SvgGzipEncoder::SvgGzipEncoder(SvgWriter::Sink sink, int level)
+    : m_stream(std::make_unique<z_stream_s>()), m_sink(std::move(sink)) {
+    if (deflateInit2(m_stream.get(), level, Z_DEFLATED, GZIP_WINDOW_BITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        qCWarning(svgGzipLog) << "Failed to initialize gzip encoder";
+        m_stream.reset();
+        m_ok = false;
+    }
+    m_output.resize(GZIP_OUTPUT_CHUNK);
+}
+
+SvgGzipEncoder::~SvgGzipEncoder() {
+    if (m_stream) {
+        deflateEnd(m_stream.get());
+    }
+}
+
+bool SvgGzipEncoder::write(std::string_view data) {
+    while (m_ok && !data.empty()) {
+        std::size_t size = std::min(data.size(), GZIP_MAX_INPUT);
+        m_stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+        m_stream->avail_in = static_cast<uInt>(size);
+        data.remove_prefix(size);
+        deflateInput(Z_NO_FLUSH);
+    }
+    return m_ok;
+}
+
+bool SvgGzipEncoder::finish() {
+    if (m_ok && !m_finished) {
+        m_stream->next_in = nullptr;
+        m_stream->avail_in = 0;
+        m_finished = deflateInput(Z_FINISH);
+    }
+    return m_ok;
+}
+
+// Runs deflate until the pending input is consumed (or the stream is finished),
+// handing each full output buffer to the sink
+bool SvgGzipEncoder::deflateInput(int flush) {
+    z_stream_s& stream = *m_stream;
+    while (true) {
+        stream.next_out = reinterpret_cast<Bytef*>(m_output.data());
+        stream.avail_out = static_cast<uInt>(m_output.size());
+        int result = deflate(&stream, flush);
+        if (result == Z_STREAM_ERROR) {
+            qCWarning(svgGzipLog) << "Compression failed";
+            m_ok = false;
+            return false;
+        }
+        std::size_t produced = m_output.size() - stream.avail_out;
+        if (produced > 0 && !m_sink(std::string_view(m_output.data(), produced))) {
+            m_ok = false;
+            return false;
+        }
+        if (flush == Z_FINISH ? result == Z_STREAM_END : stream.avail_out > 0) {
+            return true;
+        }
+    }
+}
@@ -0,0 +1,69 @@
+﻿#pragma once
+#include "svgwriter.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+struct z_stream_s;
+
+// True if `content` starts with the gzip magic bytes, as .svgz files do
+inline bool svgIsGzipContent(std::string_view content) {
+    return content.size() >= 2 && static_cast<unsigned char>(content[0]) == 0x1f &&
+           static_cast<unsigned char>(content[1]) == 0x8b;
+}
+
+// Inflates gzip data (e.g. a mapped .svgz file) on demand, a buffer at a time,
+// so the parser never sees more than one chunk of the decompressed document.
+// Concatenated gzip members are decoded as one stream.
+class SvgGzipDecoder {
+public:
+    explicit SvgGzipDecoder(std::string_view compressed);
+    ~SvgGzipDecoder();
+
+    SvgGzipDecoder(const SvgGzipDecoder&) = delete;
+    SvgGzipDecoder& operator=(const SvgGzipDecoder&) = delete;
+
+    // Fills up to `capacity` bytes; 0 at the end of the data or on error.
+    // Usable directly as an SvgByteSource.
+    std::size_t read(char* dst, std::size_t capacity);
+
+    // False once the data turned out to be corrupt or truncated
+    bool ok() const { return m_ok; }
+    const std::string& errorString() const { return m_error; }
+
+private:
+    std::unique_ptr<z_stream_s> m_stream;
+    std::string_view m_input;
+    bool m_finished = false;
+    bool m_ok = true;
+    std::string m_error;
+};
+
+// Deflates everything handed to write() into gzip format and passes the
+// compressed bytes on to `sink` as they come out, e.g. as the sink of an
+// SvgWriter. finish() writes the trailer and must be called once at the end.
+class SvgGzipEncoder {
+public:
+    explicit SvgGzipEncoder(SvgWriter::Sink sink, int level = DEFAULT_LEVEL);
+    ~SvgGzipEncoder();
+
+    SvgGzipEncoder(const SvgGzipEncoder&) = delete;
+    SvgGzipEncoder& operator=(const SvgGzipEncoder&) = delete;
+
+    bool write(std::string_view data);
+    bool finish();
+    bool ok() const { return m_ok; }
+
+    // zlib's default trade-off; higher levels cost much more time for a few percent
+    static constexpr int DEFAULT_LEVEL = 6;
+
+private:
+    bool deflateInput(int flush);
+
+    std::unique_ptr<z_stream_s> m_stream;
+    SvgWriter::Sink m_sink;
+    std::string m_output;
+    bool m_ok = true;
+    bool m_finished = false;
+};
@@ -0,0 +1,427 @@
+﻿#include "svgjournal.h"
+#include "svgdocument.h"
+#include "svgmappedfile.h"
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <QLoggingCategory>
+#include <QString>
+Q_DECLARE_LOGGING_CATEGORY(svgJournalLog)
+Q_LOGGING_CATEGORY(svgJournalLog, "SvgJournal")
+
+static constexpr char JOURNAL_MAGIC[4] = {'S', 'V', 'G', 'J'};
+static constexpr uint32_t JOURNAL_VERSION = 2;
+static constexpr size_t JOURNAL_HEADER_SIZE = 16;
+// Guards replay against a corrupt length field
+static constexpr uint32_t MAX_RECORD_PAYLOAD = 1u << 30;
+
+// Indexes are positions in SvgDocument::getElements()
+enum class JournalRecord : uint8_t {
+    Canvas = 1,   // f64 width, f64 height, u8 r, g, b, alpha
+    Remove = 2,   // u32 index
+    Insert = 3,   // u32 index, u32 size, SVG fragment
+    Replace = 4,  // u32 index, u32 size, SVG fragment
+    Compact = 5,  // no payload
+};
+
+static constexpr std::array<uint32_t, 256> makeCrcTable() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+static constexpr std::array<uint32_t, 256> CRC_TABLE = makeCrcTable();
+
+static uint32_t crc32(const char* data, size_t size) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) {
+        crc = CRC_TABLE[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+// Fields are stored in host order; every supported target is little-endian
+template <typename T>
+static void appendValue(std::string& out, T value) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out.append(bytes, sizeof(T));
+}
+
+template <typename T>
+static bool readValue(std::string_view data, size_t& pos, T& value) {
+    if (data.size() - pos < sizeof(T)) {
+        return false;
+    }
+    std::memcpy(&value, data.data() + pos, sizeof(T));
+    pos += sizeof(T);
+    return true;
+}
+
+static void appendFragment(std::string& out, const SvgElement* element) {
+    std::string svg = element->toSvgString();
+    appendValue<uint32_t>(out, static_cast<uint32_t>(svg.size()));
+    out += svg;
+}
+
+// Frames `payload` (which starts with the type byte) as a record
+static void appendRecord(std::string& out, const std::string& payload) {
+    appendValue<uint32_t>(out, static_cast<uint32_t>(payload.size() - 1));
+    out += payload;
+    appendValue<uint32_t>(out, crc32(payload.data(), payload.size()));
+}
+
+static std::string beginPayload(JournalRecord type) {
+    std::string payload;
+    payload += static_cast<char>(type);
+    return payload;
+}
+
+// Parses SVG fragments written by appendFragment back into elements
+static bool parseFragments(const std::vector<std::string_view>& fragments,
+                           std::vector<std::unique_ptr<SvgElement>>& elements) {
+    // The empty group keeps a full-size first rect from being taken as the background
+    std::string content = "<svg xmlns=\"http://www.w3.org/2000/svg\"><g></g>\n";
+    for (std::string_view fragment : fragments) {
+        content.append(fragment);
+        content += '\n';
+    }
+    content += "</svg>";
+    SvgDocument fragmentDocument;
+    if (!fragmentDocument.parseSvgContent(content)) {
+        return false;
+    }
+    elements = fragmentDocument.takeAllElements();
+    return elements.size() == fragments.size();
+}
+
+SvgJournal::~SvgJournal() {
+    close();
+}
+
+std::string SvgJournal::journalPathFor(const std::string& filePath) {
+    return filePath + ".journal";
+}
+
+bool SvgJournal::writeHeader(std::ofstream& file, uint64_t elementCount) const {
+    std::string header(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+    appendValue<uint32_t>(header, JOURNAL_VERSION);
+    appendValue<uint64_t>(header, elementCount);
+    file.write(header.data(), static_cast<std::streamsize>(header.size()));
+    file.flush();
+    return file.good();
+}
+
+bool SvgJournal::open(const std::string& journalPath, const SvgDocument& document) {
+    close();
+    ++m_session;
+    m_file.open(journalPath, std::ios::binary | std::ios::trunc);
+    if (!m_file.is_open() || !writeHeader(m_file, document.getElementCount())) {
+        qCWarning(svgJournalLog) << "Failed to create journal:" << QString::fromStdString(journalPath);
+        m_file.close();
+        return false;
+    }
+    m_path = journalPath;
+    m_size = JOURNAL_HEADER_SIZE;
+    m_compactions = document.getCompactionCount();
+    qCDebug(svgJournalLog) << "Journal opened:" << QString::fromStdString(journalPath);
+    return true;
+}
+
+bool SvgJournal::resume(const std::string& journalPath, const SvgDocument& document, uint64_t validBytes) {
+    close();
+    ++m_session;
+    std::error_code error;
+    // Cut off a torn record so new ones are not appended behind it
+    std::filesystem::resize_file(journalPath, validBytes, error);
+    if (error || validBytes < JOURNAL_HEADER_SIZE) {
+        qCWarning(svgJournalLog) << "Failed to resume journal:" << QString::fromStdString(journalPath);
+        return false;
+    }
+    m_file.open(journalPath, std::ios::binary | std::ios::app);
+    if (!m_file.is_open()) {
+        qCWarning(svgJournalLog) << "Failed to resume journal:" << QString::fromStdString(journalPath);
+        return false;
+    }
+    m_path = journalPath;
+    m_size = validBytes;
+    m_compactions = document.getCompactionCount();
+    qCDebug(svgJournalLog) << "Journal resumed:" << QString::fromStdString(journalPath) << "at" << validBytes << "bytes";
+    return true;
+}
+
+void SvgJournal::close() {
+    if (m_file.is_open()) {
+        m_file.close();
+    }
+    m_path.clear();
+    m_size = 0;
+}
+
+void SvgJournal::discard() {
+    std::string path = m_path;
+    close();
+    if (!path.empty()) {
+        std::error_code error;
+        std::filesystem::remove(path, error);
+    }
+}
+
+bool SvgJournal::append(const SvgDocument& document, const std::string& payload) {
+    if (!m_file.is_open()) {
+        return false;
+    }
+
+    std::string records;
+    if (document.getCompactionCount() != m_compactions) {
+        // Replay compacts at the same point, so the positions that follow match
+        appendRecord(records, beginPayload(JournalRecord::Compact));
+        m_compactions = document.getCompactionCount();
+    }
+    appendRecord(records, payload);
+
+    // Flushed so the records survive a crash of the editor
+    m_file.write(records.data(), static_cast<std::streamsize>(records.size()));
+    m_file.flush();
+    if (!m_file.good()) {
+        qCWarning(svgJournalLog) << "Failed to append to journal:" << QString::fromStdString(m_path);
+        return false;
+    }
+    m_size += records.size();
+    return true;
+}
+
+bool SvgJournal::recordInsert(const SvgDocument& document, const SvgElement* element) {
+    size_t position = element ? document.findElementPosition(element) : document.getElements().size();
+    if (position == document.getElements().size()) {
+        qCWarning(svgJournalLog) << "Cannot journal insertion of an element the document does not hold";
+        return false;
+    }
+    std::string payload = beginPayload(JournalRecord::Insert);
+    appendValue<uint32_t>(payload, static_cast<uint32_t>(position));
+    appendFragment(payload, element);
+    return append(document, payload);
+}
+
+bool SvgJournal::recordRemove(const SvgDocument& document, const SvgElement* element) {
+    size_t position = element ? document.findElementPosition(element) : document.getElements().size();
+    if (position == document.getElements().size()) {
+        qCWarning(svgJournalLog) << "Cannot journal removal of an element the document does not hold";
+        return false;
+    }
+    std::string payload = beginPayload(JournalRecord::Remove);
+    appendValue<uint32_t>(payload, static_cast<uint32_t>(position));
+    return append(document, payload);
+}
+
+bool SvgJournal::recordReplace(const SvgDocument& document, const SvgElement* element) {
+    size_t position = element ? document.findElementPosition(element) : document.getElements().size();
+    if (position == document.getElements().size()) {
+        qCWarning(svgJournalLog) << "Cannot journal change of an element the document does not hold";
+        return false;
+    }
+    std::string payload = beginPayload(JournalRecord::Replace);
+    appendValue<uint32_t>(payload, static_cast<uint32_t>(position));
+    appendFragment(payload, element);
+    return append(document, payload);
+}
+
+bool SvgJournal::recordCanvas(const SvgDocument& document) {
+    Color color = document.getBackgroundColor();
+    std::string payload = beginPayload(JournalRecord::Canvas);
+    appendValue<double>(payload, document.getWidth());
+    appendValue<double>(payload, document.getHeight());
+    for (int channel : {color.r, color.g, color.b, color.alpha}) {
+        appendValue<uint8_t>(payload, static_cast<uint8_t>(channel));
+    }
+    return append(document, payload);
+}
+
+SvgJournal::Checkpoint SvgJournal::checkpoint(const SvgDocument& document) const {
+    return {m_session, m_size, document.getElementCount()};
+}
+
+bool SvgJournal::rebase(const Checkpoint& checkpoint, const std::string& journalPath) {
+    if (!m_file.is_open() || checkpoint.session != m_session || checkpoint.offset > m_size) {
+        return false;
+    }
+
+    // Records written after the checkpoint still apply on top of the saved file
+    std::string tail;
+    if (m_size > checkpoint.offset) {
+        std::ifstream in(m_path, std::ios::binary);
+        in.seekg(static_cast<std::streamoff>(checkpoint.offset));
+        tail.resize(static_cast<size_t>(m_size - checkpoint.offset));
+        in.read(tail.data(), static_cast<std::streamsize>(tail.size()));
+        if (!in) {
+            qCWarning(svgJournalLog) << "Failed to read journal tail:" << QString::fromStdString(m_path);
+            return false;
+        }
+    }
+
+    std::string temporaryPath = journalPath + ".tmp";
+    std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+    bool written = out.is_open() && writeHeader(out, checkpoint.elementCount);
+    if (written && !tail.empty()) {
+        out.write(tail.data(), static_cast<std::streamsize>(tail.size()));
+        out.flush();
+        written = out.good();
+    }
+    out.close();
+
+    std::string oldPath = m_path;
+    m_file.close();
+    std::error_code error;
+    if (written) {
+        std::filesystem::rename(temporaryPath, journalPath, error);
+    }
+    if (!written || error) {
+        qCWarning(svgJournalLog) << "Failed to rebase journal:" << QString::fromStdString(journalPath);
+        std::filesystem::remove(temporaryPath, error);
+        // Keep appending to the old journal; it still replays onto the old file
+        m_file.open(oldPath, std::ios::binary | std::ios::app);
+        return false;
+    }
+    if (oldPath != journalPath) {
+        std::filesystem::remove(oldPath, error);
+    }
+
+    m_file.open(journalPath, std::ios::binary | std::ios::app);
+    m_path = journalPath;
+    m_size = JOURNAL_HEADER_SIZE + tail.size();
+    qCDebug(svgJournalLog) << "Journal rebased:" << QString::fromStdString(journalPath)
+                           << "keeping" << tail.size() << "bytes";
+    return m_file.is_open();
+}
+
+// Header check shared by hasRecoverableRecords and replay
+static bool readJournalHeader(std::string_view data, uint64_t& elementCount) {
+    size_t pos = sizeof(JOURNAL_MAGIC);
+    uint32_t version = 0;
+    return data.size() >= JOURNAL_HEADER_SIZE && std::memcmp(data.data(), JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) == 0 &&
+           readValue(data, pos, version) && version == JOURNAL_VERSION && readValue(data, pos, elementCount);
+}
+
+bool SvgJournal::hasRecoverableRecords(const std::string& journalPath, const SvgDocument& document) {
+    SvgMappedFile file;
+    uint64_t elementCount = 0;
+    return file.open(journalPath) && file.size() > JOURNAL_HEADER_SIZE &&
+           readJournalHeader(file.bytes(), elementCount) && elementCount == document.getElementCount();
+}
+
+bool SvgJournal::replay(const std::string& journalPath, SvgDocument& document, size_t* records, uint64_t* validBytes) {
+    SvgMappedFile file;
+    uint64_t elementCount = 0;
+    if (!file.open(journalPath) || !readJournalHeader(file.bytes(), elementCount)) {
+        qCWarning(svgJournalLog) << "Not a journal file:" << QString::fromStdString(journalPath);
+        return false;
+    }
+    if (elementCount != document.getElementCount()) {
+        qCWarning(svgJournalLog) << "Journal does not match the saved file:" << elementCount
+                                 << "elements expected," << document.getElementCount() << "found";
+        return false;
+    }
+
+    std::string_view data = file.bytes();
+    size_t pos = JOURNAL_HEADER_SIZE;
+    size_t applied = 0;
+    while (pos < data.size()) {
+        size_t recordStart = pos;
+        uint32_t payloadSize = 0;
+        if (!readValue(data, pos, payloadSize) || payloadSize > MAX_RECORD_PAYLOAD ||
+            data.size() - pos < size_t(payloadSize) + 1 + sizeof(uint32_t)) {
+            pos = recordStart;
+            break;
+        }
+        std::string_view framed = data.substr(pos, size_t(payloadSize) + 1);
+        size_t crcPos = pos + framed.size();
+        uint32_t storedCrc = 0;
+        readValue(data, crcPos, storedCrc);
+        if (storedCrc != crc32(framed.data(), framed.size())) {
+            pos = recordStart;
+            break;
+        }
+
+        auto type = static_cast<JournalRecord>(framed[0]);
+        std::string_view payload = framed.substr(1);
+        size_t cursor = 0;
+        bool ok = false;
+        uint32_t index = 0;
+        switch (type) {
+        case JournalRecord::Canvas: {
+            double width = 0;
+            double height = 0;
+            uint8_t channels[4] = {};
+            ok = readValue(payload, cursor, width) && readValue(payload, cursor, height);
+            for (uint8_t& channel : channels) {
+                ok = ok && readValue(payload, cursor, channel);
+            }
+            if (ok) {
+                document.setWidth(width);
+                document.setHeight(height);
+                document.setBackgroundColor({channels[0], channels[1], channels[2], channels[3]});
+            }
+            break;
+        }
+        case JournalRecord::Remove: {
+            const auto& elements = document.getElements();
+            ok = readValue(payload, cursor, index) && index < elements.size() && elements[index];
+            if (ok) {
+                document.takeElement(elements[index].get());
+            }
+            break;
+        }
+        case JournalRecord::Insert:
+        case JournalRecord::Replace: {
+            const auto& elements = document.getElements();
+            uint32_t size = 0;
+            ok = readValue(payload, cursor, index) && readValue(payload, cursor, size) && payload.size() - cursor >= size;
+            if (type == JournalRecord::Insert) {
+                ok = ok && index <= elements.size();
+            } else {
+                ok = ok && index < elements.size() && elements[index];
+            }
+            std::vector<std::unique_ptr<SvgElement>> parsed;
+            ok = ok && parseFragments({payload.substr(cursor, size)}, parsed);
+            if (ok && type == JournalRecord::Insert) {
+                document.insertElementAt(index, std::move(parsed.front()));
+            } else if (ok) {
+                document.replaceElementAt(index, std::move(parsed.front()));
+            }
+            break;
+        }
+        case JournalRecord::Compact:
+            ok = payload.empty();
+            if (ok) {
+                document.compactElements();
+            }
+            break;
+        }
+        if (!ok) {
+            qCWarning(svgJournalLog) << "Stopping replay at malformed record at offset" << recordStart;
+            pos = recordStart;
+            break;
+        }
+        pos = crcPos;
+        ++applied;
+    }
+
+    if (pos < data.size()) {
+        qCWarning(svgJournalLog) << "Ignoring" << (data.size() - pos) << "bytes of incomplete journal data";
+    }
+    qCInfo(svgJournalLog) << "Replayed" << applied << "journal records from" << QString::fromStdString(journalPath);
+    if (records) {
+        *records = applied;
+    }
+    if (validBytes) {
+        *validBytes = pos;
+    }
+    return true;
+}
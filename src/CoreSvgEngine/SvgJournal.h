@@ -0,0 +1,94 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+class SvgDocument;
+class SvgElement;
+
+// Append-only record of edits made since a document was last saved, for
+// crash recovery without rewriting the whole file.
+//
+// Code that changes the document appends the change where it makes it:
+// commands record the elements they insert or remove, attribute edits the
+// element they replace, canvas edits the canvas. A record names its position in
+// SvgDocument::getElements(), removed entries included, so it costs only the
+// changed element. Removals are recorded just before they happen and everything
+// else just after; a compaction of the document is noted ahead of the next
+// record. Replay repeats the same document operations, so positions line up.
+// Elements are stored as their SVG fragment, so replay goes through the
+// regular parser. Every record carries a CRC-32; replay stops at the first torn
+// or corrupt record, so a crash mid-append loses only that step.
+//
+// File layout, little-endian: "SVGJ", u32 version, u64 element count of the
+// saved file the records apply to, then records of
+// u32 payload size, u8 type, payload, u32 CRC of type and payload.
+class SvgJournal {
+public:
+    // Position in the journal; a successful save of the state at a checkpoint
+    // makes everything before it redundant
+    struct Checkpoint {
+        uint64_t session = 0;
+        uint64_t offset = 0;
+        uint64_t elementCount = 0;
+    };
+
+    SvgJournal() = default;
+    ~SvgJournal();
+
+    SvgJournal(const SvgJournal&) = delete;
+    SvgJournal& operator=(const SvgJournal&) = delete;
+
+    // Starts an empty journal at journalPath whose baseline is `document`, as
+    // loaded or saved, i.e. without removed entries
+    bool open(const std::string& journalPath, const SvgDocument& document);
+    // Continues a replayed journal: keeps its first `validBytes` bytes and
+    // appends from the state of `document`, which must be the replayed result
+    bool resume(const std::string& journalPath, const SvgDocument& document, uint64_t validBytes);
+    void close();
+    // Closes and deletes the journal file, e.g. when changes are discarded
+    void discard();
+
+    bool isOpen() const { return m_file.is_open(); }
+    const std::string& path() const { return m_path; }
+
+    // Each appends one record for a change to `document`; false on write errors.
+    // `element` has just been inserted
+    bool recordInsert(const SvgDocument& document, const SvgElement* element);
+    // `element` is about to be removed
+    bool recordRemove(const SvgDocument& document, const SvgElement* element);
+    // `element` has just been changed in place
+    bool recordReplace(const SvgDocument& document, const SvgElement* element);
+    // Size or background color have just been changed
+    bool recordCanvas(const SvgDocument& document);
+
+    // Current position, for `document` about to be saved; compact it first so
+    // later positions match the saved file
+    Checkpoint checkpoint(const SvgDocument& document) const;
+    // After a successful save of the checkpoint's state, drops the records
+    // before it and moves the journal to journalPath (the saved file's journal).
+    // Ignored for checkpoints from an earlier open() or resume().
+    bool rebase(const Checkpoint& checkpoint, const std::string& journalPath);
+
+    // Journal file used for a document file
+    static std::string journalPathFor(const std::string& filePath);
+    // True if journalPath holds records that apply on top of `document`, the freshly loaded file
+    static bool hasRecoverableRecords(const std::string& journalPath, const SvgDocument& document);
+    // Applies the journal's records to `document`. `records` receives the number
+    // applied and `validBytes` the length of the intact part, for resume().
+    static bool replay(const std::string& journalPath, SvgDocument& document,
+                       size_t* records = nullptr, uint64_t* validBytes = nullptr);
+
+private:
+    // Writes `payload` as a record, behind a compaction record if `document` compacted since the last one
+    bool append(const SvgDocument& document, const std::string& payload);
+    bool writeHeader(std::ofstream& file, uint64_t elementCount) const;
+
+    std::ofstream m_file;
+    std::string m_path;
+    uint64_t m_size = 0;
+    uint64_t m_session = 0;
+    // SvgDocument::getCompactionCount as of the last record
+    uint64_t m_compactions = 0;
+};
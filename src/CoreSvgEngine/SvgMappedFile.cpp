@@ -0,0 +1,94 @@
+﻿#include "svgmappedfile.h"
+#include <fstream>
+#include <QLoggingCategory>
+#include <QString>
+
+#if defined(__unix__) || defined(__APPLE__)
+#  define SVG_HAS_MMAP 1
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+Q_DECLARE_LOGGING_CATEGORY(svgMappedFileLog)
+Q_LOGGING_CATEGORY(svgMappedFileLog, "SvgMappedFile")
+
+SvgMappedFile::~SvgMappedFile() {
+    close();
+}
+
+bool SvgMappedFile::open(const std::string& filePath) {
+    close();
+    if (map(filePath) || readAll(filePath)) {
+        m_open = true;
+    }
+    return m_open;
+}
+
+void SvgMappedFile::close() {
+#ifdef SVG_HAS_MMAP
+    if (m_mapped) {
+        munmap(m_mapped, m_size);
+    }
+#endif
+    m_mapped = nullptr;
+    m_data = nullptr;
+    m_size = 0;
+    std::string().swap(m_buffer);
+    m_open = false;
+}
+
+bool SvgMappedFile::map(const std::string& filePath) {
+#ifdef SVG_HAS_MMAP
+    int fd = ::open(filePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info {};
+    // Zero-length files cannot be mapped; the buffered path handles them
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps its own reference to the file
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        qCDebug(svgMappedFileLog) << "mmap failed, falling back to buffered read:" << QString::fromStdString(filePath);
+        return false;
+    }
+    // The parser walks the file front to back exactly once
+    madvise(mapped, size, MADV_SEQUENTIAL);
+
+    m_mapped = mapped;
+    m_data = static_cast<const char*>(mapped);
+    m_size = size;
+    return true;
+#else
+    (void)filePath;
+    return false;
+#endif
+}
+
+bool SvgMappedFile::readAll(const std::string& filePath) {
+    std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::streamoff size = file.tellg();
+    if (size < 0) {
+        return false;
+    }
+    // Size the buffer once and read straight into it: a single copy of the file
+    m_buffer.resize(static_cast<size_t>(size));
+    file.seekg(0);
+    if (size > 0 && !file.read(m_buffer.data(), size)) {
+        m_buffer.clear();
+        return false;
+    }
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+    return true;
+}
@@ -0,0 +1,34 @@
+﻿#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only view of a whole file. On POSIX systems the file is memory-mapped
+// so the parser reads the page cache directly; elsewhere, or when mapping
+// fails, the file is read once into a single owned buffer.
+class SvgMappedFile {
+public:
+    SvgMappedFile() = default;
+    ~SvgMappedFile();
+
+    SvgMappedFile(const SvgMappedFile&) = delete;
+    SvgMappedFile& operator=(const SvgMappedFile&) = delete;
+
+    bool open(const std::string& filePath);
+    void close();
+
+    bool isOpen() const { return m_open; }
+    bool isMapped() const { return m_mapped != nullptr; }
+    std::string_view bytes() const { return {m_data, m_size}; }
+    std::size_t size() const { return m_size; }
+
+private:
+    bool map(const std::string& filePath);
+    bool readAll(const std::string& filePath);
+
+    const char* m_data = nullptr;
+    std::size_t m_size = 0;
+    void* m_mapped = nullptr;
+    std::string m_buffer;
+    bool m_open = false;
+};
@@ -0,0 +1,119 @@
+﻿#include "svgnumberparser.h"
+#include <array>
+#include <charconv>
+
+namespace {
+
+enum CharClass : unsigned char {
+    Other = 0,
+    Space = 1,
+    Comma = 2,
+    Digit = 3,
+    Sign = 4,
+    Dot = 5,
+    Exponent = 6
+};
+
+// One table lookup per byte keeps the separator scan branch-light without
+// tying the parser to a particular instruction set
+constexpr std::array<unsigned char, 256> makeCharClasses() {
+    std::array<unsigned char, 256> table{};
+    table[' '] = table['\t'] = table['\n'] = table['\r'] = table['\f'] = Space;
+    table[','] = Comma;
+    for (char c = '0'; c <= '9'; ++c) {
+        table[static_cast<unsigned char>(c)] = Digit;
+    }
+    table['+'] = table['-'] = Sign;
+    table['.'] = Dot;
+    table['e'] = table['E'] = Exponent;
+    return table;
+}
+
+constexpr std::array<unsigned char, 256> kCharClasses = makeCharClasses();
+
+inline unsigned char charClass(char c) {
+    return kCharClasses[static_cast<unsigned char>(c)];
+}
+
+inline std::size_t skipSpaces(std::string_view text, std::size_t pos) {
+    while (pos < text.size() && charClass(text[pos]) == Space) ++pos;
+    return pos;
+}
+
+} // namespace
+
+bool parseSvgNumber(std::string_view text, std::size_t& pos, double& value) {
+    std::size_t start = pos;
+    if (start >= text.size()) {
+        return false;
+    }
+    // std::from_chars rejects an explicit '+' sign, which SVG allows
+    std::size_t body = start;
+    if (text[start] == '+') {
+        start = body = start + 1;
+    } else if (text[start] == '-') {
+        body = start + 1;
+    }
+    // Only digits or '.' may open the mantissa; this also keeps from_chars
+    // from accepting "inf", "nan" or a doubled sign
+    if (body >= text.size() || (charClass(text[body]) != Digit && charClass(text[body]) != Dot)) {
+        return false;
+    }
+    double parsed = 0;
+    auto result = std::from_chars(text.data() + start, text.data() + text.size(), parsed);
+    if (result.ec != std::errc()) {
+        return false;
+    }
+    value = parsed;
+    pos = static_cast<std::size_t>(result.ptr - text.data());
+    return true;
+}
+
+std::size_t countSvgNumbers(std::string_view text) {
+    std::size_t count = 0;
+    unsigned char previous = Space;
+    for (char c : text) {
+        unsigned char current = charClass(c);
+        // A number starts after a separator, or at a sign that is not an exponent's
+        if (((current == Digit || current == Dot || current == Sign) && (previous == Space || previous == Comma)) ||
+            (current == Sign && previous != Exponent && previous != Sign && previous != Space && previous != Comma)) {
+            ++count;
+        }
+        previous = current;
+    }
+    return count;
+}
+
+bool parseSvgPointList(std::string_view text, std::vector<Point>& points, std::size_t* errorOffset) {
+    points.reserve(points.size() + countSvgNumbers(text) / 2);
+
+    std::size_t pos = skipSpaces(text, 0);
+    double coordinates[2] = {0, 0};
+    int pending = 0;
+    while (pos < text.size()) {
+        if (!parseSvgNumber(text, pos, coordinates[pending])) {
+            if (errorOffset) *errorOffset = pos;
+            return false;
+        }
+        if (++pending == 2) {
+            points.push_back({coordinates[0], coordinates[1]});
+            pending = 0;
+        }
+        // comma-wsp: whitespace with at most one comma; the next number may also
+        // follow directly when it starts with a sign or '.'
+        pos = skipSpaces(text, pos);
+        if (pos < text.size() && charClass(text[pos]) == Comma) {
+            pos = skipSpaces(text, pos + 1);
+            if (pos == text.size()) {
+                if (errorOffset) *errorOffset = pos;
+                return false;
+            }
+        }
+    }
+    // An odd coordinate count leaves the last point incomplete
+    if (pending != 0) {
+        if (errorOffset) *errorOffset = pos;
+        return false;
+    }
+    return true;
+}
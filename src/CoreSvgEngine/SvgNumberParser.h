@@ -0,0 +1,23 @@
+﻿#pragma once
+#include "coresvgstructs.h"
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+// Number and number-list parsing for SVG attribute values, built on
+// std::from_chars: no allocation per value and no exceptions.
+
+// Parses one SVG number starting at `pos` (no leading whitespace is skipped).
+// On success `pos` is advanced past the number; on failure it is left untouched.
+bool parseSvgNumber(std::string_view text, std::size_t& pos, double& value);
+
+// Estimate of how many numbers `text` holds, used to size containers up front.
+// Not a bound: a run such as "0.5.5" counts once but holds two numbers.
+std::size_t countSvgNumbers(std::string_view text);
+
+// Parses a `points` list ("x1,y1 x2,y2 ..."). Numbers may be separated by
+// whitespace, a single comma, or nothing at all when the next number starts with
+// a sign or a second decimal point ("10-5", "0.5.5"). On malformed input the
+// complete points read so far are kept, as SVG renders up to the first error,
+// and false is returned with the byte offset of the problem in `errorOffset`.
+bool parseSvgPointList(std::string_view text, std::vector<Point>& points, std::size_t* errorOffset = nullptr);
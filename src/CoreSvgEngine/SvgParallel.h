@@ -0,0 +1,47 @@
+﻿#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Resolves a requested worker count: 0 or less means one per hardware thread
+inline int svgResolveThreadCount(int requested) {
+    if (requested > 0) {
+        return requested;
+    }
+    unsigned int hardware = std::thread::hardware_concurrency();
+    return hardware > 0 ? static_cast<int>(hardware) : 1;
+}
+
+// Runs fn(index) for every index in [0, count) on up to `threads` threads,
+// the calling thread included. Indices are handed out one at a time so uneven
+// work items balance themselves; fn must not throw.
+template <typename Fn>
+void svgParallelFor(std::size_t count, int threads, Fn&& fn) {
+    std::size_t workers = std::min<std::size_t>(count, static_cast<std::size_t>(svgResolveThreadCount(threads)));
+    if (workers <= 1) {
+        for (std::size_t i = 0; i < count; ++i) {
+            fn(i);
+        }
+        return;
+    }
+
+    std::atomic<std::size_t> nextIndex{0};
+    auto work = [&]() {
+        for (std::size_t i = nextIndex.fetch_add(1, std::memory_order_relaxed); i < count;
+             i = nextIndex.fetch_add(1, std::memory_order_relaxed)) {
+            fn(i);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(workers - 1);
+    for (std::size_t t = 1; t < workers; ++t) {
+        pool.emplace_back(work);
+    }
+    work();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+}
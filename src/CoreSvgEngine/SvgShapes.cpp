@@ -1,201 +1,240 @@
 ﻿#include "svgshapes.h"
-#include <sstream>
-// #include "../LoggingService/LoggingService.h"
-#include <QLoggingCategory>
-Q_DECLARE_LOGGING_CATEGORY(svgShapesLog)
-Q_LOGGING_CATEGORY(svgShapesLog, "SvgShapes")
+#include "svgwriter.h"
+#include "svgtrace.h"
+
+// "x,y x,y ..." for the points attribute of polygons and polylines
+static void writePoints(SvgWriter& writer, const std::vector<Point>& points) {
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (i > 0) {
+            writer.write(' ');
+        }
+        writer.writeNumber(points[i].x);
+        writer.write(',');
+        writer.writeNumber(points[i].y);
+    }
+}
 
 // SvgLine
 SvgLine::SvgLine(Point start, Point end) : m_p1(start), m_p2(end) {
-    qCInfo(svgShapesLog) << "Creating Line element: (" + QString::fromStdString(std::to_string(start.x)) + "," + QString::fromStdString(std::to_string(start.y)) + ") to (" + QString::fromStdString(std::to_string(end.x)) + "," + QString::fromStdString(std::to_string(end.y)) + ")";
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Line {} created: ({}, {}) to ({}, {})", this, start.x, start.y, end.x, end.y);
 }
 
 void SvgLine::setP1(const Point& p) {
-    qCInfo(svgShapesLog) << "Setting Line start point: (" + QString::fromStdString(std::to_string(m_p1.x)) + "," + QString::fromStdString(std::to_string(m_p1.y)) + ") to (" + QString::fromStdString(std::to_string(p.x)) + "," + QString::fromStdString(std::to_string(p.y)) + ")";
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Line {} start ({}, {}) -> ({}, {})", this, m_p1.x, m_p1.y, p.x, p.y);
     m_p1 = p;
+    markChanged();
 }
 
 void SvgLine::setP2(const Point& p) {
-    qCInfo(svgShapesLog) << "Setting Line end point: (" + QString::fromStdString(std::to_string(m_p2.x)) + "," + QString::fromStdString(std::to_string(m_p2.y)) + ") to (" + QString::fromStdString(std::to_string(p.x)) + "," + QString::fromStdString(std::to_string(p.y)) + ")";
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Line {} end ({}, {}) -> ({}, {})", this, m_p2.x, m_p2.y, p.x, p.y);
     m_p2 = p;
+    markChanged();
+}
+
+void SvgLine::writeSvg(SvgWriter& writer) const {
+    writer.write("<line");
+    writer.writeAttribute("x1", m_p1.x);
+    writer.writeAttribute("y1", m_p1.y);
+    writer.writeAttribute("x2", m_p2.x);
+    writer.writeAttribute("y2", m_p2.y);
+    writeCommonAttributes(writer);
+    writer.write(" />");
 }
 
-std::string SvgLine::toSvgString() const {
-    std::stringstream ss;
-    ss << "<line x1=\"" << m_p1.x << "\" y1=\"" << m_p1.y
-       << "\" x2=\"" << m_p2.x << "\" y2=\"" << m_p2.y << "\""
-       << getCommonAttributesString() << " />";
-    return ss.str();
+BoundingBox SvgLine::getBoundingBox() const {
+    return {std::min(m_p1.x, m_p2.x), std::min(m_p1.y, m_p2.y), std::max(m_p1.x, m_p2.x), std::max(m_p1.y, m_p2.y)};
 }
 
 // SvgRectangle
 SvgRectangle::SvgRectangle(Point tl, double w, double h, double rx_, double ry_)
     : m_topLeft(tl), m_width(w > 0 ? w : 0), m_height(h > 0 ? h : 0), 
       m_rx(rx_ > 0 ? rx_ : 0), m_ry(ry_ > 0 ? ry_ : 0) {
-    qCInfo(svgShapesLog) << "Creating Rectangle element: (" + QString::fromStdString(std::to_string(tl.x)) + "," + QString::fromStdString(std::to_string(tl.y)) + ") width=" + QString::fromStdString(std::to_string(m_width)) + ", height=" + QString::fromStdString(std::to_string(m_height)) + ", rx=" + QString::fromStdString(std::to_string(m_rx)) + ", ry=" + QString::fromStdString(std::to_string(m_ry));
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Rectangle {} created: ({}, {}) {}x{}, rx={}, ry={}", this, tl.x, tl.y, m_width, m_height, m_rx, m_ry);
 }
 
 void SvgRectangle::setTopLeft(const Point& p) {
-    qCInfo(svgShapesLog) << "Setting Rectangle top-left: (" + QString::fromStdString(std::to_string(m_topLeft.x)) + "," + QString::fromStdString(std::to_string(m_topLeft.y)) + ") to (" + QString::fromStdString(std::to_string(p.x)) + "," + QString::fromStdString(std::to_string(p.y)) + ")";
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Rectangle {} top-left ({}, {}) -> ({}, {})", this, m_topLeft.x, m_topLeft.y, p.x, p.y);
     m_topLeft = p;
+    markChanged();
 }
 
 void SvgRectangle::setWidth(double w) {
     double newWidth = (w > 0 ? w : 0);
-    qCInfo(svgShapesLog) << "Setting Rectangle width: " + QString::fromStdString(std::to_string(m_width)) + " to " + QString::fromStdString(std::to_string(newWidth));
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Rectangle {} width {} -> {}", this, m_width, newWidth);
     m_width = newWidth;
+    markChanged();
 }
 
 void SvgRectangle::setHeight(double h) {
     double newHeight = (h > 0 ? h : 0);
-    qCInfo(svgShapesLog) << "Setting Rectangle height: " + QString::fromStdString(std::to_string(m_height)) + " to " + QString::fromStdString(std::to_string(newHeight));
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Rectangle {} height {} -> {}", this, m_height, newHeight);
     m_height = newHeight;
+    markChanged();
 }
 
 void SvgRectangle::setRx(double rx_val) {
     double newRx = (rx_val > 0 ? rx_val : 0);
-    qCInfo(svgShapesLog) << "Setting Rectangle rx (corner radius x): " + QString::fromStdString(std::to_string(m_rx)) + " to " + QString::fromStdString(std::to_string(newRx));
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Rectangle {} rx {} -> {}", this, m_rx, newRx);
     m_rx = newRx;
+    markChanged();
 }
 
 void SvgRectangle::setRy(double ry_val) {
     double newRy = (ry_val > 0 ? ry_val : 0);
-    qCInfo(svgShapesLog) << "Setting Rectangle ry (corner radius y): " + QString::fromStdString(std::to_string(m_ry)) + " to " + QString::fromStdString(std::to_string(newRy));
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Rectangle {} ry {} -> {}", this, m_ry, newRy);
     m_ry = newRy;
+    markChanged();
 }
 
-std::string SvgRectangle::toSvgString() const {
-    std::stringstream ss;
-    ss << "<rect x=\"" << m_topLeft.x << "\" y=\"" << m_topLeft.y
-       << "\" width=\"" << m_width << "\" height=\"" << m_height << "\"";
-    if (m_rx > 0) ss << " rx=\"" << m_rx << "\"";
-    if (m_ry > 0) ss << " ry=\"" << m_ry << "\"";
-    ss << getCommonAttributesString() << " />";
-    return ss.str();
+void SvgRectangle::writeSvg(SvgWriter& writer) const {
+    writer.write("<rect");
+    writer.writeAttribute("x", m_topLeft.x);
+    writer.writeAttribute("y", m_topLeft.y);
+    writer.writeAttribute("width", m_width);
+    writer.writeAttribute("height", m_height);
+    if (m_rx > 0) writer.writeAttribute("rx", m_rx);
+    if (m_ry > 0) writer.writeAttribute("ry", m_ry);
+    writeCommonAttributes(writer);
+    writer.write(" />");
+}
+
+BoundingBox SvgRectangle::getBoundingBox() const {
+    return {m_topLeft.x, m_topLeft.y, m_topLeft.x + m_width, m_topLeft.y + m_height};
 }
 
 // SvgCircle    
 SvgCircle::SvgCircle(Point c, double r) : m_center(c), m_radius(r > 0 ? r : 0) {
-    qCInfo(svgShapesLog) << "Creating Circle element: center=(" + QString::fromStdString(std::to_string(c.x)) + "," + QString::fromStdString(std::to_string(c.y)) + "), radius=" + QString::fromStdString(std::to_string(m_radius));
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Circle {} created: center ({}, {}), r={}", this, c.x, c.y, m_radius);
 }
 
 void SvgCircle::setCenter(const Point& c) {
-    qCInfo(svgShapesLog) << "Setting Circle center: (" + QString::fromStdString(std::to_string(m_center.x)) + "," + QString::fromStdString(std::to_string(m_center.y)) + ") to (" + QString::fromStdString(std::to_string(c.x)) + "," + QString::fromStdString(std::to_string(c.y)) + ")";
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Circle {} center ({}, {}) -> ({}, {})", this, m_center.x, m_center.y, c.x, c.y);
     m_center = c;
+    markChanged();
 }
 
 void SvgCircle::setRadius(double r) {
     double newRadius = (r > 0 ? r : 0);
-    qCInfo(svgShapesLog) << "Setting Circle radius: " + QString::fromStdString(std::to_string(m_radius)) + " to " + QString::fromStdString(std::to_string(newRadius));
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Circle {} radius {} -> {}", this, m_radius, newRadius);
     m_radius = newRadius;
+    markChanged();
+}
+
+void SvgCircle::writeSvg(SvgWriter& writer) const {
+    writer.write("<circle");
+    writer.writeAttribute("cx", m_center.x);
+    writer.writeAttribute("cy", m_center.y);
+    writer.writeAttribute("r", m_radius);
+    writeCommonAttributes(writer);
+    writer.write(" />");
 }
 
-std::string SvgCircle::toSvgString() const {
-    std::stringstream ss;
-    ss << "<circle cx=\"" << m_center.x << "\" cy=\"" << m_center.y
-       << "\" r=\"" << m_radius << "\""
-       << getCommonAttributesString() << " />";
-    return ss.str();
+BoundingBox SvgCircle::getBoundingBox() const {
+    return {m_center.x - m_radius, m_center.y - m_radius, m_center.x + m_radius, m_center.y + m_radius};
 }
 
 // SvgEllipse    
 SvgEllipse::SvgEllipse(Point c, double r_x, double r_y) 
     : m_center(c), m_rx(r_x > 0 ? r_x : 0), m_ry(r_y > 0 ? r_y : 0) {
-    qCInfo(svgShapesLog) << "Creating Ellipse element: center=(" + QString::fromStdString(std::to_string(c.x)) + "," + QString::fromStdString(std::to_string(c.y)) + "), rx=" + QString::fromStdString(std::to_string(m_rx)) + ", ry=" + QString::fromStdString(std::to_string(m_ry));
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Ellipse {} created: center ({}, {}), rx={}, ry={}", this, c.x, c.y, m_rx, m_ry);
 }
 
 void SvgEllipse::setCenter(const Point& c) {
-    qCInfo(svgShapesLog) << "Setting Ellipse center: (" + QString::fromStdString(std::to_string(m_center.x)) + "," + QString::fromStdString(std::to_string(m_center.y)) + ") to (" + QString::fromStdString(std::to_string(c.x)) + "," + QString::fromStdString(std::to_string(c.y)) + ")";
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Ellipse {} center ({}, {}) -> ({}, {})", this, m_center.x, m_center.y, c.x, c.y);
     m_center = c;
+    markChanged();
 }
 
 void SvgEllipse::setRx(double r_x) {
     double newRx = (r_x > 0 ? r_x : 0);
-    qCInfo(svgShapesLog) << "Setting Ellipse x-radius: " + QString::fromStdString(std::to_string(m_rx)) + " to " + QString::fromStdString(std::to_string(newRx));
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Ellipse {} rx {} -> {}", this, m_rx, newRx);
     m_rx = newRx;
+    markChanged();
 }
 
 void SvgEllipse::setRy(double r_y) {
     double newRy = (r_y > 0 ? r_y : 0);
-    qCInfo(svgShapesLog) << "Setting Ellipse y-radius: " + QString::fromStdString(std::to_string(m_ry)) + " to " + QString::fromStdString(std::to_string(newRy));
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Ellipse {} ry {} -> {}", this, m_ry, newRy);
     m_ry = newRy;
+    markChanged();
 }
 
-std::string SvgEllipse::toSvgString() const {
-    std::stringstream ss;
-    ss << "<ellipse cx=\"" << m_center.x << "\" cy=\"" << m_center.y
-       << "\" rx=\"" << m_rx << "\" ry=\"" << m_ry << "\""
-       << getCommonAttributesString() << " />";
-    return ss.str();
+void SvgEllipse::writeSvg(SvgWriter& writer) const {
+    writer.write("<ellipse");
+    writer.writeAttribute("cx", m_center.x);
+    writer.writeAttribute("cy", m_center.y);
+    writer.writeAttribute("rx", m_rx);
+    writer.writeAttribute("ry", m_ry);
+    writeCommonAttributes(writer);
+    writer.write(" />");
+}
+
+BoundingBox SvgEllipse::getBoundingBox() const {
+    return {m_center.x - m_rx, m_center.y - m_ry, m_center.x + m_rx, m_center.y + m_ry};
 }
 
 // SvgPolygon    
-SvgPolygon::SvgPolygon(const std::vector<Point>& pts) : m_points(pts) {
-    qCInfo(svgShapesLog) << "Creating Polygon element with " + QString::fromStdString(std::to_string(pts.size())) + " points";
+SvgPolygon::SvgPolygon(std::vector<Point> pts) : m_points(std::move(pts)) {
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Polygon {} created with {} points", this, m_points.size());
 }
 
 void SvgPolygon::setPoints(const std::vector<Point>& pts) {
-    qCInfo(svgShapesLog) << "Updating Polygon points: from " + QString::fromStdString(std::to_string(m_points.size())) + " points to " + QString::fromStdString(std::to_string(pts.size())) + " points";
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Polygon {} points {} -> {}", this, m_points.size(), pts.size());
     m_points = pts;
+    markChanged();
 }
 
 void SvgPolygon::addPoint(const Point& p) {
-    qCInfo(svgShapesLog) << "Adding point (" + QString::fromStdString(std::to_string(p.x)) + "," + QString::fromStdString(std::to_string(p.y)) + ") to Polygon";
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Polygon {} point added: ({}, {})", this, p.x, p.y);
     m_points.push_back(p);
+    markChanged();
 }
 
-std::string SvgPolygon::toSvgString() const {
-    std::stringstream ss;
-    ss << "<polygon points=\"";
-    for (size_t i = 0; i < m_points.size(); ++i) {
-        ss << m_points[i].x << "," << m_points[i].y << (i == m_points.size() - 1 ? "" : " ");
-    }
-    ss << "\"" << getCommonAttributesString() << " />";
-    return ss.str();
+void SvgPolygon::writeSvg(SvgWriter& writer) const {
+    writer.write("<polygon points=\"");
+    writePoints(writer, m_points);
+    writer.write('"');
+    writeCommonAttributes(writer);
+    writer.write(" />");
+}
+
+BoundingBox SvgPolygon::getBoundingBox() const {
+    return BoundingBox::fromPoints(m_points);
 }
 
 // SvgPolyline    
-SvgPolyline::SvgPolyline(const std::vector<Point>& pts) : m_points(pts) {
-    qCInfo(svgShapesLog) << "Creating Polyline element with " + QString::fromStdString(std::to_string(pts.size())) + " points";
+SvgPolyline::SvgPolyline(std::vector<Point> pts) : m_points(std::move(pts)) {
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Polyline {} created with {} points", this, m_points.size());
 }
 
 void SvgPolyline::setPoints(const std::vector<Point>& pts) {
-    qCInfo(svgShapesLog) << "Updating Polyline points: from " + QString::fromStdString(std::to_string(m_points.size())) + " points to " + QString::fromStdString(std::to_string(pts.size())) + " points";
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Polyline {} points {} -> {}", this, m_points.size(), pts.size());
     m_points = pts;
+    markChanged();
 }
 
 void SvgPolyline::addPoint(const Point& p) {
-    qCInfo(svgShapesLog) << "Adding point (" + QString::fromStdString(std::to_string(p.x)) + "," + QString::fromStdString(std::to_string(p.y)) + ") to Polyline";
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Polyline {} point added: ({}, {})", this, p.x, p.y);
     m_points.push_back(p);
+    markChanged();
 }
 
-std::string SvgPolyline::toSvgString() const {
-    std::stringstream ss;
+void SvgPolyline::writeSvg(SvgWriter& writer) const {
+    writer.write("<polyline points=\"");
+    writePoints(writer, m_points);
+    writer.write('"');
     // Polyline 通常没有填充，只有边框
-    std::string commonAttrs = getCommonAttributesString();
-    // 查找并替换 fill 属性为 "none"
-    size_t fillPos = commonAttrs.find(" fill=");
-    std::string fillAttr = " fill=\"none\"";
-    if (fillPos != std::string::npos) {
-        size_t fillEndPos = commonAttrs.find("\"", fillPos + strlen(" fill=\""));
-        if (fillEndPos != std::string::npos) {
-            commonAttrs.replace(fillPos, fillEndPos - fillPos + 1, fillAttr);
-        }
-    } else {
-        commonAttrs += fillAttr; // 如果原来没有fill属性，则添加 fill="none"
-    }
+    writeCommonAttributes(writer, true);
+    writer.write(" />");
+}
 
-    ss << "<polyline points=\"";
-    for (size_t i = 0; i < m_points.size(); ++i) {
-        ss << m_points[i].x << "," << m_points[i].y << (i == m_points.size() - 1 ? "" : " ");
-    }
-    ss << "\"" << commonAttrs << " />";
-    return ss.str();
+BoundingBox SvgPolyline::getBoundingBox() const {
+    return BoundingBox::fromPoints(m_points);
 }
 
 // SvgPentagon    
 SvgPentagon::SvgPentagon(Point center, double radius) {
-    qCInfo(svgShapesLog) << "Creating Pentagon element: center=(" + QString::fromStdString(std::to_string(center.x)) + "," + QString::fromStdString(std::to_string(center.y)) + "), radius=" + QString::fromStdString(std::to_string(radius));
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Pentagon {} created: center ({}, {}), r={}", this, center.x, center.y, radius);
     
     m_points.resize(5);
     for (int i = 0; i < 5; ++i) {
@@ -209,7 +248,7 @@ SvgPentagon::SvgPentagon(Point center, double radius) {
 
 // SvgHexagon    
 SvgHexagon::SvgHexagon(Point center, double radius) {
-    qCInfo(svgShapesLog) << "Creating Hexagon element: center=(" + QString::fromStdString(std::to_string(center.x)) + "," + QString::fromStdString(std::to_string(center.y)) + "), radius=" + QString::fromStdString(std::to_string(radius));
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Hexagon {} created: center ({}, {}), r={}", this, center.x, center.y, radius);
         
     m_points.resize(6);
     for (int i = 0; i < 6; ++i) {
@@ -222,10 +261,7 @@ SvgHexagon::SvgHexagon(Point center, double radius) {
 
 // SvgStar    
 SvgStar::SvgStar(Point center, double outerRadius, double innerRadius, int numPoints, double startAngleDeg) {
-    qCInfo(svgShapesLog) << "Creating Star element: center=(" + QString::fromStdString(std::to_string(center.x)) + "," + QString::fromStdString(std::to_string(center.y)) + 
-        "), outerRadius=" + QString::fromStdString(std::to_string(outerRadius)) + 
-        ", innerRadius=" + QString::fromStdString(std::to_string(innerRadius)) + 
-        ", points=" + QString::fromStdString(std::to_string(numPoints));
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Star {} created: center ({}, {}), r={}/{}, {} points", this, center.x, center.y, outerRadius, innerRadius, numPoints);
         
     // Minimum 2 points required for star geometry
     if (numPoints < 2) return;
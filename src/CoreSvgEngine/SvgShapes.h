@@ -13,7 +13,9 @@ public:
     SvgLine(Point start = {0,0}, Point end = {0,0}); 
     
     SvgElementType getType() const override { return SvgElementType::Line; }
-    std::string toSvgString() const override;
+    std::unique_ptr<SvgElement> clone() const override { return std::make_unique<SvgLine>(*this); }
+    void writeSvg(SvgWriter& writer) const override;
+    BoundingBox getBoundingBox() const override;
 
     Point getP1() const { return m_p1; } 
     void setP1(const Point& p);
@@ -34,7 +36,9 @@ public:
     SvgRectangle(Point tl = {0,0}, double w = 0, double h = 0, double rx_ = 0.0, double ry_ = 0.0);
     
     SvgElementType getType() const override { return SvgElementType::Rectangle; }
-    std::string toSvgString() const override;
+    std::unique_ptr<SvgElement> clone() const override { return std::make_unique<SvgRectangle>(*this); }
+    void writeSvg(SvgWriter& writer) const override;
+    BoundingBox getBoundingBox() const override;
 
     Point getTopLeft() const { return m_topLeft; } 
     void setTopLeft(const Point& p);
@@ -61,7 +65,9 @@ public:
     SvgCircle(Point c = {0,0}, double r = 0);
     
     SvgElementType getType() const override { return SvgElementType::Circle; }
-    std::string toSvgString() const override;
+    std::unique_ptr<SvgElement> clone() const override { return std::make_unique<SvgCircle>(*this); }
+    void writeSvg(SvgWriter& writer) const override;
+    BoundingBox getBoundingBox() const override;
 
     Point getCenter() const { return m_center; } 
     void setCenter(const Point& c);
@@ -80,7 +86,9 @@ public:
     SvgEllipse(Point c = {0,0}, double r_x = 0, double r_y = 0);
     
     SvgElementType getType() const override { return SvgElementType::Ellipse; }
-    std::string toSvgString() const override;
+    std::unique_ptr<SvgElement> clone() const override { return std::make_unique<SvgEllipse>(*this); }
+    void writeSvg(SvgWriter& writer) const override;
+    BoundingBox getBoundingBox() const override;
 
     Point getCenter() const { return m_center; } 
     void setCenter(const Point& c);
@@ -98,10 +106,13 @@ protected:
     std::vector<Point> m_points;
 
 public:
-    SvgPolygon(const std::vector<Point>& pts = {});
+    SvgPolygon(std::vector<Point> pts = {});
     
     SvgElementType getType() const override { return SvgElementType::Polygon; }
-    std::string toSvgString() const override;
+    std::unique_ptr<SvgElement> clone() const override { return std::make_unique<SvgPolygon>(*this); }
+    void writeSvg(SvgWriter& writer) const override;
+    BoundingBox getBoundingBox() const override;
+    std::size_t getOwnedMemoryUsage() const override { return m_points.capacity() * sizeof(Point); }
 
     const std::vector<Point>& getPoints() const { return m_points; }
     void setPoints(const std::vector<Point>& pts);
@@ -115,10 +126,13 @@ private:
     std::vector<Point> m_points;
 
 public: 
-    SvgPolyline(const std::vector<Point>& pts = {});
+    SvgPolyline(std::vector<Point> pts = {});
     
     SvgElementType getType() const override { return SvgElementType::Polyline; }
-    std::string toSvgString() const override;
+    std::unique_ptr<SvgElement> clone() const override { return std::make_unique<SvgPolyline>(*this); }
+    void writeSvg(SvgWriter& writer) const override;
+    BoundingBox getBoundingBox() const override;
+    std::size_t getOwnedMemoryUsage() const override { return m_points.capacity() * sizeof(Point); }
 
     const std::vector<Point>& getPoints() const { return m_points; } 
     void setPoints(const std::vector<Point>& pts);
@@ -131,6 +145,7 @@ public:
     SvgPentagon(Point center = {0,0}, double radius = 0);
     
     SvgElementType getType() const override { return SvgElementType::Pentagon; }
+    std::unique_ptr<SvgElement> clone() const override { return std::make_unique<SvgPentagon>(*this); }
 };
 
 class SvgHexagon : public SvgPolygon {
@@ -138,6 +153,7 @@ public:
     SvgHexagon(Point center = {0,0}, double radius = 0);
     
     SvgElementType getType() const override { return SvgElementType::Hexagon; }
+    std::unique_ptr<SvgElement> clone() const override { return std::make_unique<SvgHexagon>(*this); }
 };
 
 class SvgStar : public SvgPolygon {
@@ -149,4 +165,5 @@ public:
     SvgElementType getType() const override { 
         return SvgElementType::Star; 
     }
+    std::unique_ptr<SvgElement> clone() const override { return std::make_unique<SvgStar>(*this); }
 };
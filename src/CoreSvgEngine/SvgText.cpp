@@ -1,25 +1,6 @@
 ﻿#include "svgtext.h"
-#include <sstream>
-#include <QLoggingCategory>
-Q_DECLARE_LOGGING_CATEGORY(svgTextLog)
-Q_LOGGING_CATEGORY(svgTextLog, "SvgText")
-
-// XML character escaping required for proper SVG text content
-std::string escapeXmlChars(const std::string& input) {
-    std::string result;
-    result.reserve(input.size());
-    for (char c : input) {
-        switch (c) {
-            case '<': result += "&lt;"; break;
-            case '>': result += "&gt;"; break;
-            case '&': result += "&amp;"; break;
-            case '"': result += "&quot;"; break;
-            case '\'': result += "&apos;"; break;
-            default: result += c; break;
-        }
-    }
-    return result;
-}
+#include "svgwriter.h"
+#include "svgtrace.h"
 
 std::string SvgText::textAnchorToString(TextAnchor anchor) {
     switch (anchor) {
@@ -33,91 +14,88 @@ std::string SvgText::textAnchorToString(TextAnchor anchor) {
 SvgText::SvgText(Point pos, const std::string& text) :
     m_position(pos), m_textContent(text), m_fontFamily("Arial"), m_fontSize(12.0),
     m_fontBold(false), m_fontItalic(false), m_textAnchor(TextAnchor::Start) {
-    qCInfo(svgTextLog) << "Creating Text element: position=(" +
-        QString::fromStdString(std::to_string(pos.x)) + "," +
-        QString::fromStdString(std::to_string(pos.y)) +
-        "), content=\"" + QString::fromStdString(text) +
-        "\", font-family=\"Arial\", font-size=12.0";
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Text {} created: ({}, {}), {} bytes", this, pos.x, pos.y, text.size());
     // Text elements typically have fill but no stroke for better readability
     setFillColor({0,0,0,255});
     setStrokeColor({0,0,0,0});
     setStrokeWidth(0);
 }
 
-std::string SvgText::toSvgString() const {
-    std::stringstream ss;
-    ss << "<text x=\"" << m_position.x << "\" y=\"" << m_position.y << "\"";
-    ss << " font-family=\"" << m_fontFamily << "\"";
-    ss << " font-size=\"" << m_fontSize << "\"";
+void SvgText::writeSvg(SvgWriter& writer) const {
+    writer.write("<text");
+    writer.writeAttribute("x", m_position.x);
+    writer.writeAttribute("y", m_position.y);
+    writer.writeAttribute("font-family", m_fontFamily);
+    writer.writeAttribute("font-size", m_fontSize);
 
     if (m_fontBold) {
-        ss << " font-weight=\"bold\"";
+        writer.write(" font-weight=\"bold\"");
     }
 
     if (m_fontItalic) {
-        ss << " font-style=\"italic\"";
+        writer.write(" font-style=\"italic\"");
     }
 
     // Only output text-anchor when different from SVG default
     if (m_textAnchor != TextAnchor::Start) {
-        ss << " text-anchor=\"" << textAnchorToString(m_textAnchor) << "\"";
+        writer.writeAttribute("text-anchor", textAnchorToString(m_textAnchor));
     }
 
-    ss << getCommonAttributesString();
+    writeCommonAttributes(writer);
     // Escape special characters to prevent XML parsing errors
-    ss << ">" << escapeXmlChars(m_textContent) << "</text>";
-    return ss.str();
+    writer.write('>');
+    writer.writeEscaped(m_textContent);
+    writer.write("</text>");
+}
+
+BoundingBox SvgText::getBoundingBox() const {
+    // Estimate without font metrics: up to one em per character, in either
+    // direction so every text-anchor is covered, and one em above and below
+    // the baseline
+    double width = m_fontSize * static_cast<double>(m_textContent.size());
+    return {m_position.x - width, m_position.y - m_fontSize, m_position.x + width, m_position.y + m_fontSize};
 }
 
 void SvgText::setPosition(const Point& p) {
-    qCInfo(svgTextLog) << "Setting Text position: (" +
-        QString::fromStdString(std::to_string(m_position.x)) + "," +
-        QString::fromStdString(std::to_string(m_position.y)) + ") to (" +
-        QString::fromStdString(std::to_string(p.x)) + "," +
-        QString::fromStdString(std::to_string(p.y)) + ")";
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Text {} position ({}, {}) -> ({}, {})", this, m_position.x, m_position.y, p.x, p.y);
     m_position = p;
+    markChanged();
 }
 
 void SvgText::setTextContent(const std::string& text) {
-    qCInfo(svgTextLog) << "Setting Text content: \"" +
-        QString::fromStdString(m_textContent) + "\" to \"" +
-        QString::fromStdString(text) + "\"";
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Text {} content {} -> {} bytes", this, m_textContent.size(), text.size());
     m_textContent = text;
+    markChanged();
 }
 
 void SvgText::setFontFamily(const std::string& family) {
-    qCInfo(svgTextLog) << "Setting Text font-family: \"" +
-        QString::fromStdString(m_fontFamily) + "\" to \"" +
-        QString::fromStdString(family) + "\"";
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Text {} font-family set, {} bytes", this, family.size());
     m_fontFamily = family;
+    markChanged();
 }
 
 void SvgText::setFontSize(double size) {
     // Minimum font size prevents invisible text
     double newSize = (size > 0 ? size : 1.0);
-    qCInfo(svgTextLog) << "Setting Text font-size: " +
-        QString::fromStdString(std::to_string(m_fontSize)) + " to " +
-        QString::fromStdString(std::to_string(newSize));
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Text {} font-size {} -> {}", this, m_fontSize, newSize);
     m_fontSize = newSize;
+    markChanged();
 }
 
 void SvgText::setBold(bool bold) {
-    qCInfo(svgTextLog) << "Setting Text font-weight: " +
-        QString::fromStdString(m_fontBold ? "bold" : "normal") + " to " +
-        QString::fromStdString(bold ? "bold" : "normal");
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Text {} bold {} -> {}", this, m_fontBold, bold);
     m_fontBold = bold;
+    markChanged();
 }
 
 void SvgText::setItalic(bool italic) {
-    qCInfo(svgTextLog) << "Setting Text font-style: " +
-        QString::fromStdString(m_fontItalic ? "italic" : "normal") + " to " +
-        QString::fromStdString(italic ? "italic" : "normal");
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Text {} italic {} -> {}", this, m_fontItalic, italic);
     m_fontItalic = italic;
+    markChanged();
 }
 
 void SvgText::setTextAnchor(TextAnchor anchor) {
-    qCInfo(svgTextLog) << "Setting Text text-anchor: " +
-        QString::fromStdString(textAnchorToString(m_textAnchor)) + " to " +
-        QString::fromStdString(textAnchorToString(anchor));
+    SVG_TRACE(SVG_TRACE_ELEMENT, "Text {} text-anchor {} -> {}", this, m_textAnchor, anchor);
     m_textAnchor = anchor;
+    markChanged();
 }
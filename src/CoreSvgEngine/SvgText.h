@@ -22,7 +22,12 @@ public:
     SvgText(Point pos = {0,0}, const std::string& text = "");
 
     SvgElementType getType() const override { return SvgElementType::Text; }
-    std::string toSvgString() const override;
+    std::unique_ptr<SvgElement> clone() const override { return std::make_unique<SvgText>(*this); }
+    void writeSvg(SvgWriter& writer) const override;
+    BoundingBox getBoundingBox() const override;
+    std::size_t getOwnedMemoryUsage() const override {
+        return svgHeapBytes(m_textContent) + svgHeapBytes(m_fontFamily);
+    }
 
     // ---------- Getter & Setter ----------
 
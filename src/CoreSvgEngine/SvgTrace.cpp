@@ -0,0 +1,228 @@
+﻿#include "svgtrace.h"
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> svgTraceActive{false};
+
+// Records per thread; a power of two so the slot is a mask of the write index
+static constexpr size_t TRACE_CAPACITY = 2048;
+
+// Every field is atomic so the dump can read a slot while its owner rewrites
+// it. `sequence` works as a per-slot seqlock: 2n+1 while record n is being
+// written, 2n+2 once it is complete.
+struct TraceRecord {
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<uint64_t> timestamp{0};
+    std::atomic<const char*> format{nullptr};
+    // Argument count in the low byte, then one SvgTraceType byte per argument
+    std::atomic<uint64_t> types{0};
+    static_assert(SVG_TRACE_MAX_ARGS < sizeof(uint64_t), "types has no byte left for another argument");
+    std::atomic<uint64_t> args[SVG_TRACE_MAX_ARGS];
+};
+
+struct TraceBuffer {
+    // Records written so far; only the owning thread advances it
+    std::atomic<uint64_t> head{0};
+    size_t index = 0;
+    TraceRecord records[TRACE_CAPACITY];
+};
+
+// Buffers outlive their threads so a dump still shows what a finished worker
+// did; a new thread picks up a released buffer before a fresh one is made.
+// Intentionally leaked, as threads may exit during static destruction.
+struct TraceRegistry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<TraceBuffer>> buffers;
+    std::vector<TraceBuffer*> released;
+};
+
+static TraceRegistry& traceRegistry() {
+    static TraceRegistry* registry = new TraceRegistry;
+    return *registry;
+}
+
+// Records stamped before this are hidden by svgTraceClear()
+static std::atomic<uint64_t> clearedBefore{0};
+
+static uint64_t traceNow() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+struct ThreadTraceBuffer {
+    TraceBuffer* buffer = nullptr;
+
+    ~ThreadTraceBuffer() {
+        if (buffer) {
+            TraceRegistry& registry = traceRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            registry.released.push_back(buffer);
+            buffer = nullptr;
+        }
+    }
+};
+
+static thread_local ThreadTraceBuffer threadTrace;
+
+static TraceBuffer* acquireTraceBuffer() {
+    TraceRegistry& registry = traceRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if (!registry.released.empty()) {
+        TraceBuffer* buffer = registry.released.back();
+        registry.released.pop_back();
+        return buffer;
+    }
+    registry.buffers.push_back(std::make_unique<TraceBuffer>());
+    registry.buffers.back()->index = registry.buffers.size() - 1;
+    return registry.buffers.back().get();
+}
+
+void svgTraceSetEnabled(bool enabled) {
+    svgTraceActive.store(enabled, std::memory_order_relaxed);
+}
+
+void svgTraceWrite(const char* format, const SvgTraceValue* values, size_t count) {
+    TraceBuffer* buffer = threadTrace.buffer;
+    if (!buffer) {
+        buffer = threadTrace.buffer = acquireTraceBuffer();
+    }
+
+    uint64_t index = buffer->head.load(std::memory_order_relaxed);
+    TraceRecord& record = buffer->records[index & (TRACE_CAPACITY - 1)];
+    uint64_t types = count;
+    for (size_t i = 0; i < count; ++i) {
+        types |= static_cast<uint64_t>(values[i].type) << (8 * (i + 1));
+    }
+
+    record.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    record.timestamp.store(traceNow(), std::memory_order_relaxed);
+    record.format.store(format, std::memory_order_relaxed);
+    record.types.store(types, std::memory_order_relaxed);
+    for (size_t i = 0; i < count; ++i) {
+        record.args[i].store(values[i].bits, std::memory_order_relaxed);
+    }
+    record.sequence.store(2 * index + 2, std::memory_order_release);
+    buffer->head.store(index + 1, std::memory_order_release);
+}
+
+void svgTraceClear() {
+    clearedBefore.store(traceNow(), std::memory_order_relaxed);
+}
+
+// A consistent copy of one record, taken by svgTraceDump()
+struct TraceEntry {
+    uint64_t timestamp;
+    size_t thread;
+    const char* format;
+    uint64_t types;
+    uint64_t args[SVG_TRACE_MAX_ARGS];
+};
+
+static bool readTraceRecord(const TraceRecord& record, uint64_t index, TraceEntry& entry) {
+    uint64_t before = record.sequence.load(std::memory_order_acquire);
+    if (before != 2 * index + 2) {
+        return false;
+    }
+    entry.timestamp = record.timestamp.load(std::memory_order_relaxed);
+    entry.format = record.format.load(std::memory_order_relaxed);
+    entry.types = record.types.load(std::memory_order_relaxed);
+    size_t count = std::min<size_t>(entry.types & 0xff, SVG_TRACE_MAX_ARGS);
+    for (size_t i = 0; i < count; ++i) {
+        entry.args[i] = record.args[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return record.sequence.load(std::memory_order_relaxed) == before;
+}
+
+static void appendTraceValue(std::string& out, SvgTraceType type, uint64_t bits) {
+    char text[64];
+    switch (type) {
+    case SvgTraceType::Int:
+        std::snprintf(text, sizeof(text), "%" PRId64, static_cast<int64_t>(bits));
+        break;
+    case SvgTraceType::UInt:
+        std::snprintf(text, sizeof(text), "%" PRIu64, bits);
+        break;
+    case SvgTraceType::Double: {
+        double number;
+        std::memcpy(&number, &bits, sizeof(number));
+        std::snprintf(text, sizeof(text), "%g", number);
+        break;
+    }
+    case SvgTraceType::Pointer:
+        std::snprintf(text, sizeof(text), "0x%" PRIx64, bits);
+        break;
+    case SvgTraceType::String:
+        out += reinterpret_cast<const char*>(static_cast<uintptr_t>(bits));
+        return;
+    case SvgTraceType::Color:
+        std::snprintf(text, sizeof(text), "rgba(%u,%u,%u,%u)", static_cast<unsigned>(bits >> 24) & 0xff,
+                      static_cast<unsigned>(bits >> 16) & 0xff, static_cast<unsigned>(bits >> 8) & 0xff,
+                      static_cast<unsigned>(bits) & 0xff);
+        break;
+    default:
+        out += "?";
+        return;
+    }
+    out += text;
+}
+
+static void appendTraceEntry(std::string& out, const TraceEntry& entry, uint64_t origin) {
+    char prefix[64];
+    std::snprintf(prefix, sizeof(prefix), "%12.6f ms  t%zu  ",
+                  static_cast<double>(entry.timestamp - origin) / 1e6, entry.thread);
+    out += prefix;
+
+    size_t count = std::min<size_t>(entry.types & 0xff, SVG_TRACE_MAX_ARGS);
+    size_t next = 0;
+    for (const char* p = entry.format; *p; ++p) {
+        if (p[0] == '{' && p[1] == '}' && next < count) {
+            appendTraceValue(out, static_cast<SvgTraceType>((entry.types >> (8 * (next + 1))) & 0xff), entry.args[next]);
+            ++next;
+            ++p;
+        } else {
+            out += *p;
+        }
+    }
+    out += '\n';
+}
+
+std::string svgTraceDump() {
+    std::vector<TraceEntry> entries;
+    uint64_t cleared = clearedBefore.load(std::memory_order_relaxed);
+    {
+        // Keeps the buffer list stable; writers never take this lock
+        TraceRegistry& registry = traceRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (const auto& buffer : registry.buffers) {
+            uint64_t head = buffer->head.load(std::memory_order_acquire);
+            uint64_t first = head > TRACE_CAPACITY ? head - TRACE_CAPACITY : 0;
+            for (uint64_t index = first; index < head; ++index) {
+                TraceEntry entry;
+                entry.thread = buffer->index;
+                if (readTraceRecord(buffer->records[index & (TRACE_CAPACITY - 1)], index, entry) &&
+                    entry.timestamp >= cleared) {
+                    entries.push_back(entry);
+                }
+            }
+        }
+    }
+
+    std::stable_sort(entries.begin(), entries.end(), [](const TraceEntry& a, const TraceEntry& b) {
+        return a.timestamp < b.timestamp;
+    });
+
+    std::string out;
+    out.reserve(entries.size() * 80);
+    uint64_t origin = entries.empty() ? 0 : entries.front().timestamp;
+    for (const TraceEntry& entry : entries) {
+        appendTraceEntry(out, entry, origin);
+    }
+    return out;
+}
@@ -0,0 +1,111 @@
+﻿#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include "coresvgstructs.h"
+
+// Low-overhead event tracing for hot paths such as element setters and parsing.
+//
+// A trace call copies its arguments as raw 64-bit values into a fixed-size
+// ring buffer owned by the calling thread; nothing is formatted, allocated or
+// locked on the way in. The format string is kept by pointer and only expanded
+// by svgTraceDump(), so it must be a string literal, and so must any const
+// char* argument. Once a thread's ring is full its oldest records are
+// overwritten.
+
+// Compile-time ceiling: SVG_TRACE calls above this level generate no code
+#ifndef SVG_TRACE_LEVEL
+#define SVG_TRACE_LEVEL 2
+#endif
+
+// Once per document-level change, e.g. resizing the canvas
+#define SVG_TRACE_DOCUMENT 1
+// Once per element: constructors, setters, insertion and removal
+#define SVG_TRACE_ELEMENT 2
+
+// SVG_TRACE(level, "Line {} start -> ({}, {})", this, p.x, p.y); each {} takes
+// the next argument. Arguments must be integers, enums, floating point,
+// pointers, string literals or Colors.
+#define SVG_TRACE(level, ...)                          \
+    do {                                               \
+        if constexpr ((level) <= SVG_TRACE_LEVEL) {    \
+            svgTrace(__VA_ARGS__);                     \
+        }                                              \
+    } while (0)
+
+// A record packs the argument count and one type byte per argument into a
+// single 64-bit word, which leaves room for seven
+static constexpr size_t SVG_TRACE_MAX_ARGS = 7;
+
+enum class SvgTraceType : uint8_t {
+    None,
+    Int,
+    UInt,
+    Double,
+    Pointer,
+    String,
+    Color
+};
+
+struct SvgTraceValue {
+    SvgTraceType type = SvgTraceType::None;
+    uint64_t bits = 0;
+};
+
+template <typename T>
+SvgTraceValue svgTraceValue(const T& value) {
+    if constexpr (std::is_same_v<T, Color>) {
+        // One byte per channel, which is what the editor ever produces
+        uint64_t rgba = (static_cast<uint64_t>(value.r & 0xff) << 24) | (static_cast<uint64_t>(value.g & 0xff) << 16) |
+                        (static_cast<uint64_t>(value.b & 0xff) << 8) | static_cast<uint64_t>(value.alpha & 0xff);
+        return {SvgTraceType::Color, rgba};
+    } else if constexpr (std::is_same_v<T, bool>) {
+        return {SvgTraceType::UInt, value ? 1u : 0u};
+    } else if constexpr (std::is_enum_v<T>) {
+        return {SvgTraceType::Int, static_cast<uint64_t>(static_cast<int64_t>(value))};
+    } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+        return {SvgTraceType::Int, static_cast<uint64_t>(static_cast<int64_t>(value))};
+    } else if constexpr (std::is_integral_v<T>) {
+        return {SvgTraceType::UInt, static_cast<uint64_t>(value)};
+    } else if constexpr (std::is_floating_point_v<T>) {
+        double number = static_cast<double>(value);
+        uint64_t bits;
+        std::memcpy(&bits, &number, sizeof(bits));
+        return {SvgTraceType::Double, bits};
+    } else if constexpr (std::is_convertible_v<const T&, const char*>) {
+        return {SvgTraceType::String, reinterpret_cast<uintptr_t>(static_cast<const char*>(value))};
+    } else if constexpr (std::is_pointer_v<T>) {
+        return {SvgTraceType::Pointer, reinterpret_cast<uintptr_t>(value)};
+    } else {
+        static_assert(!sizeof(T), "unsupported SVG_TRACE argument type");
+    }
+}
+
+// Runtime switch, off until a tool asks for a trace; when off a trace call costs
+// one relaxed load
+extern std::atomic<bool> svgTraceActive;
+inline bool svgTraceEnabled() { return svgTraceActive.load(std::memory_order_relaxed); }
+void svgTraceSetEnabled(bool enabled);
+
+void svgTraceWrite(const char* format, const SvgTraceValue* values, size_t count);
+
+template <typename... Args>
+inline void svgTrace(const char* format, const Args&... args) {
+    static_assert(sizeof...(Args) <= SVG_TRACE_MAX_ARGS, "too many SVG_TRACE arguments");
+    if (!svgTraceEnabled()) {
+        return;
+    }
+    const SvgTraceValue values[sizeof...(Args) + 1] = {svgTraceValue(args)...};
+    svgTraceWrite(format, values, sizeof...(Args));
+}
+
+// Formats the records still buffered on every thread, oldest first, one per
+// line. The editor writes it to $SVGEDITOR_TRACE_FILE on exit when that is
+// set. Safe to call while other threads keep tracing; records overwritten
+// during the dump are skipped.
+std::string svgTraceDump();
+// Hides everything recorded so far from later dumps
+void svgTraceClear();
@@ -0,0 +1,149 @@
+﻿#include "coresvgstructs.h"
+#include "svgnumberparser.h"
+#include <charconv>
+#include <cmath>
+
+static constexpr double DEGREES_TO_RADIANS = 3.14159265358979323846 / 180.0;
+
+void Transform::rotate(double angle, double cx, double cy) {
+    double radians = angle * DEGREES_TO_RADIANS;
+    double cosine = std::cos(radians);
+    double sine = std::sin(radians);
+    translate(cx, cy);
+    multiply(cosine, sine, -sine, cosine, 0, 0);
+    translate(-cx, -cy);
+}
+
+void Transform::skewX(double angle) {
+    multiply(1, 0, std::tan(angle * DEGREES_TO_RADIANS), 1, 0, 0);
+}
+
+void Transform::skewY(double angle) {
+    multiply(1, std::tan(angle * DEGREES_TO_RADIANS), 0, 1, 0, 0);
+}
+
+static bool isTransformSeparator(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r' || ch == ',';
+}
+
+static void skipTransformSeparators(std::string_view text, std::size_t& pos) {
+    while (pos < text.size() && isTransformSeparator(text[pos])) {
+        ++pos;
+    }
+}
+
+// Reads "(n n ...)" after an operation name into `args`; returns the argument count or -1
+static int parseTransformArguments(std::string_view text, std::size_t& pos, double (&args)[6]) {
+    while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r')) {
+        ++pos;
+    }
+    if (pos >= text.size() || text[pos] != '(') {
+        return -1;
+    }
+    ++pos;
+    int count = 0;
+    while (true) {
+        skipTransformSeparators(text, pos);
+        if (pos < text.size() && text[pos] == ')') {
+            ++pos;
+            return count;
+        }
+        if (count == 6 || !parseSvgNumber(text, pos, args[count])) {
+            return -1;
+        }
+        ++count;
+    }
+}
+
+bool Transform::parse(std::string_view text, Transform& transform) {
+    Transform result;
+    std::size_t pos = 0;
+    while (true) {
+        skipTransformSeparators(text, pos);
+        if (pos >= text.size()) {
+            break;
+        }
+        std::size_t nameStart = pos;
+        while (pos < text.size() && ((text[pos] >= 'a' && text[pos] <= 'z') || (text[pos] >= 'A' && text[pos] <= 'Z'))) {
+            ++pos;
+        }
+        std::string_view name = text.substr(nameStart, pos - nameStart);
+        double args[6] = {};
+        int count = parseTransformArguments(text, pos, args);
+        if (name == "matrix" && count == 6) {
+            result.multiply(args[0], args[1], args[2], args[3], args[4], args[5]);
+        } else if (name == "translate" && (count == 1 || count == 2)) {
+            result.translate(args[0], count == 2 ? args[1] : 0.0);
+        } else if (name == "scale" && (count == 1 || count == 2)) {
+            result.scale(args[0], count == 2 ? args[1] : args[0]);
+        } else if (name == "rotate" && (count == 1 || count == 3)) {
+            result.rotate(args[0], args[1], args[2]);
+        } else if (name == "skewX" && count == 1) {
+            result.skewX(args[0]);
+        } else if (name == "skewY" && count == 1) {
+            result.skewY(args[0]);
+        } else {
+            return false;
+        }
+    }
+    result.source = std::string(text);
+    transform = result;
+    return true;
+}
+
+// Shortest representation that parses back to the same double
+static void appendTransformNumber(std::string& out, double value) {
+    if (value == 0.0) {
+        value = 0.0; // no "-0"
+    }
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+static std::string formatTransform(const char* name, std::initializer_list<double> values) {
+    std::string out = name;
+    out += '(';
+    bool first = true;
+    for (double value : values) {
+        if (!first) {
+            out += ',';
+        }
+        appendTransformNumber(out, value);
+        first = false;
+    }
+    out += ')';
+    return out;
+}
+
+std::string Transform::toString() const {
+    if (isIdentity()) {
+        return std::string();
+    }
+    if (b == 0.0 && c == 0.0) {
+        if (a == 1.0 && d == 1.0) {
+            return f == 0.0 ? formatTransform("translate", {e}) : formatTransform("translate", {e, f});
+        }
+        if (e == 0.0 && f == 0.0) {
+            return a == d ? formatTransform("scale", {a}) : formatTransform("scale", {a, d});
+        }
+    }
+    // A pure rotation about the origin reads better as an angle, but only if it
+    // reproduces the matrix exactly
+    if (e == 0.0 && f == 0.0 && a == d && b == -c) {
+        double exact = std::atan2(b, a) / DEGREES_TO_RADIANS;
+        // atan2 tends to land an ulp off a round angle; prefer the rounded one
+        for (double angle : {std::round(exact * 1e9) / 1e9, exact}) {
+            Transform rotation;
+            rotation.rotate(angle);
+            if (rotation.a == a && rotation.b == b && rotation.c == c && rotation.d == d) {
+                return formatTransform("rotate", {angle});
+            }
+        }
+    }
+    return formatTransform("matrix", {a, b, c, d, e, f});
+}
+
+std::string Transform::toSvgString() const {
+    return source.empty() ? toString() : source;
+}
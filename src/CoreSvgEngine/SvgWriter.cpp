@@ -0,0 +1,106 @@
+﻿#include "svgwriter.h"
+#include <charconv>
+
+SvgWriter::SvgWriter(Sink sink, std::size_t flushThreshold)
+    : m_sink(std::move(sink)), m_flushThreshold(flushThreshold) {
+    m_buffer.reserve(flushThreshold + flushThreshold / 4);
+}
+
+SvgWriter::~SvgWriter() {
+    flush();
+}
+
+void SvgWriter::writeBlock(std::string_view block) {
+    if (!m_sink || block.size() < m_flushThreshold) {
+        write(block);
+        return;
+    }
+    flush();
+    if (m_ok && !m_sink(block)) {
+        m_ok = false;
+    }
+}
+
+void SvgWriter::writeNumber(double value) {
+    if (value == 0.0) {
+        value = 0.0; // no "-0"
+    }
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    write(std::string_view(buffer, result.ptr - buffer));
+}
+
+void SvgWriter::writeInteger(long long value) {
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    write(std::string_view(buffer, result.ptr - buffer));
+}
+
+void SvgWriter::writeEscaped(std::string_view text) {
+    std::size_t start = 0;
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        std::string_view entity;
+        switch (text[i]) {
+            case '<': entity = "&lt;"; break;
+            case '>': entity = "&gt;"; break;
+            case '&': entity = "&amp;"; break;
+            case '"': entity = "&quot;"; break;
+            case '\'': entity = "&apos;"; break;
+            default: continue;
+        }
+        m_buffer.append(text.substr(start, i - start));
+        m_buffer.append(entity);
+        start = i + 1;
+    }
+    m_buffer.append(text.substr(start));
+    flushIfFull();
+}
+
+void SvgWriter::writeColor(const Color& color) {
+    write(color.alpha == 255 ? "rgb(" : "rgba(");
+    writeInteger(color.r);
+    write(',');
+    writeInteger(color.g);
+    write(',');
+    writeInteger(color.b);
+    if (color.alpha != 255) {
+        write(',');
+        writeNumber(static_cast<double>(color.alpha) / 255.0);
+    }
+    write(')');
+}
+
+void SvgWriter::writeAttribute(std::string_view name, double value) {
+    write(' ');
+    write(name);
+    write("=\"");
+    writeNumber(value);
+    write('"');
+}
+
+void SvgWriter::writeAttribute(std::string_view name, std::string_view value) {
+    write(' ');
+    write(name);
+    write("=\"");
+    writeEscaped(value);
+    write('"');
+}
+
+void SvgWriter::writeAttribute(std::string_view name, const Color& color) {
+    write(' ');
+    write(name);
+    write("=\"");
+    writeColor(color);
+    write('"');
+}
+
+bool SvgWriter::flush() {
+    if (!m_sink || m_buffer.empty()) {
+        return m_ok;
+    }
+    if (m_ok && !m_sink(m_buffer)) {
+        m_ok = false;
+    }
+    m_buffer.clear();
+    return m_ok;
+}
@@ -0,0 +1,70 @@
+﻿#pragma once
+#include "coresvgstructs.h"
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+// Append-only text buffer that elements serialize into directly. Numbers are
+// written with std::to_chars in their shortest round-trip form. With a sink the
+// buffer is handed over whenever it passes the flush threshold, so a document
+// can be written out without ever holding all of it in memory.
+class SvgWriter {
+public:
+    // Receives each filled buffer; returning false marks the writer as failed
+    using Sink = std::function<bool(std::string_view)>;
+
+    // In-memory writer; the result is available from str()/takeString()
+    SvgWriter() = default;
+    explicit SvgWriter(Sink sink, std::size_t flushThreshold = DEFAULT_FLUSH_THRESHOLD);
+    ~SvgWriter();
+
+    SvgWriter(const SvgWriter&) = delete;
+    SvgWriter& operator=(const SvgWriter&) = delete;
+
+    void write(std::string_view text) {
+        m_buffer.append(text);
+        flushIfFull();
+    }
+    void write(char ch) {
+        m_buffer.push_back(ch);
+        flushIfFull();
+    }
+    // For large pre-rendered blocks: flushes what is buffered and hands the
+    // block to the sink without copying it; in-memory writers just append
+    void writeBlock(std::string_view block);
+    void writeNumber(double value);
+    void writeInteger(long long value);
+    // Escapes XML markup characters, for text content and attribute values
+    void writeEscaped(std::string_view text);
+    void writeColor(const Color& color);
+
+    // ` name="value"` with the value formatted or escaped as above
+    void writeAttribute(std::string_view name, double value);
+    void writeAttribute(std::string_view name, std::string_view value);
+    void writeAttribute(std::string_view name, const Color& color);
+
+    // Hands buffered text to the sink; a no-op for in-memory writers
+    bool flush();
+    // False once the sink has rejected a write
+    bool ok() const { return m_ok; }
+
+    const std::string& str() const { return m_buffer; }
+    std::string takeString() { return std::move(m_buffer); }
+    // Empties an in-memory writer for reuse, keeping its capacity
+    void clear() { m_buffer.clear(); }
+
+    static constexpr std::size_t DEFAULT_FLUSH_THRESHOLD = 64 * 1024;
+
+private:
+    void flushIfFull() {
+        if (m_sink && m_buffer.size() >= m_flushThreshold) {
+            flush();
+        }
+    }
+
+    std::string m_buffer;
+    Sink m_sink;
+    std::size_t m_flushThreshold = 0;
+    bool m_ok = true;
+};
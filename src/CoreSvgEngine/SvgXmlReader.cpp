@@ -0,0 +1,447 @@
+﻿#include "svgxmlreader.h"
+#include "svgnumberparser.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+namespace {
+
+bool isXmlSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool isNameEnd(char c) {
+    return isXmlSpace(c) || c == '/' || c == '>' || c == '=';
+}
+
+void appendUtf8(std::string& out, unsigned long cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+} // namespace
+
+// ---------- SvgXmlNode ----------
+
+SvgXmlNode::SvgXmlNode(const SvgXmlNode& other)
+    : name(other.name), attributes(other.attributes), text(other.text) {
+    if (other.m_storage) {
+        detach();
+    }
+}
+
+SvgXmlNode& SvgXmlNode::operator=(const SvgXmlNode& other) {
+    if (this != &other) {
+        name = other.name;
+        attributes = other.attributes;
+        text = other.text;
+        m_storage.reset();
+        if (other.m_storage) {
+            detach();
+        }
+    }
+    return *this;
+}
+
+const SvgXmlAttribute* SvgXmlNode::findAttribute(std::string_view attrName) const {
+    for (const auto& attr : attributes) {
+        if (attr.name == attrName) {
+            return &attr;
+        }
+    }
+    return nullptr;
+}
+
+std::string_view SvgXmlNode::attribute(std::string_view attrName) const {
+    const SvgXmlAttribute* attr = findAttribute(attrName);
+    return attr ? attr->value : std::string_view();
+}
+
+bool SvgXmlNode::queryDouble(std::string_view attrName, double& value) const {
+    const SvgXmlAttribute* attr = findAttribute(attrName);
+    return attr && parseDouble(attr->value, value);
+}
+
+bool SvgXmlNode::parseDouble(std::string_view text, double& value) {
+    size_t pos = 0;
+    while (pos < text.size() && isXmlSpace(text[pos])) ++pos;
+    return parseSvgNumber(text, pos, value);
+}
+
+void SvgXmlNode::detach() {
+    size_t total = name.size();
+    for (const auto& attr : attributes) {
+        total += attr.name.size() + attr.value.size();
+    }
+    auto storage = std::make_unique<char[]>(total > 0 ? total : 1);
+    char* out = storage.get();
+    auto keep = [&out](std::string_view view) {
+        std::memcpy(out, view.data(), view.size());
+        std::string_view kept(out, view.size());
+        out += view.size();
+        return kept;
+    };
+    name = keep(name);
+    for (auto& attr : attributes) {
+        attr.name = keep(attr.name);
+        attr.value = keep(attr.value);
+    }
+    m_storage = std::move(storage);
+}
+
+// ---------- SvgXmlReader ----------
+
+SvgXmlReader::SvgXmlReader(std::string_view content)
+    : m_data(content.data()), m_size(content.size()) {
+    // UTF-8 byte order mark carries no information for the parser
+    if (m_size >= 3 && std::memcmp(m_data, "\xEF\xBB\xBF", 3) == 0) {
+        m_pos = 3;
+    }
+}
+
+SvgXmlReader::SvgXmlReader(SvgByteSource source, std::size_t chunkSize)
+    : m_source(std::move(source)), m_chunkSize(chunkSize > 0 ? chunkSize : 64 * 1024), m_eof(false) {
+    if (require(3) && std::memcmp(m_data + m_pos, "\xEF\xBB\xBF", 3) == 0) {
+        m_pos += 3;
+    }
+}
+
+bool SvgXmlReader::fill() {
+    if (m_eof || !m_source) {
+        m_eof = true;
+        return false;
+    }
+    // Drop consumed bytes first; positions stay valid relative to m_pos
+    if (m_pos > 0) {
+        m_buffer.erase(0, m_pos);
+        m_consumed += m_pos;
+        m_pos = 0;
+    }
+    size_t oldSize = m_buffer.size();
+    m_buffer.resize(oldSize + m_chunkSize);
+    size_t read = m_source(m_buffer.data() + oldSize, m_chunkSize);
+    m_buffer.resize(oldSize + read);
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+    if (read == 0) {
+        m_eof = true;
+        return false;
+    }
+    return true;
+}
+
+bool SvgXmlReader::require(std::size_t count) {
+    while (m_size - m_pos < count) {
+        if (!fill()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SvgXmlReader::find(std::string_view pattern, std::size_t from, std::size_t& at) {
+    // `from` and `at` are relative to m_pos, which fill() may move
+    size_t searchFrom = from;
+    while (true) {
+        std::string_view window(m_data + m_pos, m_size - m_pos);
+        size_t found = window.find(pattern, searchFrom);
+        if (found != std::string_view::npos) {
+            at = found;
+            return true;
+        }
+        // Resume just before the old end so a pattern split across chunks is still found
+        size_t scanned = window.size();
+        searchFrom = scanned >= pattern.size() ? scanned - pattern.size() + 1 : 0;
+        if (searchFrom < from) searchFrom = from;
+        if (!fill()) {
+            return false;
+        }
+    }
+}
+
+bool SvgXmlReader::findTagEnd(std::size_t& at) {
+    // '>' may legally appear inside quoted attribute values
+    size_t i = 1;
+    char quote = 0;
+    while (true) {
+        for (; m_pos + i < m_size; ++i) {
+            char c = m_data[m_pos + i];
+            if (quote) {
+                if (c == quote) quote = 0;
+            } else if (c == '"' || c == '\'') {
+                quote = c;
+            } else if (c == '>') {
+                at = i;
+                return true;
+            }
+        }
+        if (!fill()) {
+            return false;
+        }
+    }
+}
+
+SvgXmlReader::Token SvgXmlReader::fail(const std::string& message) {
+    if (m_error.empty()) {
+        m_error = message + " at offset " + std::to_string(offset());
+    }
+    return Token::Error;
+}
+
+SvgXmlReader::Token SvgXmlReader::next() {
+    if (!m_error.empty()) {
+        return Token::Error;
+    }
+    m_node.attributes.clear();
+    m_text = {};
+
+    if (m_pendingEnd) {
+        // Synthesized end of an empty-element tag such as <rect ... />
+        m_pendingEnd = false;
+        m_nameStack.resize(m_nameOffsets.back());
+        m_nameOffsets.pop_back();
+        --m_depth;
+        return Token::EndElement;
+    }
+
+    while (true) {
+        if (m_pos >= m_size && !fill()) {
+            if (m_depth > 0) {
+                return fail("Unexpected end of document inside <" + m_nameStack.substr(m_nameOffsets.back()) + ">");
+            }
+            return Token::EndOfDocument;
+        }
+
+        if (m_data[m_pos] != '<') {
+            size_t lt = 0;
+            if (!find("<", 0, lt)) {
+                lt = m_size - m_pos;
+            }
+            std::string_view raw(m_data + m_pos, lt);
+            m_pos += lt;
+            // Character data outside the root element is insignificant
+            if (m_depth == 0) {
+                continue;
+            }
+            m_text = decode(raw, m_textScratch);
+            return Token::Text;
+        }
+
+        require(9);
+        std::string_view head(m_data + m_pos, std::min<size_t>(9, m_size - m_pos));
+        size_t end = 0;
+
+        if (head.substr(0, 4) == "<!--") {
+            if (!find("-->", 4, end)) return fail("Unterminated comment");
+            m_pos += end + 3;
+            continue;
+        }
+        if (head == "<![CDATA[") {
+            if (!find("]]>", 9, end)) return fail("Unterminated CDATA section");
+            m_text = std::string_view(m_data + m_pos + 9, end - 9);
+            m_pos += end + 3;
+            if (m_depth == 0) continue;
+            return Token::Text;
+        }
+        if (head.substr(0, 2) == "<?") {
+            if (!find("?>", 2, end)) return fail("Unterminated processing instruction");
+            m_pos += end + 2;
+            continue;
+        }
+        if (head.substr(0, 2) == "<!") {
+            // DOCTYPE, possibly with an internal subset in brackets
+            size_t close = 0;
+            if (!find(">", 2, close)) return fail("Unterminated declaration");
+            // Only look before the first '>': searching further would buffer the rest of the stream
+            size_t bracket = std::string_view(m_data + m_pos, close).find('[', 2);
+            if (bracket != std::string_view::npos) {
+                if (!find("]", bracket, end) || !find(">", end, close)) return fail("Unterminated DOCTYPE");
+            }
+            m_pos += close + 1;
+            continue;
+        }
+
+        // findTagEnd() may refill the buffer, which invalidates `head`
+        bool endTag = head.substr(0, 2) == "</";
+        if (!findTagEnd(end)) {
+            return fail("Unterminated tag");
+        }
+        if (endTag) {
+            return readEndTag(end);
+        }
+        return readStartTag(end);
+    }
+}
+
+SvgXmlReader::Token SvgXmlReader::readStartTag(std::size_t end) {
+    const char* tag = m_data + m_pos;
+    size_t i = 1;
+    while (i < end && !isNameEnd(tag[i])) ++i;
+    if (i == 1) {
+        return fail("Missing element name");
+    }
+    m_node.name = std::string_view(tag + 1, i - 1);
+
+    bool selfClosing = tag[end - 1] == '/';
+    size_t attrEnd = selfClosing ? end - 1 : end;
+    size_t decodedSize = 0;
+
+    while (true) {
+        while (i < attrEnd && isXmlSpace(tag[i])) ++i;
+        if (i >= attrEnd) break;
+
+        size_t nameStart = i;
+        while (i < attrEnd && !isNameEnd(tag[i])) ++i;
+        std::string_view attrName(tag + nameStart, i - nameStart);
+        while (i < attrEnd && isXmlSpace(tag[i])) ++i;
+        if (attrName.empty() || i >= attrEnd || tag[i] != '=') {
+            return fail("Malformed attribute in <" + std::string(m_node.name) + ">");
+        }
+        ++i;
+        while (i < attrEnd && isXmlSpace(tag[i])) ++i;
+        if (i >= attrEnd || (tag[i] != '"' && tag[i] != '\'')) {
+            return fail("Unquoted attribute value in <" + std::string(m_node.name) + ">");
+        }
+        char quote = tag[i++];
+        size_t valueStart = i;
+        while (i < attrEnd && tag[i] != quote) ++i;
+        if (i >= attrEnd) {
+            return fail("Unterminated attribute value in <" + std::string(m_node.name) + ">");
+        }
+        std::string_view value(tag + valueStart, i - valueStart);
+        ++i;
+
+        if (value.find('&') != std::string_view::npos) {
+            decodedSize += value.size();
+        }
+        m_node.attributes.push_back({attrName, value});
+    }
+
+    if (decodedSize > 0) {
+        // Decoded text is never longer than its source, so one reservation keeps all views stable
+        m_attributeScratch.clear();
+        m_attributeScratch.reserve(decodedSize);
+        for (auto& attr : m_node.attributes) {
+            if (attr.value.find('&') != std::string_view::npos) {
+                size_t start = m_attributeScratch.size();
+                decode(attr.value, m_attributeScratch);
+                attr.value = std::string_view(m_attributeScratch.data() + start, m_attributeScratch.size() - start);
+            }
+        }
+    }
+
+    m_nameOffsets.push_back(m_nameStack.size());
+    m_nameStack.append(m_node.name);
+    ++m_depth;
+    m_pendingEnd = selfClosing;
+    m_pos += end + 1;
+    return Token::StartElement;
+}
+
+SvgXmlReader::Token SvgXmlReader::readEndTag(std::size_t end) {
+    std::string_view name(m_data + m_pos + 2, end - 2);
+    while (!name.empty() && isXmlSpace(name.back())) name.remove_suffix(1);
+
+    if (m_depth == 0) {
+        return fail("Unexpected closing tag </" + std::string(name) + ">");
+    }
+    std::string_view open = std::string_view(m_nameStack).substr(m_nameOffsets.back());
+    if (name != open) {
+        return fail("Mismatched closing tag </" + std::string(name) + "> for <" + std::string(open) + ">");
+    }
+
+    m_node.name = name;
+    m_nameStack.resize(m_nameOffsets.back());
+    m_nameOffsets.pop_back();
+    --m_depth;
+    m_pos += end + 1;
+    return Token::EndElement;
+}
+
+bool SvgXmlReader::skipElement() {
+    int parentDepth = m_depth - 1;
+    while (true) {
+        Token token = next();
+        if (token == Token::EndElement && m_depth == parentDepth) {
+            return true;
+        }
+        if (token == Token::Error || token == Token::EndOfDocument) {
+            return false;
+        }
+    }
+}
+
+std::string SvgXmlReader::readElementText() {
+    int elementDepth = m_depth;
+    std::string content;
+    while (true) {
+        Token token = next();
+        if (token == Token::Text && m_depth == elementDepth) {
+            content.append(m_text);
+        } else if (token == Token::EndElement && m_depth == elementDepth - 1) {
+            break;
+        } else if (token == Token::Error || token == Token::EndOfDocument) {
+            break;
+        }
+    }
+    return content;
+}
+
+std::string_view SvgXmlReader::decode(std::string_view raw, std::string& scratch) {
+    if (raw.find('&') == std::string_view::npos) {
+        return raw;
+    }
+    if (&scratch == &m_textScratch) {
+        scratch.clear();
+    }
+    size_t start = scratch.size();
+    size_t i = 0;
+    while (i < raw.size()) {
+        size_t amp = raw.find('&', i);
+        if (amp == std::string_view::npos) {
+            scratch.append(raw.substr(i));
+            break;
+        }
+        scratch.append(raw.substr(i, amp - i));
+        size_t semi = raw.find(';', amp);
+        if (semi == std::string_view::npos) {
+            // Unterminated reference is kept verbatim, as tinyxml2 does
+            scratch.append(raw.substr(amp));
+            break;
+        }
+        std::string_view entity = raw.substr(amp + 1, semi - amp - 1);
+        if (entity == "lt") scratch += '<';
+        else if (entity == "gt") scratch += '>';
+        else if (entity == "amp") scratch += '&';
+        else if (entity == "quot") scratch += '"';
+        else if (entity == "apos") scratch += '\'';
+        else if (entity.size() > 1 && entity[0] == '#') {
+            unsigned long cp = 0;
+            bool hex = entity[1] == 'x' || entity[1] == 'X';
+            const char* first = entity.data() + (hex ? 2 : 1);
+            auto result = std::from_chars(first, entity.data() + entity.size(), cp, hex ? 16 : 10);
+            if (result.ec == std::errc() && result.ptr == entity.data() + entity.size() && cp <= 0x10FFFF) {
+                appendUtf8(scratch, cp);
+            } else {
+                scratch.append(raw.substr(amp, semi - amp + 1));
+            }
+        } else {
+            scratch.append(raw.substr(amp, semi - amp + 1));
+        }
+        i = semi + 1;
+    }
+    return std::string_view(scratch.data() + start, scratch.size() - start);
+}
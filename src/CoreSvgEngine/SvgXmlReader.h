@@ -0,0 +1,116 @@
+﻿#pragma once
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Pulls up to `capacity` bytes into `dst`; returning 0 signals end of input
+using SvgByteSource = std::function<std::size_t(char* dst, std::size_t capacity)>;
+
+struct SvgXmlAttribute {
+    std::string_view name;
+    std::string_view value;
+};
+
+// Lightweight view of one element's start tag. Views point into the reader's
+// buffer and are only valid until the next SvgXmlReader::next() call unless
+// detach() has been called.
+class SvgXmlNode {
+public:
+    std::string_view name;
+    std::vector<SvgXmlAttribute> attributes;
+    // Character data of the element, only filled in for elements that need it (<text>)
+    std::string_view text;
+
+    SvgXmlNode() = default;
+    // Copying a detached node detaches the copy as well, so it never views the source's storage
+    SvgXmlNode(const SvgXmlNode& other);
+    SvgXmlNode& operator=(const SvgXmlNode& other);
+    SvgXmlNode(SvgXmlNode&&) = default;
+    SvgXmlNode& operator=(SvgXmlNode&&) = default;
+
+    const SvgXmlAttribute* findAttribute(std::string_view attrName) const;
+    bool hasAttribute(std::string_view attrName) const { return findAttribute(attrName) != nullptr; }
+    std::string_view attribute(std::string_view attrName) const;
+
+    // Mirrors tinyxml2's QueryDoubleAttribute: leading number of the value, e.g. "12px" -> 12
+    bool queryDouble(std::string_view attrName, double& value) const;
+    static bool parseDouble(std::string_view text, double& value);
+
+    // Copies name and attributes into node-owned storage so the node outlives the reader buffer
+    void detach();
+
+private:
+    // Heap block rather than std::string: its address survives moves, which keeps the views valid
+    std::unique_ptr<char[]> m_storage;
+};
+
+// Streaming pull parser for the XML subset used by SVG files. It tokenizes the
+// input on demand and never builds a tree, so memory stays bounded by the
+// largest single tag regardless of document size.
+class SvgXmlReader {
+public:
+    enum class Token {
+        StartElement,
+        EndElement,
+        Text,
+        EndOfDocument,
+        Error
+    };
+
+    // Parse an in-memory buffer without copying it
+    explicit SvgXmlReader(std::string_view content);
+    // Parse incrementally from a byte source, buffering `chunkSize` bytes at a time
+    explicit SvgXmlReader(SvgByteSource source, std::size_t chunkSize = 64 * 1024);
+
+    Token next();
+
+    // Start tag of the current StartElement, or the name of the current EndElement
+    const SvgXmlNode& node() const { return m_node; }
+    // Decoded character data of the current Text token
+    std::string_view text() const { return m_text; }
+    // Nesting depth after the current token; the root element has depth 1
+    int depth() const { return m_depth; }
+
+    // Consume everything up to and including the end tag of the current start element
+    bool skipElement();
+    // Like skipElement(), but collects the element's direct character data
+    std::string readElementText();
+
+    const std::string& errorString() const { return m_error; }
+    // Absolute byte offset of the read position, for diagnostics
+    std::size_t offset() const { return m_consumed + m_pos; }
+
+private:
+    bool fill();
+    bool require(std::size_t count);
+    bool find(std::string_view pattern, std::size_t from, std::size_t& at);
+    bool findTagEnd(std::size_t& at);
+    Token fail(const std::string& message);
+    Token readStartTag(std::size_t end);
+    Token readEndTag(std::size_t end);
+    std::string_view decode(std::string_view raw, std::string& scratch);
+
+    SvgByteSource m_source;
+    std::size_t m_chunkSize = 0;
+    std::string m_buffer;
+    const char* m_data = nullptr;
+    std::size_t m_size = 0;
+    std::size_t m_pos = 0;
+    std::size_t m_consumed = 0;
+    bool m_eof = true;
+
+    SvgXmlNode m_node;
+    std::string_view m_text;
+    std::string m_attributeScratch;
+    std::string m_textScratch;
+
+    // Open element names, packed into one string to avoid a heap string per element
+    std::string m_nameStack;
+    std::vector<std::size_t> m_nameOffsets;
+    int m_depth = 0;
+    bool m_pendingEnd = false;
+    std::string m_error;
+};
@@ -0,0 +1,500 @@
+#include "corpusgenerator.h"
+#include "svgdocument.h"
+#include "svgelementpool.h"
+#include "svgshapes.h"
+#include "svgtext.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+
+static const char* const shapeNames[] = {"rect", "circle", "ellipse", "line", "polyline", "polygon", "text"};
+static const char* const colorFormatNames[] = {"rgb", "hex", "short", "named", "percent"};
+
+// Palette drawn from for a quarter of all colors, so the named format has
+// something to name
+struct NamedColor {
+    const char* name;
+    Color color;
+};
+static const NamedColor namedColors[] = {
+    {"black", {0, 0, 0, 255}},        {"white", {255, 255, 255, 255}},    {"red", {255, 0, 0, 255}},
+    {"lime", {0, 255, 0, 255}},       {"blue", {0, 0, 255, 255}},         {"navy", {0, 0, 128, 255}},
+    {"orange", {255, 165, 0, 255}},   {"purple", {128, 0, 128, 255}},     {"teal", {0, 128, 128, 255}},
+    {"gray", {128, 128, 128, 255}},   {"silver", {192, 192, 192, 255}},   {"maroon", {128, 0, 0, 255}},
+    {"olive", {128, 128, 0, 255}},    {"green", {0, 128, 0, 255}},        {"gold", {255, 215, 0, 255}},
+    {"crimson", {220, 20, 60, 255}},  {"steelblue", {70, 130, 180, 255}}, {"cornflowerblue", {100, 149, 237, 255}},
+};
+
+static const char* const fontFamilies[] = {"Arial", "Helvetica", "Times New Roman", "Courier New", "Noto Sans"};
+
+static constexpr double PI = 3.14159265358979323846;
+
+// Seeds the syntax stream apart from the element stream
+static constexpr uint64_t SYNTAX_SEED_SALT = 0x5851f42d4c957f2dULL;
+
+// splitmix64
+uint64_t CorpusRandom::next() {
+    uint64_t z = (m_state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+template <typename T>
+static bool parseSpecNumber(std::string_view text, T& value) {
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+// "min-max", or a single value for both
+static bool parseSpecRange(std::string_view text, int& min, int& max) {
+    size_t dash = text.find('-');
+    if (dash == std::string_view::npos) {
+        return parseSpecNumber(text, min) && parseSpecNumber(text, max);
+    }
+    return parseSpecNumber(text.substr(0, dash), min) && parseSpecNumber(text.substr(dash + 1), max) && min <= max;
+}
+
+// Calls fn(item) for each item of a comma separated list
+template <typename Fn>
+static bool forEachSpecItem(std::string_view text, Fn&& fn) {
+    while (!text.empty()) {
+        size_t comma = text.find(',');
+        if (!fn(text.substr(0, comma))) {
+            return false;
+        }
+        text = comma == std::string_view::npos ? std::string_view() : text.substr(comma + 1);
+    }
+    return true;
+}
+
+bool CorpusSpec::set(std::string_view key, std::string_view value, std::string& error) {
+    bool valid = false;
+    if (key == "seed") {
+        valid = parseSpecNumber(value, seed);
+    } else if (key == "elements") {
+        valid = parseSpecNumber(value, elements);
+    } else if (key == "width") {
+        valid = parseSpecNumber(value, width) && width > 0;
+    } else if (key == "height") {
+        valid = parseSpecNumber(value, height) && height > 0;
+    } else if (key == "mix") {
+        // "rect:4,text:1"; shapes not listed get no weight
+        std::array<double, static_cast<size_t>(CorpusShape::Count)> weights = {};
+        valid = forEachSpecItem(value, [&](std::string_view item) {
+            size_t colon = item.find(':');
+            std::string_view name = item.substr(0, colon);
+            auto shape = std::find(std::begin(shapeNames), std::end(shapeNames), name);
+            double weight = 1;
+            if (shape == std::end(shapeNames) ||
+                (colon != std::string_view::npos && !parseSpecNumber(item.substr(colon + 1), weight)) || weight < 0) {
+                return false;
+            }
+            weights[shape - std::begin(shapeNames)] = weight;
+            return true;
+        });
+        double total = 0;
+        for (double weight : weights) {
+            total += weight;
+        }
+        valid = valid && total > 0;
+        if (valid) {
+            mix = weights;
+        }
+    } else if (key == "vertices") {
+        valid = parseSpecRange(value, minVertices, maxVertices) && minVertices >= 3;
+    } else if (key == "depth") {
+        valid = parseSpecNumber(value, maxDepth) && maxDepth >= 0 && maxDepth <= 32;
+    } else if (key == "group-size") {
+        valid = parseSpecNumber(value, groupSize) && groupSize > 0;
+    } else if (key == "text-length") {
+        valid = parseSpecRange(value, minTextLength, maxTextLength) && minTextLength >= 1;
+    } else if (key == "noise") {
+        valid = parseSpecNumber(value, noise) && noise >= 0 && noise <= 1;
+    } else if (key == "ids") {
+        valid = parseSpecNumber(value, idRate) && idRate >= 0 && idRate <= 1;
+    } else if (key == "colors") {
+        std::vector<CorpusColorFormat> formats;
+        valid = forEachSpecItem(value, [&](std::string_view name) {
+            auto format = std::find(std::begin(colorFormatNames), std::end(colorFormatNames), name);
+            if (format == std::end(colorFormatNames)) {
+                return false;
+            }
+            formats.push_back(static_cast<CorpusColorFormat>(format - std::begin(colorFormatNames)));
+            return true;
+        });
+        valid = valid && !formats.empty();
+        if (valid) {
+            colorFormats = formats;
+        }
+    } else {
+        error = "unknown setting \"" + std::string(key) + "\"";
+        return false;
+    }
+    if (!valid) {
+        error = "invalid value for " + std::string(key) + ": \"" + std::string(value) + "\"";
+    }
+    return valid;
+}
+
+std::string CorpusSpec::toString() const {
+    auto number = [](double value) {
+        char buffer[32];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        return std::string(buffer, result.ptr);
+    };
+    std::string text = "seed=" + std::to_string(seed) + "\nelements=" + std::to_string(elements) +
+                       "\nwidth=" + number(width) + "\nheight=" + number(height) + "\nmix=";
+    const char* separator = "";
+    for (size_t i = 0; i < mix.size(); ++i) {
+        if (mix[i] > 0) {
+            text += separator + std::string(shapeNames[i]) + ":" + number(mix[i]);
+            separator = ",";
+        }
+    }
+    text += "\nvertices=" + std::to_string(minVertices) + "-" + std::to_string(maxVertices) +
+            "\ndepth=" + std::to_string(maxDepth) + "\ngroup-size=" + std::to_string(groupSize) +
+            "\ntext-length=" + std::to_string(minTextLength) + "-" + std::to_string(maxTextLength) +
+            "\nnoise=" + number(noise) + "\nids=" + number(idRate) + "\ncolors=";
+    separator = "";
+    for (CorpusColorFormat format : colorFormats) {
+        text += separator + std::string(colorFormatNames[static_cast<size_t>(format)]);
+        separator = ",";
+    }
+    return text + "\n";
+}
+
+CorpusGenerator::CorpusGenerator(const CorpusSpec& spec)
+    : m_spec(spec), m_elementRandom(spec.seed), m_syntaxRandom(spec.seed ^ SYNTAX_SEED_SALT) {
+    for (double weight : m_spec.mix) {
+        m_mixTotal += weight;
+    }
+}
+
+CorpusShape CorpusGenerator::pickShape() {
+    double pick = m_elementRandom.unit() * m_mixTotal;
+    for (size_t i = 0; i < m_spec.mix.size(); ++i) {
+        pick -= m_spec.mix[i];
+        if (pick < 0) {
+            return static_cast<CorpusShape>(i);
+        }
+    }
+    // Rounding left a sliver past the last weight; give it to the last shape in the mix
+    size_t last = m_spec.mix.size();
+    while (last > 0 && m_spec.mix[last - 1] <= 0) {
+        --last;
+    }
+    return static_cast<CorpusShape>(last > 0 ? last - 1 : 0);
+}
+
+// Two decimals, like most exported drawings
+static double roundCoordinate(double value) {
+    return std::round(value * 100.0) / 100.0;
+}
+
+Point CorpusGenerator::pickPoint() {
+    return {roundCoordinate(m_elementRandom.uniform(0, m_spec.width)),
+            roundCoordinate(m_elementRandom.uniform(0, m_spec.height))};
+}
+
+Color CorpusGenerator::pickColor() {
+    if (m_elementRandom.below(4) == 0) {
+        return namedColors[m_elementRandom.below(std::size(namedColors))].color;
+    }
+    uint64_t bits = m_elementRandom.next();
+    Color color = {static_cast<int>(bits & 0xff), static_cast<int>((bits >> 8) & 0xff),
+                   static_cast<int>((bits >> 16) & 0xff), 255};
+    if (m_elementRandom.chance(m_spec.noise)) {
+        color.alpha = static_cast<int>(1 + (bits >> 24) % 254);
+    }
+    return color;
+}
+
+std::vector<Point> CorpusGenerator::pickPoints() {
+    // Vertices around a center, in angle order so polygons stay simple
+    Point center = pickPoint();
+    double radius = m_elementRandom.uniform(5, 150);
+    int count = m_elementRandom.range(m_spec.minVertices, m_spec.maxVertices);
+    std::vector<Point> points;
+    points.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        double angle = (i + m_elementRandom.unit() * 0.8) * 2.0 * PI / count;
+        double distance = radius * m_elementRandom.uniform(0.4, 1.0);
+        points.push_back({roundCoordinate(center.x + distance * std::cos(angle)),
+                          roundCoordinate(center.y + distance * std::sin(angle))});
+    }
+    return points;
+}
+
+std::string CorpusGenerator::pickText() {
+    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyz      ABCDEFGHIJ0123456789.,";
+    static const char markup[] = "&<>\"'";
+    int length = m_elementRandom.range(m_spec.minTextLength, m_spec.maxTextLength);
+    std::string text(static_cast<size_t>(length), ' ');
+    for (char& ch : text) {
+        ch = alphabet[m_elementRandom.below(sizeof(alphabet) - 1)];
+    }
+    // A character that needs escaping
+    if (m_elementRandom.chance(m_spec.noise)) {
+        text[m_elementRandom.below(text.size())] = markup[m_elementRandom.below(sizeof(markup) - 1)];
+    }
+    return text;
+}
+
+void CorpusGenerator::addNoise(SvgElement& element) {
+    Transform transform;
+    switch (m_elementRandom.below(3)) {
+    case 0:
+        transform.translate(roundCoordinate(m_elementRandom.uniform(-100, 100)),
+                            roundCoordinate(m_elementRandom.uniform(-100, 100)));
+        break;
+    case 1: {
+        Point center = pickPoint();
+        transform.rotate(static_cast<double>(m_elementRandom.range(-180, 180)), center.x, center.y);
+        break;
+    }
+    default:
+        transform.scale(roundCoordinate(m_elementRandom.uniform(0.5, 2)), roundCoordinate(m_elementRandom.uniform(0.5, 2)));
+        break;
+    }
+    element.setTransform(transform);
+    element.setOpacity(roundCoordinate(m_elementRandom.uniform(0.2, 1)));
+
+    // Attributes the editor does not model, kept as they are
+    element.setAttribute("class", "c" + std::to_string(m_elementRandom.below(32)));
+    if (m_elementRandom.chance(0.5)) {
+        element.setAttribute("data-index", static_cast<int>(m_elementRandom.below(1000000)));
+    }
+    if (element.getType() != SvgElementType::Text && m_elementRandom.chance(0.5)) {
+        element.setAttribute("stroke-dasharray", std::string(m_elementRandom.chance(0.5) ? "4 2" : "1 3 5"));
+    }
+}
+
+std::unique_ptr<SvgElement> CorpusGenerator::next() {
+    if (m_produced >= m_spec.elements) {
+        return nullptr;
+    }
+    std::unique_ptr<SvgElement> element;
+    bool filled = true;
+    switch (pickShape()) {
+    case CorpusShape::Rect: {
+        Point topLeft = pickPoint();
+        double width = roundCoordinate(m_elementRandom.uniform(1, 200));
+        double height = roundCoordinate(m_elementRandom.uniform(1, 200));
+        double radius = m_elementRandom.chance(0.25) ? roundCoordinate(m_elementRandom.uniform(1, 10)) : 0.0;
+        element = std::make_unique<SvgRectangle>(topLeft, width, height, radius, radius);
+        break;
+    }
+    case CorpusShape::Circle: {
+        Point center = pickPoint();
+        element = std::make_unique<SvgCircle>(center, roundCoordinate(m_elementRandom.uniform(1, 100)));
+        break;
+    }
+    case CorpusShape::Ellipse: {
+        Point center = pickPoint();
+        double rx = roundCoordinate(m_elementRandom.uniform(1, 100));
+        double ry = roundCoordinate(m_elementRandom.uniform(1, 100));
+        element = std::make_unique<SvgEllipse>(center, rx, ry);
+        break;
+    }
+    case CorpusShape::Line: {
+        Point start = pickPoint();
+        Point end = pickPoint();
+        element = std::make_unique<SvgLine>(start, end);
+        filled = false;
+        break;
+    }
+    case CorpusShape::Polyline:
+        element = std::make_unique<SvgPolyline>(pickPoints());
+        filled = false;
+        break;
+    case CorpusShape::Polygon:
+        element = std::make_unique<SvgPolygon>(pickPoints());
+        break;
+    default: {
+        Point position = pickPoint();
+        auto text = std::make_unique<SvgText>(position, pickText());
+        text->setFontFamily(fontFamilies[m_elementRandom.below(std::size(fontFamilies))]);
+        text->setFontSize(static_cast<double>(m_elementRandom.range(8, 48)));
+        text->setBold(m_elementRandom.chance(0.2));
+        text->setItalic(m_elementRandom.chance(0.1));
+        text->setFillColor(pickColor());
+        element = std::move(text);
+        break;
+    }
+    }
+
+    if (element->getType() != SvgElementType::Text) {
+        element->setStrokeColor(pickColor());
+        element->setStrokeWidth(m_elementRandom.range(0, 8) * 0.5);
+        if (filled) {
+            element->setFillColor(pickColor());
+        }
+    }
+    if (m_elementRandom.chance(m_spec.idRate)) {
+        element->setID("e" + std::to_string(m_produced));
+    }
+    if (m_elementRandom.chance(m_spec.noise)) {
+        addNoise(*element);
+    }
+    ++m_produced;
+    return element;
+}
+
+static void writeIndent(SvgWriter& writer, int depth) {
+    static const char spaces[] = "                                                                  ";
+    writer.write(std::string_view(spaces, std::min<size_t>(2 * static_cast<size_t>(depth), sizeof(spaces) - 1)));
+}
+
+static void writeHexByte(SvgWriter& writer, int value) {
+    static const char digits[] = "0123456789abcdef";
+    writer.write(digits[(value >> 4) & 0xf]);
+    writer.write(digits[value & 0xf]);
+}
+
+void CorpusGenerator::writeColorValue(SvgWriter& writer, const Color& color, CorpusColorFormat format) {
+    if (format == CorpusColorFormat::Named && color.alpha == 255) {
+        for (const NamedColor& named : namedColors) {
+            if (named.color.r == color.r && named.color.g == color.g && named.color.b == color.b) {
+                writer.write(named.name);
+                return;
+            }
+        }
+    } else if (format == CorpusColorFormat::ShortHex && color.r % 17 == 0 && color.g % 17 == 0 &&
+               color.b % 17 == 0 && color.alpha % 17 == 0) {
+        static const char digits[] = "0123456789abcdef";
+        writer.write('#');
+        writer.write(digits[color.r / 17]);
+        writer.write(digits[color.g / 17]);
+        writer.write(digits[color.b / 17]);
+        if (color.alpha != 255) {
+            writer.write(digits[color.alpha / 17]);
+        }
+        return;
+    } else if (format == CorpusColorFormat::Percent) {
+        writer.write(color.alpha == 255 ? "rgb(" : "rgba(");
+        const int channels[] = {color.r, color.g, color.b};
+        for (int i = 0; i < 3; ++i) {
+            if (i > 0) {
+                writer.write(", ");
+            }
+            writer.writeNumber(channels[i] * 100.0 / 255.0);
+            writer.write('%');
+        }
+        if (color.alpha != 255) {
+            writer.write(", ");
+            writer.writeNumber(color.alpha / 255.0);
+        }
+        writer.write(')');
+        return;
+    } else if (format == CorpusColorFormat::Rgb) {
+        writer.writeColor(color);
+        return;
+    }
+    writer.write('#');
+    writeHexByte(writer, color.r);
+    writeHexByte(writer, color.g);
+    writeHexByte(writer, color.b);
+    if (color.alpha != 255) {
+        writeHexByte(writer, color.alpha);
+    }
+}
+
+void CorpusGenerator::writeElement(SvgWriter& writer, const SvgElement& element, int depth) {
+    CorpusColorFormat format = m_spec.colorFormats[m_syntaxRandom.below(m_spec.colorFormats.size())];
+    m_scratch.clear();
+    element.writeSvg(m_scratch);
+    std::string_view tag = m_scratch.str();
+    writeIndent(writer, depth + 1);
+    if (format == CorpusColorFormat::Rgb) {
+        writer.write(tag);
+        writer.write('\n');
+        return;
+    }
+
+    // Respell the stroke and fill values the element wrote; attribute values
+    // are escaped, so the first '>' ends the start tag
+    struct Paint {
+        size_t begin;
+        size_t end;
+        Color color;
+    };
+    Paint paints[2];
+    size_t paintCount = 0;
+    size_t tagEnd = tag.find('>');
+    for (auto [name, color] : {std::pair<std::string_view, Color>{" stroke=\"", element.getStrokeColor()},
+                               std::pair<std::string_view, Color>{" fill=\"", element.getFillColor()}}) {
+        size_t begin = tag.find(name);
+        if (begin >= tagEnd) {
+            continue;
+        }
+        begin += name.size();
+        size_t end = tag.find('"', begin);
+        if (tag.substr(begin, end - begin) != "none") {
+            paints[paintCount++] = {begin, end, color};
+        }
+    }
+    if (paintCount == 2 && paints[1].begin < paints[0].begin) {
+        std::swap(paints[0], paints[1]);
+    }
+    size_t copied = 0;
+    for (size_t i = 0; i < paintCount; ++i) {
+        writer.write(tag.substr(copied, paints[i].begin - copied));
+        writeColorValue(writer, paints[i].color, format);
+        copied = paints[i].end;
+    }
+    writer.write(tag.substr(copied));
+    writer.write('\n');
+}
+
+bool CorpusGenerator::writeSvg(SvgWriter& writer) {
+    // Elements are freed right after being written; the pool hands the same
+    // blocks out again instead of going back to the heap each time
+    SvgElementPool::Handle pool = SvgElementPool::create();
+    SvgElementPool::Scope scope(pool.get());
+
+    writer.write("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<svg width=\"");
+    writer.writeNumber(m_spec.width);
+    writer.write("\" height=\"");
+    writer.writeNumber(m_spec.height);
+    writer.write("\" xmlns=\"http://www.w3.org/2000/svg\">\n");
+
+    int depth = 0;
+    int inGroup = 0;
+    uint64_t groups = 0;
+    while (std::unique_ptr<SvgElement> element = next()) {
+        if (m_spec.maxDepth > 0 && (depth == 0 || inGroup == m_spec.groupSize)) {
+            for (; depth > 0; --depth) {
+                writeIndent(writer, depth);
+                writer.write("</g>\n");
+            }
+            int target = m_syntaxRandom.range(1, m_spec.maxDepth);
+            for (; depth < target; ++depth) {
+                writeIndent(writer, depth + 1);
+                writer.write("<g id=\"g");
+                writer.writeInteger(static_cast<long long>(groups++));
+                writer.write("\">\n");
+            }
+            inGroup = 0;
+        }
+        writeElement(writer, *element, depth);
+        ++inGroup;
+        if (!writer.ok()) {
+            return false;
+        }
+    }
+    for (; depth > 0; --depth) {
+        writeIndent(writer, depth);
+        writer.write("</g>\n");
+    }
+    writer.write("</svg>\n");
+    return writer.flush();
+}
+
+void CorpusGenerator::fillDocument(SvgDocument& document) {
+    document.setWidth(m_spec.width);
+    document.setHeight(m_spec.height);
+    while (std::unique_ptr<SvgElement> element = next()) {
+        document.addElement(std::move(element));
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include "svgelement.h"
+#include "svgwriter.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class SvgDocument;
+
+enum class CorpusShape { Rect, Circle, Ellipse, Line, Polyline, Polygon, Text, Count };
+
+// How fill and stroke colors are spelled in SVG output. Colors a format cannot
+// express exactly (a name for an arbitrary color, #rgb for #123456) fall back
+// to hex, so the parsed colors never depend on the formats chosen.
+enum class CorpusColorFormat { Rgb, Hex, ShortHex, Named, Percent };
+
+// Everything that shapes a corpus; the same spec and seed always give the same bytes
+struct CorpusSpec {
+    uint64_t seed = 1;
+    uint64_t elements = 10000;
+    double width = 4000;
+    double height = 4000;
+    // Relative weight of each CorpusShape
+    std::array<double, static_cast<size_t>(CorpusShape::Count)> mix = {4, 2, 1, 2, 1, 1, 1};
+    // Vertex count range of polygons and polylines
+    int minVertices = 3;
+    int maxVertices = 12;
+    // <g> nesting: each group holds groupSize elements and sits 1..maxDepth levels deep
+    int maxDepth = 0;
+    int groupSize = 100;
+    // Character count range of text content
+    int minTextLength = 4;
+    int maxTextLength = 40;
+    // Chance per element of a transform, partial opacity and extra attributes
+    double noise = 0.0;
+    // Chance per element of carrying an id
+    double idRate = 1.0;
+    std::vector<CorpusColorFormat> colorFormats = {CorpusColorFormat::Rgb};
+
+    // Applies one key=value setting; `error` explains a rejected one
+    bool set(std::string_view key, std::string_view value, std::string& error);
+    // One line per setting, in the key=value form set() accepts
+    std::string toString() const;
+};
+
+// Deterministic random source with the same sequence on every platform, which
+// the standard distributions do not guarantee
+class CorpusRandom {
+public:
+    explicit CorpusRandom(uint64_t seed) : m_state(seed) {}
+
+    uint64_t next();
+    // Uniform in [0, bound)
+    uint64_t below(uint64_t bound) { return bound ? next() % bound : 0; }
+    // Uniform in [min, max]
+    int range(int min, int max) { return min + static_cast<int>(below(static_cast<uint64_t>(max - min) + 1)); }
+    // Uniform in [0, 1)
+    double unit() { return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0); }
+    double uniform(double min, double max) { return min + (max - min) * unit(); }
+    bool chance(double probability) { return unit() < probability; }
+
+private:
+    uint64_t m_state;
+};
+
+// Produces the elements of a corpus one at a time. Elements come from their
+// own random stream and the output syntax (groups, color spelling) from
+// another, so an SVG and an .svgb made from one spec hold the same elements.
+class CorpusGenerator {
+public:
+    explicit CorpusGenerator(const CorpusSpec& spec);
+
+    // Next element, or nullptr once spec.elements have been produced
+    std::unique_ptr<SvgElement> next();
+
+    // Streams the whole corpus as an SVG document. Memory use does not grow
+    // with the element count, so the size of the corpus is bounded by disk only.
+    bool writeSvg(SvgWriter& writer);
+    // Adds the whole corpus to `document`; groups are not modelled there
+    void fillDocument(SvgDocument& document);
+
+    uint64_t produced() const { return m_produced; }
+
+private:
+    CorpusShape pickShape();
+    Point pickPoint();
+    Color pickColor();
+    std::vector<Point> pickPoints();
+    std::string pickText();
+    void addNoise(SvgElement& element);
+
+    void writeElement(SvgWriter& writer, const SvgElement& element, int depth);
+    void writeColorValue(SvgWriter& writer, const Color& color, CorpusColorFormat format);
+
+    CorpusSpec m_spec;
+    double m_mixTotal = 0;
+    CorpusRandom m_elementRandom;
+    CorpusRandom m_syntaxRandom;
+    uint64_t m_produced = 0;
+    // Reused for every element so writing allocates nothing per element
+    SvgWriter m_scratch;
+};
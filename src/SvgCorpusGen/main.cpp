@@ -0,0 +1,161 @@
+#include "corpusgenerator.h"
+#include "coresvgengine.h"
+#include "svggzip.h"
+#include "svgtrace.h"
+#include <QCoreApplication>
+#include <QLoggingCategory>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+static void printUsage() {
+    std::printf(
+        "Usage: SvgCorpusGen <output.svg|.svgz|.svgb> [key=value ...] [spec=<file>]\n\n"
+        "Writes a synthetic document that only depends on the settings below.\n"
+        "A spec file holds the same key=value pairs, one per line; '#' starts a comment.\n"
+        "Later settings override earlier ones.\n\n"
+        "  seed=N             random seed (1)\n"
+        "  elements=N         element count (10000)\n"
+        "  width=W height=H   canvas size (4000 x 4000)\n"
+        "  mix=shape:w,...    relative weights of rect, circle, ellipse, line, polyline,\n"
+        "                     polygon and text (rect:4,circle:2,ellipse:1,line:2,\n"
+        "                     polyline:1,polygon:1,text:1)\n"
+        "  vertices=MIN-MAX   vertex count of polygons and polylines (3-12)\n"
+        "  depth=N            maximum <g> nesting, 0 for a flat document (0)\n"
+        "  group-size=N       elements per innermost group (100)\n"
+        "  text-length=MIN-MAX characters of text content (4-40)\n"
+        "  noise=P            chance of transforms, opacity, extra attributes,\n"
+        "                     translucent colors and escaped text (0)\n"
+        "  ids=P              chance of an element id (1)\n"
+        "  colors=f,...       color spellings to pick from: rgb, hex, short, named,\n"
+        "                     percent (rgb)\n\n"
+        ".svg and .svgz are streamed and can be of any size. .svgb is built in memory\n"
+        "and has no groups; its elements are the same as those of the SVG forms.\n");
+}
+
+static bool hasSuffix(const std::string& text, const char* suffix) {
+    size_t length = std::char_traits<char>::length(suffix);
+    if (text.size() < length) {
+        return false;
+    }
+    for (size_t i = 0; i < length; ++i) {
+        if (std::tolower(static_cast<unsigned char>(text[text.size() - length + i])) != suffix[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool applySetting(CorpusSpec& spec, const std::string& setting, int depth);
+
+static bool applySpecFile(CorpusSpec& spec, const std::string& path, int depth) {
+    std::ifstream file(path);
+    if (!file) {
+        std::fprintf(stderr, "Cannot read spec file %s\n", path.c_str());
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        line = line.substr(0, line.find('#'));
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos) {
+            continue;
+        }
+        line = line.substr(first, line.find_last_not_of(" \t\r") - first + 1);
+        if (!applySetting(spec, line, depth + 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool applySetting(CorpusSpec& spec, const std::string& setting, int depth) {
+    size_t equals = setting.find('=');
+    if (equals == std::string::npos) {
+        std::fprintf(stderr, "Expected key=value, got \"%s\"\n", setting.c_str());
+        return false;
+    }
+    std::string key = setting.substr(0, equals);
+    std::string value = setting.substr(equals + 1);
+    if (key == "spec") {
+        // Bounded so spec files including each other fail instead of recursing forever
+        if (depth >= 8) {
+            std::fprintf(stderr, "Spec files nested too deeply at %s\n", value.c_str());
+            return false;
+        }
+        return applySpecFile(spec, value, depth);
+    }
+    std::string error;
+    if (!spec.set(key, value, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    // Per-operation engine logs and element tracing are not wanted while writing gigabytes
+    QLoggingCategory::setFilterRules("*.debug=false\n*.info=false");
+    svgTraceSetEnabled(false);
+
+    if (argc < 2 || argv[1][0] == '-') {
+        printUsage();
+        return argc < 2 ? 1 : 0;
+    }
+    std::string outputPath = argv[1];
+    CorpusSpec spec;
+    for (int i = 2; i < argc; ++i) {
+        if (!applySetting(spec, argv[i], 0)) {
+            return 1;
+        }
+    }
+    std::printf("%s", spec.toString().c_str());
+
+    auto start = std::chrono::steady_clock::now();
+    CorpusGenerator generator(spec);
+    uint64_t bytes = 0;
+    bool ok = false;
+    if (hasSuffix(outputPath, ".svgb")) {
+        SvgDocument document;
+        generator.fillDocument(document);
+        ok = CoreSvgEngine::writeSvgFile(document, outputPath);
+        std::ifstream written(outputPath, std::ios::binary | std::ios::ate);
+        bytes = written ? static_cast<uint64_t>(written.tellg()) : 0;
+    } else {
+        std::FILE* file = std::fopen(outputPath.c_str(), "wb");
+        if (!file) {
+            std::fprintf(stderr, "Cannot create %s\n", outputPath.c_str());
+            return 1;
+        }
+        auto fileSink = [file, &bytes](std::string_view block) {
+            bytes += block.size();
+            return std::fwrite(block.data(), 1, block.size(), file) == block.size();
+        };
+        if (hasSuffix(outputPath, ".svgz")) {
+            SvgGzipEncoder encoder(fileSink);
+            SvgWriter writer([&encoder](std::string_view block) { return encoder.write(block); },
+                             1024 * 1024);
+            ok = generator.writeSvg(writer) && encoder.finish();
+        } else {
+            SvgWriter writer(fileSink, 1024 * 1024);
+            ok = generator.writeSvg(writer);
+        }
+        ok = (std::fclose(file) == 0) && ok;
+    }
+    if (!ok) {
+        std::fprintf(stderr, "Failed to write %s\n", outputPath.c_str());
+        return 1;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("Wrote %llu elements, %.1f MiB to %s in %.2f s (%.1f MiB/s, %.0f elements/s)\n",
+                static_cast<unsigned long long>(generator.produced()), bytes / (1024.0 * 1024.0),
+                outputPath.c_str(), seconds, seconds > 0 ? bytes / seconds / (1024.0 * 1024.0) : 0.0,
+                seconds > 0 ? generator.produced() / seconds : 0.0);
+    return 0;
+}
@@ -55,6 +55,8 @@ CanvasArea::CanvasArea(QWidget *parent)
 
 CanvasArea::~CanvasArea()
 {
+    // The scene deletes the items it holds, so the adapter must drop its pointers first
+    m_sceneAdapter.clear();
     delete m_scene;
 }
 
@@ -96,6 +98,7 @@ void CanvasArea::fitToView()
         // Emit the zoom changed signal
         emit zoomChanged(m_zoomFactor);
         qCDebug(canvasAreaLog) << "Fit to view, new zoom factor:" << m_zoomFactor;
+        scheduleVisibleItemsUpdate();
     }
 }
 
@@ -292,6 +295,34 @@ void CanvasArea::setZoom(qreal factor)
     // Emit the zoom changed signal
     emit zoomChanged(m_zoomFactor);
     qCDebug(canvasAreaLog) << "Zoom changed to:" << m_zoomFactor;
+    scheduleVisibleItemsUpdate();
+}
+
+void CanvasArea::scheduleVisibleItemsUpdate()
+{
+    if (!m_sceneAdapter.isLazy() || m_visibleItemsUpdatePending) {
+        return;
+    }
+    m_visibleItemsUpdatePending = true;
+    QTimer::singleShot(0, this, [this]() {
+        m_visibleItemsUpdatePending = false;
+        updateVisibleItems();
+    });
+}
+
+void CanvasArea::updateVisibleItems()
+{
+    // The engine may have replaced its document since the adapter was built
+    if (!m_currentEngine || m_currentEngine->getCurrentDocument() != m_sceneAdapter.document()) {
+        return;
+    }
+    QRectF visibleRect = mapToScene(viewport()->rect()).boundingRect();
+    m_sceneAdapter.updateViewport(visibleRect, m_scene);
+}
+
+void CanvasArea::materializeAllItems()
+{
+    m_sceneAdapter.materializeAll(m_scene);
 }
 
 void CanvasArea::wheelEvent(QWheelEvent *event)
@@ -314,6 +345,13 @@ void CanvasArea::resizeEvent(QResizeEvent *event)
 
     // If we're in "fit in view" mode, we might want to adjust the view here
     // For now, we'll just maintain the current zoom level
+    scheduleVisibleItemsUpdate();
+}
+
+void CanvasArea::scrollContentsBy(int dx, int dy)
+{
+    QGraphicsView::scrollContentsBy(dx, dy);
+    scheduleVisibleItemsUpdate();
 }
 
 QGraphicsLineItem* CanvasArea::createLine(const QPointF& startPoint, const QPointF& endPoint)
@@ -507,8 +545,8 @@ void CanvasArea::addShapeToDocument(QGraphicsItem* item)
         return;
     }
 
-    // Check if the item is already in the document's graphics items list
-    if (doc->m_graphicsItems.contains(item)) {
+    // Check if the item already has an element in the document
+    if (m_sceneAdapter.contains(item)) {
         qCDebug(canvasAreaLog) << "Item is already in document, skipping addition";
         return;
     }
@@ -531,8 +569,8 @@ void CanvasArea::addShapeToDocument(QGraphicsItem* item)
         // Add the element to the document
         doc->addElement(std::move(svgLine));
 
-        // Add the graphics item to the document's graphics items list
-        doc->m_graphicsItems.push_back(item);
+        // Track the item alongside its new element
+        m_sceneAdapter.bind(item, doc->getElements().back().get());
 
         qCDebug(canvasAreaLog) << "Added line to document";
     }
@@ -554,8 +592,8 @@ void CanvasArea::addShapeToDocument(QGraphicsItem* item)
         // Add the element to the document
         doc->addElement(std::move(svgRect));
 
-        // Add the graphics item to the document's graphics items list
-        doc->m_graphicsItems.push_back(item);
+        // Track the item alongside its new element
+        m_sceneAdapter.bind(item, doc->getElements().back().get());
 
         qCDebug(canvasAreaLog) << "Added rectangle to document";
     }
@@ -593,8 +631,8 @@ void CanvasArea::addShapeToDocument(QGraphicsItem* item)
             doc->addElement(std::move(svgEllipse));
         }
 
-        // Add the graphics item to the document's graphics items list
-        doc->m_graphicsItems.push_back(item);
+        // Track the item alongside its new element
+        m_sceneAdapter.bind(item, doc->getElements().back().get());
 
         qCDebug(canvasAreaLog) << "Added ellipse to document";
     }
@@ -685,8 +723,8 @@ void CanvasArea::addShapeToDocument(QGraphicsItem* item)
             doc->addElement(std::move(svgPolygon));
         }
 
-        // Add the graphics item to the document's graphics items list
-        doc->m_graphicsItems.push_back(item);
+        // Track the item alongside its new element
+        m_sceneAdapter.bind(item, doc->getElements().back().get());
 
         qCDebug(canvasAreaLog) << "Added polygon to document";
     }
@@ -712,8 +750,8 @@ void CanvasArea::addShapeToDocument(QGraphicsItem* item)
         // Add the element to the document
         doc->addElement(std::move(svgPolyline));
 
-        // Add the graphics item to the document's graphics items list
-        doc->m_graphicsItems.push_back(item);
+        // Track the item alongside its new element
+        m_sceneAdapter.bind(item, doc->getElements().back().get());
 
         qCDebug(canvasAreaLog) << "Added path to document";
     }
@@ -749,8 +787,8 @@ void CanvasArea::addShapeToDocument(QGraphicsItem* item)
         // Add the element to the document
         doc->addElement(std::move(svgText));
 
-        // Add the graphics item to the document's graphics items list
-        doc->m_graphicsItems.push_back(item);
+        // Track the item alongside its new element
+        m_sceneAdapter.bind(item, doc->getElements().back().get());
 
         qCDebug(canvasAreaLog) << "Added text to document";
     }
@@ -778,8 +816,8 @@ void CanvasArea::addShapeToDocument(QGraphicsItem* item)
         // Add the element to the document
         doc->addElement(std::move(svgText));
 
-        // Add the graphics item to the document's graphics items list
-        doc->m_graphicsItems.push_back(item);
+        // Track the item alongside its new element
+        m_sceneAdapter.bind(item, doc->getElements().back().get());
 
         qCDebug(canvasAreaLog) << "Added simple text to document";
     }
@@ -1076,8 +1114,8 @@ bool CanvasArea::openFileWithEngine(CoreSvgEngine* engine) {
     // Store the current engine
     m_currentEngine = engine;
 
-    // Clear the scene but don't delete the items yet
-    // This prevents accessing deleted items later
+    // Forget the previous document's items before the scene deletes them
+    m_sceneAdapter.clear();
     s->clear();
 
     // Get document dimensions and background color
@@ -1102,23 +1140,9 @@ bool CanvasArea::openFileWithEngine(CoreSvgEngine* engine) {
     m_backgroundItem->setZValue(-1); // Ensure it's behind all other items
     s->addItem(m_backgroundItem);
 
-    // Add all graphics items from the document
-    // Make sure we're not adding invalid items
-    for(auto it = doc->m_graphicsItems.begin(); it != doc->m_graphicsItems.end(); ) {
-        QGraphicsItem* item = *it;
-        if (item) {
-            // Set the item to be selectable
-            item->setFlag(QGraphicsItem::ItemIsSelectable, true);
-            // Also make it movable when selected
-            item->setFlag(QGraphicsItem::ItemIsMovable, true);
-            s->addItem(item);
-            ++it;
-        } else {
-            // Remove invalid items from the vector
-            it = doc->m_graphicsItems.erase(it);
-            qCWarning(canvasAreaLog) << "Removed invalid graphics item from document";
-        }
-    }
+    // Items are built from the model only now that the document is shown;
+    // large documents only get items for what is in view
+    m_sceneAdapter.build(*doc, s);
 
     // Create outline rectangle
     m_outlineItem = new QGraphicsRectItem(docRect);
@@ -1131,7 +1155,8 @@ bool CanvasArea::openFileWithEngine(CoreSvgEngine* engine) {
 
     // Set scene rect with some padding
     s->setSceneRect(docRect.adjusted(-10, -10, 10, 10));
+    updateVisibleItems();
 
-    qCDebug(canvasAreaLog) << "Scene setup complete with" << doc->m_graphicsItems.size() << "items";
+    qCDebug(canvasAreaLog) << "Scene setup complete with" << doc->getElementCount() << "elements";
     return true;
 }
@@ -30,6 +30,7 @@
 #include "shapetoolbar.h"
 #include "editabletextitem.h"
 #include "../Commands/CommandManager.h"
+#include "../SvgSceneAdapter/svgsceneadapter.h"
 
 // 前向声明CoreSvgEngine类
 class CoreSvgEngine;
@@ -67,6 +68,12 @@ public:
     CoreSvgEngine* getCurrentEngine() const { return m_currentEngine; }
     void setCurrentEngine(CoreSvgEngine* engine) { m_currentEngine = engine; }
 
+    // Binds graphics items to the elements of the current document
+    SvgSceneAdapter* sceneAdapter() { return &m_sceneAdapter; }
+    // Creates the items of a lazily shown document that are not in view yet,
+    // e.g. before the whole scene is rendered
+    void materializeAllItems();
+
     // Get the currently selected item
     QGraphicsItem* getSelectedItem() const;
     ShapeType getSelectedItemType() const;
@@ -89,6 +96,9 @@ protected:
     // Override resize event to maintain view
     void resizeEvent(QResizeEvent *event) override;
 
+    // Scrolling moves the viewport over lazily materialized items
+    void scrollContentsBy(int dx, int dy) override;
+
     // Mouse event handlers for shape creation
     void mousePressEvent(QMouseEvent *event) override;
     void mouseMoveEvent(QMouseEvent *event) override;
@@ -120,6 +130,8 @@ private:
     QGraphicsItem* m_currentItem;
     QList<QPointF> m_freehandPoints;
     CoreSvgEngine* m_currentEngine;
+    SvgSceneAdapter m_sceneAdapter;
+    bool m_visibleItemsUpdatePending = false;
     QRectF m_textPreviewRect;  // Store text preview rectangle for finalization
 
     // Default style properties
@@ -128,6 +140,9 @@ private:
 
     // Helper methods
     void setZoom(qreal factor);
+    // Coalesces viewport changes into one updateVisibleItems() per event loop turn
+    void scheduleVisibleItemsUpdate();
+    void updateVisibleItems();
     void createShape(const QPointF& startPoint, const QPointF& endPoint);
     void updateShape(const QPointF& endPoint);
     void finalizeShape();
@@ -4,7 +4,7 @@
 #include <QSplitter>
 #include <QFileDialog>
 #include <QStandardPaths>
-#include <QPixmap>
+#include <QProgressDialog>
 #include <QLoggingCategory>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -17,6 +17,7 @@
 #include "../ConfigDialog/configdialog.h"
 #include "../Commands/ModifyTextCommand.h"
 #include "../ConfigManager/configmanager.h"
+#include "../SvgRasterizer/svgtiledexport.h"
 #include <QTimer>
 
 // Include the undo/redo implementation
@@ -42,6 +43,9 @@ MainWindow::MainWindow(QWidget *parent)
 {
     qCDebug(mainWindowLog) << "MainWindow constructed.";
 
+    // Saves are repeated for the same document, so unchanged elements can be reused
+    m_svgEngine->setFragmentCacheEnabled(true);
+
     // Three-panel layout provides optimal workflow segregation
     QSplitter* splitter = new QSplitter(Qt::Horizontal, this);
 
@@ -105,6 +109,7 @@ MainWindow::MainWindow(QWidget *parent)
             if (doc) {
                 doc->setWidth(width);
                 doc->setHeight(height);
+                m_journal.recordCanvas(*doc);
 
                 // Direct item modification avoids expensive scene reconstruction
                 QGraphicsScene* scene = m_canvasArea->scene();
@@ -153,6 +158,7 @@ MainWindow::MainWindow(QWidget *parent)
         bgColor.b = color.blue();
         bgColor.alpha = color.alpha();
         m_svgEngine->getCurrentDocument()->setBackgroundColor(bgColor);
+        m_journal.recordCanvas(*m_svgEngine->getCurrentDocument());
 
         // Direct brush update avoids full scene reload
         QGraphicsScene* scene = m_canvasArea->scene();
@@ -175,6 +181,9 @@ MainWindow::MainWindow(QWidget *parent)
 
     updateRightAttrBarFromDocument();
 
+    connect(this, &MainWindow::backgroundSaveFinished, this, &MainWindow::handleBackgroundSaveFinished,
+            Qt::QueuedConnection);
+
     connect(m_canvasArea, &CanvasArea::zoomChanged, this, &MainWindow::updateZoomStatus);
     connect(m_canvasArea, &CanvasArea::zoomChanged, m_rightAttrBar, &RightAttrBar::updateZoomLevel);
 
@@ -221,14 +230,37 @@ MainWindow::MainWindow(QWidget *parent)
     // Command pattern integration enables comprehensive undo/redo support
     connect(CommandManager::instance(), &CommandManager::undoRedoChanged,
             this, &MainWindow::updateUndoRedoActions);
+    CommandManager::instance()->setJournal(&m_journal);
 
     showStatusMessage(tr("Ready"), 2000);
 
+    // Once the window is up, so the recovery prompt has a parent to show over
+    QTimer::singleShot(0, this, &MainWindow::recoverLastSession);
+
     qCDebug(mainWindowLog) << "MainWindow construct success.";
 }
 
 MainWindow::~MainWindow()
 {
+    // Let a running save finish writing; its completion signal is dropped with us
+    if (m_saveThread.joinable()) {
+        m_saveThread.join();
+    }
+    CommandManager::instance()->setJournal(nullptr);
+    if (m_saveInProgress) {
+        if (m_saveSucceeded) {
+            rebaseJournal(m_savingPath);
+        } else {
+            m_documentModified = true;
+        }
+    }
+    if (m_documentModified) {
+        // Unsaved changes stay in the journal and are offered again on the next start
+        m_journal.close();
+    } else {
+        m_journal.discard();
+        ConfigManager::instance()->setRecoveryFilePath(QString());
+    }
     delete m_svgEngine;
     qCDebug(mainWindowLog) << "MainWindow destroyed.";
 }
@@ -334,14 +366,22 @@ void MainWindow::openFile()
 }
 
 bool MainWindow::loadFileWithEngine(const QString& fileName) {
-    if (!QFileInfo::exists(fileName) || !m_canvasArea->openFileWithEngine(m_svgEngine)) {
+    if (!QFileInfo::exists(fileName)) {
+        QMessageBox::critical(this, tr("Open SVG File"),
+                              tr("Could not open file '%1'.").arg(QDir::toNativeSeparators(fileName)));
+        return false;
+    }
+
+    // Recovered edits have to be in the document before the scene is built from it
+    bool recovered = openJournal(fileName);
+    if (!m_canvasArea->openFileWithEngine(m_svgEngine)) {
         QMessageBox::critical(this, tr("Open SVG File"),
                               tr("Could not open file '%1'.").arg(QDir::toNativeSeparators(fileName)));
         return false;
     }
 
     m_currentFilePath = fileName;
-    m_documentModified = false;
+    m_documentModified = recovered;
     updateTitle();
     updateRightAttrBarFromDocument();
     m_canvasArea->update();
@@ -350,6 +390,84 @@ bool MainWindow::loadFileWithEngine(const QString& fileName) {
     return true;
 }
 
+bool MainWindow::openJournal(const QString& fileName)
+{
+    // The previous document was saved or its changes were discarded by now
+    m_journal.discard();
+
+    SvgDocument* doc = m_svgEngine->getCurrentDocument();
+    if (!doc) {
+        return false;
+    }
+
+    std::string journalPath = SvgJournal::journalPathFor(fileName.toStdString());
+    bool recovered = false;
+    if (SvgJournal::hasRecoverableRecords(journalPath, *doc)) {
+        QMessageBox::StandardButton ret = QMessageBox::question(
+            this,
+            tr("Recover Changes"),
+            tr("'%1' has unsaved changes from a previous session.\nDo you want to recover them?")
+                .arg(QFileInfo(fileName).fileName()),
+            QMessageBox::Yes | QMessageBox::No
+        );
+
+        size_t records = 0;
+        uint64_t validBytes = 0;
+        if (ret == QMessageBox::Yes && SvgJournal::replay(journalPath, *doc, &records, &validBytes)) {
+            recovered = true;
+            qCInfo(mainWindowLog) << "Recovered" << records << "journaled edits for" << fileName;
+            showStatusMessage(tr("Recovered unsaved changes"), 3000);
+            // Appending to the replayed journal keeps it valid for the saved file
+            if (!m_journal.resume(journalPath, *doc, validBytes)) {
+                qCWarning(mainWindowLog) << "Journaling disabled for" << fileName;
+                return recovered;
+            }
+        }
+    }
+
+    if (!recovered && !m_journal.open(journalPath, *doc)) {
+        qCWarning(mainWindowLog) << "Journaling disabled for" << fileName;
+        return recovered;
+    }
+    ConfigManager::instance()->setRecoveryFilePath(fileName);
+    return recovered;
+}
+
+void MainWindow::rebaseJournal(const QString& filePath)
+{
+    std::string journalPath = SvgJournal::journalPathFor(filePath.toStdString());
+    bool journaling = false;
+    if (m_journal.isOpen()) {
+        // Fails for a checkpoint taken before another file was loaded
+        journaling = m_journal.rebase(m_saveCheckpoint, journalPath);
+    } else if (!m_documentModified && m_svgEngine->getCurrentDocument()) {
+        // First save of a document that had no file to journal against
+        journaling = m_journal.open(journalPath, *m_svgEngine->getCurrentDocument());
+    }
+    if (journaling) {
+        ConfigManager::instance()->setRecoveryFilePath(filePath);
+    }
+}
+
+void MainWindow::recoverLastSession()
+{
+    QString fileName = ConfigManager::instance()->getRecoveryFilePath();
+    if (fileName.isEmpty() || m_documentModified || !m_currentFilePath.isEmpty()) {
+        return;
+    }
+
+    QString journalPath = QString::fromStdString(SvgJournal::journalPathFor(fileName.toStdString()));
+    if (!QFileInfo::exists(journalPath) || !m_svgEngine->loadSvgFile(fileName.toStdString())) {
+        ConfigManager::instance()->setRecoveryFilePath(QString());
+        return;
+    }
+
+    qCDebug(mainWindowLog) << "Reopening file with a leftover journal:" << fileName;
+    CommandManager::instance()->clear();
+    updateUndoRedoActions();
+    loadFileWithEngine(fileName);
+}
+
 void MainWindow::saveFile()
 {
     if (m_currentFilePath.isEmpty()) {
@@ -357,18 +475,97 @@ void MainWindow::saveFile()
         return;
     }
 
-    qCDebug(mainWindowLog) << "Saving file to:" << m_currentFilePath;
+    startBackgroundSave(m_currentFilePath);
+}
+
+void MainWindow::startBackgroundSave(const QString& filePath)
+{
+    if (m_saveInProgress) {
+        // One save at a time; the queued one picks up every edit made until it starts
+        m_queuedSavePath = filePath;
+        return;
+    }
+    if (m_saveThread.joinable()) {
+        m_saveThread.join();
+    }
+
+    if (SvgDocument* doc = m_svgEngine->getCurrentDocument()) {
+        // The saved file has no removed entries, so journal positions after the
+        // checkpoint only match it once the document has none either
+        doc->compactElements();
+        m_saveCheckpoint = m_journal.checkpoint(*doc);
+    }
 
-    if (m_svgEngine->saveSvgFile(m_currentFilePath.toStdString())) {
-        m_documentModified = false;
-        updateTitle();
+    std::unique_ptr<SvgDocument> snapshot = m_svgEngine->snapshotDocument();
+    if (!snapshot) {
+        qCWarning(mainWindowLog) << "No document to save";
+        return;
+    }
+
+    qCDebug(mainWindowLog) << "Saving file in the background to:" << filePath;
+    m_saveInProgress = true;
+    m_savingPath = filePath;
+    m_saveSucceeded = false;
+    // Edits made while the save runs mark the document modified again
+    m_documentModified = false;
+    updateTitle();
+    showStatusMessage(tr("Saving..."), 0);
+
+    int threads = m_svgEngine->getSaveThreadCount();
+    m_saveThread = std::thread([this, filePath, threads, snapshot = std::move(snapshot)]() mutable {
+        bool success = CoreSvgEngine::writeSvgFile(*snapshot, filePath.toStdString(), threads);
+        m_saveSucceeded = success;
+        m_savedFragments = snapshot->takeFragmentCache();
+        // Free the copy here rather than on the GUI thread
+        snapshot.reset();
+        emit backgroundSaveFinished(filePath, success);
+    });
+}
+
+void MainWindow::handleBackgroundSaveFinished(const QString& filePath, bool success)
+{
+    if (m_saveThread.joinable()) {
+        m_saveThread.join();
+    }
+    m_saveInProgress = false;
+    // The snapshot's serialized elements serve the next save of the live document
+    if (SvgDocument* doc = m_svgEngine->getCurrentDocument()) {
+        doc->adoptFragmentCache(std::move(m_savedFragments));
+    }
+    m_savedFragments.clear();
+
+    if (success) {
+        rebaseJournal(filePath);
         updateRightAttrBarFromDocument();
         showStatusMessage(tr("File saved"), 2000);
-        qCDebug(mainWindowLog) << "File saved successfully";
+        qCDebug(mainWindowLog) << "File saved successfully:" << filePath;
     } else {
+        // The file on disk is unchanged, so the document is unsaved again
+        if (filePath == m_currentFilePath) {
+            m_documentModified = true;
+            updateTitle();
+        }
+        clearStatusMessage();
         QMessageBox::critical(this, tr("Save SVG File"),
-                             tr("Could not save file '%1'.").arg(QDir::toNativeSeparators(m_currentFilePath)));
-        qCWarning(mainWindowLog) << "Failed to save file:" << m_currentFilePath;
+                             tr("Could not save file '%1'.").arg(QDir::toNativeSeparators(filePath)));
+        qCWarning(mainWindowLog) << "Failed to save file:" << filePath;
+    }
+
+    if (!m_queuedSavePath.isEmpty()) {
+        QString nextPath = m_queuedSavePath;
+        m_queuedSavePath.clear();
+        startBackgroundSave(nextPath);
+    }
+}
+
+void MainWindow::waitForBackgroundSave()
+{
+    while (m_saveInProgress) {
+        if (m_saveThread.joinable()) {
+            m_saveThread.join();
+        }
+        // Deliver the queued completion now instead of through the event loop
+        QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
     }
 }
 
@@ -417,28 +614,31 @@ void MainWindow::exportToPNG()
     if (fileDialog.exec() == QDialog::Accepted) {
         QString fileName = fileDialog.selectedFiles().constFirst();
 
-        // Get the scene from the canvas
-        QGraphicsScene* scene = m_canvasArea->scene();
-        if (!scene) {
-            QMessageBox::critical(this, tr("Export to PNG"), tr("No scene to export"));
+        SvgDocument* doc = m_svgEngine->getCurrentDocument();
+        if (!doc) {
+            QMessageBox::critical(this, tr("Export to PNG"), tr("No document to export"));
             return;
         }
 
-        // Create a pixmap to render the scene
-        QRectF sceneRect = scene->sceneRect();
-        QPixmap pixmap(sceneRect.size().toSize());
-        pixmap.fill(Qt::transparent);
-
-        // Render the scene to the pixmap
-        QPainter painter(&pixmap);
-        painter.setRenderHint(QPainter::Antialiasing);
-        scene->render(&painter);
-        painter.end();
-
-        // Save the pixmap as PNG
-        if (pixmap.save(fileName, "PNG")) {
+        // Rendered from the document in tiles that stream into the file, so
+        // the image size is not limited by memory and no items need to exist
+        QProgressDialog progress(tr("Exporting to PNG..."), tr("Cancel"), 0, 100, this);
+        progress.setWindowModality(Qt::WindowModal);
+        progress.setMinimumDuration(500);
+        SvgTiledExportOptions exportOptions;
+        exportOptions.progress = [&progress](int rowsDone, int rowsTotal) {
+            progress.setValue(static_cast<int>(100LL * rowsDone / rowsTotal));
+            return !progress.wasCanceled();
+        };
+        bool exported = svgExportPng(*doc, fileName.toStdString(), SvgRasterOptions(), exportOptions);
+        bool cancelled = progress.wasCanceled();
+        progress.reset();
+
+        if (exported) {
             showStatusMessage(tr("Exported to PNG"), 2000);
             qCDebug(mainWindowLog) << "Successfully exported to PNG:" << fileName;
+        } else if (cancelled) {
+            showStatusMessage(tr("Export cancelled"), 2000);
         } else {
             QMessageBox::critical(this, tr("Export to PNG"),
                                  tr("Could not export to '%1'.").arg(QDir::toNativeSeparators(fileName)));
@@ -909,6 +1109,7 @@ bool MainWindow::maybeSave()
 
     if (ret == QMessageBox::Save) {
         saveFile();
+        waitForBackgroundSave();
         return !m_documentModified; // Return true if save was successful
     } else if (ret == QMessageBox::Cancel) {
         return false;
@@ -1375,25 +1576,11 @@ void MainWindow::syncItemToSvgDocument(QGraphicsItem* item)
     }
 
     SvgDocument* doc = m_svgEngine->getCurrentDocument();
-    const auto& elements = doc->getElements();
-    
-    // Find the corresponding graphics item index in the document
-    int itemIndex = -1;
-    for (int i = 0; i < doc->m_graphicsItems.size(); ++i) {
-        if (doc->m_graphicsItems[i] == item) {
-            itemIndex = i;
-            break;
-        }
-    }
-
-    if (itemIndex == -1 || itemIndex >= elements.size()) {
-        qCWarning(mainWindowLog) << "Could not find corresponding SVG element for graphics item";
-        return;
-    }
 
     // Get the corresponding SVG element
-    SvgElement* svgElement = elements[itemIndex].get();
+    SvgElement* svgElement = doc->findElementByViewItem(item);
     if (!svgElement) {
+        qCWarning(mainWindowLog) << "Could not find corresponding SVG element for graphics item";
         return;
     }
 
@@ -1478,7 +1665,9 @@ void MainWindow::syncItemToSvgDocument(QGraphicsItem* item)
         }
     }
 
-    qCDebug(mainWindowLog) << "Synchronized graphics item properties to SVG element at index:" << itemIndex;
+    m_journal.recordReplace(*doc, svgElement);
+
+    qCDebug(mainWindowLog) << "Synchronized graphics item properties to SVG element:" << QString::fromStdString(svgElement->getID());
 }
 
 void MainWindow::showPreferences()
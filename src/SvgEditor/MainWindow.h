@@ -18,12 +18,15 @@
 #include <QPainter>
 #include <QLabel>
 #include <QTimer>
+#include <memory>
+#include <thread>
 #include "leftsidebar.h"
 #include "rightattrbar.h"
 #include "canvasarea.h"
 #include "shapetoolbar.h"
 #include "../CoreSvgEngine/coresvgengine.h"
 #include "../CoreSvgEngine/svgtext.h"
+#include "../CoreSvgEngine/svgjournal.h"
 #include "../Commands/CommandManager.h"
 
 Q_DECLARE_LOGGING_CATEGORY(mainWindowLog)
@@ -36,6 +39,10 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+signals:
+    // Emitted on the save thread; delivered to the GUI thread through a queued connection
+    void backgroundSaveFinished(const QString& filePath, bool success);
+
 private slots:
     void newFile();
     void openFile();
@@ -43,6 +50,9 @@ private slots:
     void saveFile();
     void saveFileAs();
     void exportToPNG();
+    void handleBackgroundSaveFinished(const QString& filePath, bool success);
+    // Reopens the file whose journal a crashed or unsaved session left behind
+    void recoverLastSession();
 
     void handleToolSelected(int toolId);
     void handleShapeToolSelected(ShapeType type);
@@ -106,6 +116,30 @@ private:
 
     void updateTitle();
     bool maybeSave();
+
+    // Edits since the last save, appended by CommandManager for crash recovery
+    SvgJournal m_journal;
+    // Journal position of the state being saved in the background
+    SvgJournal::Checkpoint m_saveCheckpoint;
+    // Starts the journal of a freshly loaded file, first offering to replay a
+    // leftover one; returns true if changes were recovered
+    bool openJournal(const QString& fileName);
+    // The saved file now holds the checkpoint's state, so older records are dropped
+    void rebaseJournal(const QString& filePath);
+
+    // Saves run on a worker thread against a snapshot of the document
+    std::thread m_saveThread;
+    bool m_saveInProgress = false;
+    // Requested while another save was running; started when that one reports back
+    QString m_queuedSavePath;
+    // Path and result of the running save, read after joining the thread
+    QString m_savingPath;
+    bool m_saveSucceeded = false;
+    // Fragments the snapshot serialized, handed back to the live document
+    SvgDocument::FragmentCache m_savedFragments;
+    void startBackgroundSave(const QString& filePath);
+    // Blocks until no save is running, e.g. before the document is discarded
+    void waitForBackgroundSave();
     void updateRightAttrBarFromDocument();
     void updateUndoRedoActions();
     void syncItemToSvgDocument(QGraphicsItem* item);
@@ -3,9 +3,11 @@
 #include <QLibraryInfo>
 #include <QLocale>
 #include <QDir>
+#include <QFile>
 #include <QString>
 #include <QLoggingCategory>
 #include "mainwindow.h"
+#include "../CoreSvgEngine/svgtrace.h"
 
 Q_DECLARE_LOGGING_CATEGORY(svgEditorLog)
 Q_LOGGING_CATEGORY(svgEditorLog, "SvgEditor")
@@ -41,10 +43,27 @@ int main(int argc, char *argv[])
         }
     }
 
+    // SVGEDITOR_TRACE_FILE=<path> keeps the element trace of the session for debugging
+    QString traceFile = qEnvironmentVariable("SVGEDITOR_TRACE_FILE");
+    if (!traceFile.isEmpty()) {
+        svgTraceSetEnabled(true);
+    }
+
     MainWindow w;
     w.show();
     
     int result = a.exec();
+
+    if (!traceFile.isEmpty()) {
+        QFile file(traceFile);
+        if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            std::string trace = svgTraceDump();
+            file.write(trace.data(), static_cast<qint64>(trace.size()));
+            qCInfo(svgEditorLog) << "Trace written to" << traceFile;
+        } else {
+            qCWarning(svgEditorLog) << "Failed to write trace to" << traceFile;
+        }
+    }
     
     qCInfo(svgEditorLog) << "Application exiting...";
     return result;
@@ -0,0 +1,107 @@
+#include "benchcommon.h"
+#include "svgshapes.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <variant>
+#include <vector>
+
+// Replacement global allocator that tracks live heap bytes. It applies to the
+// whole benchmark binary; the cost is one atomic add per allocation.
+static std::atomic<long long> liveHeapBytes{0};
+
+void* operator new(std::size_t size) {
+    // 16-byte header keeps the returned block suitably aligned
+    void* block = std::malloc(size + 16);
+    if (!block) {
+        throw std::bad_alloc();
+    }
+    *static_cast<std::size_t*>(block) = size;
+    liveHeapBytes.fetch_add(static_cast<long long>(size), std::memory_order_relaxed);
+    return static_cast<char*>(block) + 16;
+}
+
+void operator delete(void* pointer) noexcept {
+    if (!pointer) {
+        return;
+    }
+    std::size_t* block = reinterpret_cast<std::size_t*>(reinterpret_cast<std::uintptr_t>(pointer) - 16);
+    liveHeapBytes.fetch_sub(static_cast<long long>(*block), std::memory_order_relaxed);
+    std::free(block);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    operator delete(pointer);
+}
+
+using AttributeMap = std::map<std::string, std::variant<std::string, double, int>>;
+
+// Fills `count` attribute bags the way parsing does for unmodelled attributes
+template <typename SetFn>
+static void fillAttributes(int index, int attributesPerElement, SetFn&& set) {
+    static const char* names[] = {"stroke-dasharray", "stroke-linecap", "class", "data-layer",
+                                  "stroke-linejoin", "fill-rule", "font-weight", "data-tooltip"};
+    for (int a = 0; a < attributesPerElement; ++a) {
+        const char* name = names[a % 8];
+        if (a % 2 == 0) {
+            set(name, std::variant<std::string, double, int>(index * 0.5));
+        } else {
+            set(name, std::variant<std::string, double, int>(std::string("value-") + std::to_string(a)));
+        }
+    }
+}
+
+// Heap plus inline bytes per element for the unmodelled attributes, comparing
+// the former std::map bag with SvgAttributeStore.
+// Usage: SvgEngineBench attribute-memory [elements] [attributesPerElement]
+int runAttributeMemoryBench(int argc, char* argv[]) {
+    int count = argc > 0 ? std::atoi(argv[0]) : 100000;
+    int attributesPerElement = argc > 1 ? std::atoi(argv[1]) : 3;
+    if (count <= 0 || attributesPerElement < 0) {
+        std::fprintf(stderr, "attribute-memory: invalid arguments\n");
+        return 1;
+    }
+    std::printf("attribute-memory: %d elements, %d extra attributes each\n", count, attributesPerElement);
+
+    double mapBytes = 0;
+    {
+        long long before = liveHeapBytes.load();
+        std::vector<AttributeMap> maps(count);
+        for (int i = 0; i < count; ++i) {
+            fillAttributes(i, attributesPerElement, [&](const char* name, const auto& value) { maps[i][name] = value; });
+        }
+        mapBytes = static_cast<double>(liveHeapBytes.load() - before) / count;
+    }
+    double storeBytes = 0;
+    double elementBytes = 0;
+    {
+        long long before = liveHeapBytes.load();
+        std::vector<SvgAttributeStore> stores(count);
+        for (int i = 0; i < count; ++i) {
+            fillAttributes(i, attributesPerElement, [&](const char* name, const auto& value) { stores[i].set(name, value); });
+        }
+        storeBytes = static_cast<double>(liveHeapBytes.load() - before) / count;
+
+        // Whole elements as the parser creates them, outside any element pool
+        std::vector<std::unique_ptr<SvgRectangle>> rects;
+        rects.reserve(count);
+        before = liveHeapBytes.load();
+        for (int i = 0; i < count; ++i) {
+            auto rect = std::make_unique<SvgRectangle>(Point{0, 0}, 10, 10);
+            fillAttributes(i, attributesPerElement, [&](const char* name, const auto& value) { rect->setAttribute(name, value); });
+            rects.push_back(std::move(rect));
+        }
+        elementBytes = static_cast<double>(liveHeapBytes.load() - before) / count;
+    }
+
+    std::printf("%-22s %10s %10s\n", "bytes per element", "total", "heap");
+    std::printf("%-22s %10.1f %10.1f\n", "std::map (before)", mapBytes, mapBytes - sizeof(AttributeMap));
+    std::printf("%-22s %10.1f %10.1f\n", "SvgAttributeStore", storeBytes, storeBytes - sizeof(SvgAttributeStore));
+    std::printf("%-22s %10.1f\n", "SvgRectangle total", elementBytes);
+    return 0;
+}
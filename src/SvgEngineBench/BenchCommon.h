@@ -0,0 +1,67 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+// Shared helpers for the SvgEngineBench commands
+
+// Totals kept by the replacement operator new in BenchResources.cpp, counted
+// since process start; take the difference around the code being measured
+struct BenchAllocations {
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+};
+BenchAllocations benchAllocations();
+// False on Windows, where CoreSvgEngine.dll and Qt allocate through their own
+// operator new, out of the replacement's sight; the totals stay zero there
+bool benchCountsAllocations();
+
+// High-water mark of the process's resident memory in bytes, 0 if unknown.
+// It never goes down, so measure memory-heavy cases in a process of their own.
+uint64_t benchPeakRssBytes();
+
+// Best wall-clock time of `repetitions` runs, in milliseconds. The minimum is
+// the least noisy estimate of what the code itself costs.
+template <typename Fn>
+double benchBestOfMs(int repetitions, Fn&& fn) {
+    double best = std::numeric_limits<double>::max();
+    for (int i = 0; i < repetitions; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+// Document made of `groups` sibling <g> elements with `shapesPerGroup` mixed shapes each
+inline std::string makeGroupedSvg(int groups, int shapesPerGroup) {
+    std::string svg = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                      "<svg width=\"4000\" height=\"4000\" xmlns=\"http://www.w3.org/2000/svg\">\n";
+    for (int g = 0; g < groups; ++g) {
+        svg += "  <g id=\"group" + std::to_string(g) + "\">\n";
+        for (int i = 0; i < shapesPerGroup; ++i) {
+            std::string x = std::to_string((g * 37 + i * 11) % 4000);
+            std::string y = std::to_string((g * 13 + i * 29) % 4000);
+            switch (i % 4) {
+            case 0:
+                svg += "    <rect x=\"" + x + "\" y=\"" + y + "\" width=\"20\" height=\"10\" fill=\"#3366cc\" stroke=\"black\" stroke-width=\"1\"/>\n";
+                break;
+            case 1:
+                svg += "    <circle cx=\"" + x + "\" cy=\"" + y + "\" r=\"7.5\" fill=\"rgb(200,40,40)\" opacity=\"0.8\"/>\n";
+                break;
+            case 2:
+                svg += "    <line x1=\"" + x + "\" y1=\"" + y + "\" x2=\"" + y + "\" y2=\"" + x + "\" stroke=\"green\" stroke-width=\"2\"/>\n";
+                break;
+            default:
+                svg += "    <polyline points=\"" + x + "," + y + " " + y + "," + x + " 10.5,20.25 30,40\" stroke=\"blue\"/>\n";
+                break;
+            }
+        }
+        svg += "  </g>\n";
+    }
+    svg += "</svg>\n";
+    return svg;
+}
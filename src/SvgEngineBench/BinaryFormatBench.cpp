@@ -0,0 +1,66 @@
+#include "benchcommon.h"
+#include "svgdocument.h"
+#include "svgshapes.h"
+#include "svgtext.h"
+#include "svgwriter.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+// Loads and saves the same document as SVG and as .svgb, and checks that
+// SVG -> .svgb -> SVG reproduces the SVG output exactly.
+// Usage: SvgEngineBench binary-format [elements] [repetitions]
+int runBinaryFormatBench(int argc, char* argv[]) {
+    int elements = argc > 0 ? std::atoi(argv[0]) : 200000;
+    int repetitions = argc > 1 ? std::atoi(argv[1]) : 5;
+    if (elements <= 0 || repetitions <= 0) {
+        std::fprintf(stderr, "binary-format: invalid arguments\n");
+        return 1;
+    }
+
+    int shapesPerGroup = 1000;
+    SvgDocument source;
+    source.parseSvgContent(makeGroupedSvg((elements + shapesPerGroup - 1) / shapesPerGroup, shapesPerGroup));
+    // Cover what the generated shapes do not: text, transforms, extra attributes, derived polygons
+    auto text = std::make_unique<SvgText>(Point{10, 20}, "caption & <notes>");
+    text->setFontFamily("Noto Sans");
+    text->setBold(true);
+    text->setTextAnchor(TextAnchor::Middle);
+    text->setAttribute("letter-spacing", 1.5);
+    source.addElement(std::move(text));
+    auto star = std::make_unique<SvgStar>(Point{100, 100}, 40, 15);
+    Transform rotation;
+    Transform::parse("rotate(30 100 100)", rotation);
+    star->setTransform(rotation);
+    star->setAttribute("stroke-dasharray", std::string("4 2"));
+    source.addElement(std::move(star));
+
+    std::string svg = source.generateSvgContent();
+    SvgWriter binaryWriter;
+    source.writeBinaryContent(binaryWriter);
+    std::string binary = binaryWriter.takeString();
+
+    SvgDocument document;
+    if (!document.parseBinaryContent(binary) || document.generateSvgContent() != svg) {
+        std::fprintf(stderr, "binary-format: round trip through .svgb changed the SVG output\n");
+        return 1;
+    }
+    std::printf("binary-format: %zu elements, %.1f MiB SVG, %.1f MiB .svgb, best of %d\n",
+                document.getElementCount(), svg.size() / (1024.0 * 1024.0), binary.size() / (1024.0 * 1024.0),
+                repetitions);
+
+    double svgLoadMs = benchBestOfMs(repetitions, [&]() { document.parseSvgContent(svg); });
+    double binaryLoadMs = benchBestOfMs(repetitions, [&]() { document.parseBinaryContent(binary); });
+    document.setFragmentCacheEnabled(false);
+    double svgSaveMs = benchBestOfMs(repetitions, [&]() { document.generateSvgContent(); });
+    double binarySaveMs = benchBestOfMs(repetitions, [&]() {
+        SvgWriter writer;
+        document.writeBinaryContent(writer);
+    });
+
+    std::printf("%-12s %10s %10s\n", "", "load ms", "save ms");
+    std::printf("%-12s %10.2f %10.2f\n", "SVG", svgLoadMs, svgSaveMs);
+    std::printf("%-12s %10.2f %10.2f  (%.1fx faster load)\n", ".svgb", binaryLoadMs, binarySaveMs,
+                svgLoadMs / binaryLoadMs);
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include "benchcommon.h"
+#include "svgcolorparser.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+// The Color::fromString this replaced: lowercased copy, std::map of the 17
+// SVG 1.1 basic names, sscanf for the numeric forms. Kept as the baseline.
+static Color legacyColorFromString(const std::string& s_in) {
+    Color c;
+    std::string s = s_in;
+    std::transform(s.begin(), s.end(), s.begin(), ::tolower);
+    static const std::map<std::string, Color> colorNameToHex = {
+        {"black", {0, 0, 0, 255}}, {"silver", {192, 192, 192, 255}},
+        {"gray", {128, 128, 128, 255}}, {"white", {255, 255, 255, 255}},
+        {"maroon", {128, 0, 0, 255}}, {"red", {255, 0, 0, 255}},
+        {"purple", {128, 0, 128, 255}}, {"fuchsia", {255, 0, 255, 255}},
+        {"green", {0, 128, 0, 255}}, {"lime", {0, 255, 0, 255}},
+        {"olive", {128, 128, 0, 255}}, {"yellow", {255, 255, 0, 255}},
+        {"navy", {0, 0, 128, 255}}, {"blue", {0, 0, 255, 255}},
+        {"teal", {0, 128, 128, 255}}, {"aqua", {0, 255, 255, 255}},
+        {"transparent", {0, 0, 0, 0}}
+    };
+    if (s.empty() || s == "none") {
+        c.alpha = 0;
+        return c;
+    }
+    auto it = colorNameToHex.find(s);
+    if (it != colorNameToHex.end()) {
+        return it->second;
+    }
+    if (s.rfind("rgba", 0) == 0) {
+        double alpha_double;
+        if (sscanf(s.c_str(), "rgba(%d,%d,%d,%lf)", &c.r, &c.g, &c.b, &alpha_double) == 4) {
+            c.alpha = static_cast<int>(alpha_double * 255.0);
+        } else {
+            c.alpha = 0;
+        }
+    } else if (s.rfind("rgb", 0) == 0) {
+        c.alpha = sscanf(s.c_str(), "rgb(%d,%d,%d)", &c.r, &c.g, &c.b) == 3 ? 255 : 0;
+    } else if (s[0] == '#') {
+        if (s.length() == 7) {
+            sscanf(s.c_str(), "#%02x%02x%02x", &c.r, &c.g, &c.b);
+            c.alpha = 255;
+        } else if (s.length() == 9) {
+            sscanf(s.c_str(), "#%02x%02x%02x%02x", &c.r, &c.g, &c.b, &c.alpha);
+        } else if (s.length() == 4) {
+            int r, g, b;
+            sscanf(s.c_str(), "#%1x%1x%1x", &r, &g, &b);
+            c = {r * 17, g * 17, b * 17, 255};
+        } else if (s.length() == 5) {
+            int r, g, b, a;
+            sscanf(s.c_str(), "#%1x%1x%1x%1x", &r, &g, &b, &a);
+            c = {r * 17, g * 17, b * 17, a * 17};
+        } else {
+            c.alpha = 0;
+        }
+    } else {
+        c = {0, 0, 0, 0};
+    }
+    return c;
+}
+
+static bool sameColor(const Color& a, const Color& b) {
+    // The legacy parser truncated alpha, the new one rounds
+    return a.r == b.r && a.g == b.g && a.b == b.b && std::abs(a.alpha - b.alpha) <= 1;
+}
+
+// Parses a typical mix of fill/stroke values with both implementations and
+// checks they agree on every value the old parser understood.
+// Usage: SvgEngineBench color-parse [iterations]
+int runColorParseBench(int argc, char* argv[]) {
+    int iterations = argc > 0 ? std::atoi(argv[0]) : 200000;
+    if (iterations <= 0) {
+        std::fprintf(stderr, "color-parse: iterations must be positive\n");
+        return 1;
+    }
+
+    const std::vector<std::string> shared = {
+        "black", "White", "red", "navy", "transparent", "none", "",
+        "#3366cc", "#ABCDEF", "#fff", "#1234", "#11223344", "rgb(200,40,40)", "rgb(0, 128, 255)", "rgba(10,20,30,0.5)",
+    };
+    const std::vector<std::string> newOnly = {
+        "cornflowerblue", "LightGoldenrodYellow", "rebeccapurple", " #3366cc ", "rgb(100%, 50%, 0%)",
+        "rgba(10, 20, 30, 50%)", "RGB(1 2 3)", "rgb(255 0 0 / 0.25)",
+    };
+    const std::vector<std::string> invalid = {"#12", "#ggg", "rgb(1,2)", "rgb(1,2,3", "notacolor", "rgb(1%,2,3)"};
+
+    for (const auto& value : shared) {
+        Color expected = legacyColorFromString(value);
+        Color actual = Color::fromString(value);
+        if (!sameColor(expected, actual)) {
+            std::fprintf(stderr, "color-parse: \"%s\" gives %s, legacy %s\n", value.c_str(),
+                         actual.toString().c_str(), expected.toString().c_str());
+            return 1;
+        }
+    }
+    for (const auto& value : newOnly) {
+        Color color;
+        if (!parseSvgColor(value, color)) {
+            std::fprintf(stderr, "color-parse: \"%s\" was rejected\n", value.c_str());
+            return 1;
+        }
+    }
+    for (const auto& value : invalid) {
+        Color color;
+        if (parseSvgColor(value, color)) {
+            std::fprintf(stderr, "color-parse: \"%s\" was accepted\n", value.c_str());
+            return 1;
+        }
+    }
+
+    std::printf("color-parse: %zu values x %d iterations\n", shared.size(), iterations);
+    uint64_t checksum = 0;
+    double legacyMs = benchBestOfMs(3, [&]() {
+        for (int i = 0; i < iterations; ++i) {
+            for (const auto& value : shared) {
+                checksum += legacyColorFromString(value).r;
+            }
+        }
+    });
+    double newMs = benchBestOfMs(3, [&]() {
+        for (int i = 0; i < iterations; ++i) {
+            for (const auto& value : shared) {
+                checksum += Color::fromString(value).r;
+            }
+        }
+    });
+    double calls = static_cast<double>(iterations) * shared.size();
+    std::printf("%-10s %10.2f ms %8.1f ns/value\n", "legacy", legacyMs, legacyMs * 1e6 / calls);
+    std::printf("%-10s %10.2f ms %8.1f ns/value %6.2fx\n", "current", newMs, newMs * 1e6 / calls, legacyMs / newMs);
+    // Keeps the loops from being optimized away
+    volatile uint64_t sink = checksum;
+    (void)sink;
+    return 0;
+}
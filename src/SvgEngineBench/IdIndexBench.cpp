@@ -0,0 +1,68 @@
+#include "benchcommon.h"
+#include "svgdocument.h"
+#include "svgshapes.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+// Fills a document with `elements` rectangles that carry ids, then looks up and
+// removes every id in shuffled order, checking the index against the elements.
+// Usage: SvgEngineBench id-index [elements] [repetitions]
+int runIdIndexBench(int argc, char* argv[]) {
+    int count = argc > 0 ? std::atoi(argv[0]) : 100000;
+    int repetitions = argc > 1 ? std::atoi(argv[1]) : 3;
+    if (count <= 0 || repetitions <= 0) {
+        std::fprintf(stderr, "id-index: arguments must be positive\n");
+        return 1;
+    }
+
+    std::vector<std::string> ids;
+    ids.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        ids.push_back("shape" + std::to_string(i));
+    }
+    std::vector<std::string> order = ids;
+    std::shuffle(order.begin(), order.end(), std::mt19937(42));
+
+    std::printf("id-index: %d elements, best of %d\n", count, repetitions);
+    bool consistent = true;
+    double findMs = 0;
+    double removeMs = benchBestOfMs(repetitions, [&]() {
+        SvgDocument document;
+        for (const auto& id : ids) {
+            auto rect = std::make_unique<SvgRectangle>(Point{0, 0}, 10, 10);
+            rect->setID(id);
+            document.addElement(std::move(rect));
+        }
+        findMs = benchBestOfMs(1, [&]() {
+            for (const auto& id : order) {
+                const SvgElement* element = document.findElementById(id);
+                if (!element || element->getID() != id) {
+                    consistent = false;
+                }
+            }
+        });
+        for (size_t i = 0; i < order.size(); ++i) {
+            if (!document.removeElementById(order[i]) || document.findElementById(order[i])) {
+                consistent = false;
+            }
+            // Spot-check that compaction kept the survivors reachable
+            if (i % 997 == 0 && i + 1 < order.size() && !document.findElementById(order[i + 1])) {
+                consistent = false;
+            }
+        }
+        if (document.getElementCount() != 0) {
+            consistent = false;
+        }
+    });
+    if (!consistent) {
+        std::fprintf(stderr, "id-index: index and elements disagree\n");
+        return 1;
+    }
+    std::printf("%-10s %12.2f ms %10.3f us/op\n", "find", findMs, findMs * 1000.0 / count);
+    std::printf("%-10s %12.2f ms %10.3f us/op (including inserts)\n", "remove", removeMs, removeMs * 1000.0 / count);
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include "benchcommon.h"
+#include "svgdocument.h"
+#include "svgshapes.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+// Saves a large document, edits `edits` elements and saves again, comparing a
+// full re-serialization with a save served from the fragment cache. Fails if
+// the two outputs differ.
+// Usage: SvgEngineBench incremental-save [elements] [edits] [repetitions]
+int runIncrementalSaveBench(int argc, char* argv[]) {
+    int elements = argc > 0 ? std::atoi(argv[0]) : 50000;
+    int edits = argc > 1 ? std::atoi(argv[1]) : 10;
+    int repetitions = argc > 2 ? std::atoi(argv[2]) : 5;
+    if (elements <= 0 || edits < 0 || repetitions <= 0) {
+        std::fprintf(stderr, "incremental-save: invalid arguments\n");
+        return 1;
+    }
+
+    int shapesPerGroup = 1000;
+    std::string svg = makeGroupedSvg((elements + shapesPerGroup - 1) / shapesPerGroup, shapesPerGroup);
+    SvgDocument cached;
+    SvgDocument uncached;
+    cached.parseSvgContent(svg);
+    uncached.parseSvgContent(svg);
+    cached.setFragmentCacheEnabled(true);
+    size_t count = cached.getElementCount();
+    std::printf("incremental-save: %zu elements, %d edits per save, best of %d\n", count, edits, repetitions);
+
+    // Prime the cache the way the first save of a session would
+    double firstMs = benchBestOfMs(1, [&]() { cached.generateSvgContent(); });
+
+    int round = 0;
+    auto editBoth = [&]() {
+        ++round;
+        for (int i = 0; i < edits; ++i) {
+            size_t position = (static_cast<size_t>(i) * 7919 + round) % count;
+            for (SvgDocument* document : {&cached, &uncached}) {
+                SvgElement* element = document->getElements()[position].get();
+                element->setOpacity(0.5 + 0.25 * ((round + i) % 2));
+            }
+        }
+    };
+
+    editBoth();
+    if (uncached.generateSvgContent() != cached.generateSvgContent()) {
+        std::fprintf(stderr, "incremental-save: cached output differs from a full serialization\n");
+        return 1;
+    }
+    double uncachedMs = benchBestOfMs(repetitions, [&]() { uncached.generateSvgContent(); });
+    double cachedMs = benchBestOfMs(repetitions, [&]() {
+        editBoth();
+        cached.generateSvgContent();
+    });
+
+    std::printf("%-24s %10.2f ms\n", "first save (cold cache)", firstMs);
+    std::printf("%-24s %10.2f ms\n", "full serialization", uncachedMs);
+    std::printf("%-24s %10.2f ms  (%.1fx)\n", "incremental save", cachedMs, uncachedMs / cachedMs);
+    return 0;
+}
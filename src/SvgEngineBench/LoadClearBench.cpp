@@ -0,0 +1,36 @@
+#include "benchcommon.h"
+#include "svgdocument.h"
+#include <cstdio>
+#include <cstdlib>
+
+// Times a full parse and the clearElements that follows it, the two phases
+// dominated by per-element allocation and release.
+// Usage: SvgEngineBench load-clear [groups] [shapesPerGroup] [repetitions]
+int runLoadClearBench(int argc, char* argv[]) {
+    int groups = argc > 0 ? std::atoi(argv[0]) : 100;
+    int shapesPerGroup = argc > 1 ? std::atoi(argv[1]) : 1000;
+    int repetitions = argc > 2 ? std::atoi(argv[2]) : 5;
+    if (groups <= 0 || shapesPerGroup <= 0 || repetitions <= 0) {
+        std::fprintf(stderr, "load-clear: arguments must be positive\n");
+        return 1;
+    }
+
+    std::string svg = makeGroupedSvg(groups, shapesPerGroup);
+    std::printf("load-clear: %d elements, %.1f MiB, best of %d\n",
+                groups * shapesPerGroup, svg.size() / (1024.0 * 1024.0), repetitions);
+
+    SvgDocument document;
+    double parseMs = std::numeric_limits<double>::max();
+    double clearMs = std::numeric_limits<double>::max();
+    for (int i = 0; i < repetitions; ++i) {
+        parseMs = std::min(parseMs, benchBestOfMs(1, [&]() { document.parseSvgContent(svg); }));
+        if (document.getElementCount() != static_cast<size_t>(groups) * shapesPerGroup) {
+            std::fprintf(stderr, "load-clear: parsed %zu elements\n", document.getElementCount());
+            return 1;
+        }
+        clearMs = std::min(clearMs, benchBestOfMs(1, [&]() { document.clearElements(); }));
+    }
+    std::printf("%-8s %12.2f ms\n", "parse", parseMs);
+    std::printf("%-8s %12.2f ms\n", "clear", clearMs);
+    return 0;
+}
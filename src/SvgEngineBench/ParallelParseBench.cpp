@@ -0,0 +1,54 @@
+#include "benchcommon.h"
+#include "svgdocument.h"
+#include "svgparallel.h"
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Parses the same grouped document with 1, 2, 4, ... threads up to the core
+// count (or maxThreads) and prints time and speedup relative to the serial parse.
+// Usage: SvgEngineBench parallel-parse [groups] [shapesPerGroup] [repetitions] [maxThreads]
+int runParallelParseBench(int argc, char* argv[]) {
+    int groups = argc > 0 ? std::atoi(argv[0]) : 256;
+    int shapesPerGroup = argc > 1 ? std::atoi(argv[1]) : 400;
+    int repetitions = argc > 2 ? std::atoi(argv[2]) : 5;
+    int maxThreads = svgResolveThreadCount(argc > 3 ? std::atoi(argv[3]) : 0);
+    if (groups <= 0 || shapesPerGroup <= 0 || repetitions <= 0) {
+        std::fprintf(stderr, "parallel-parse: arguments must be positive\n");
+        return 1;
+    }
+
+    std::string svg = makeGroupedSvg(groups, shapesPerGroup);
+    std::printf("parallel-parse: %d groups x %d shapes, %.1f MiB, best of %d\n",
+                groups, shapesPerGroup, svg.size() / (1024.0 * 1024.0), repetitions);
+
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    std::printf("%8s %12s %10s %10s\n", "threads", "ms", "MiB/s", "speedup");
+    double serialMs = 0;
+    size_t expectedElements = 0;
+    for (int threads : threadCounts) {
+        size_t elements = 0;
+        double ms = benchBestOfMs(repetitions, [&]() {
+            SvgDocument document;
+            document.setParseThreadCount(threads);
+            document.parseSvgContent(svg);
+            elements = document.getElementCount();
+        });
+        if (threads == 1) {
+            serialMs = ms;
+            expectedElements = elements;
+        } else if (elements != expectedElements) {
+            std::fprintf(stderr, "parallel-parse: %d threads produced %zu elements, expected %zu\n",
+                         threads, elements, expectedElements);
+            return 1;
+        }
+        std::printf("%8d %12.2f %10.1f %9.2fx\n", threads, ms,
+                    svg.size() / (1024.0 * 1024.0) / (ms / 1000.0), serialMs / ms);
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include "benchcommon.h"
+#include "svgdocument.h"
+#include "svgparallel.h"
+#include "svgwriter.h"
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Serializes one large document with 1, 2, 4, ... threads up to the core count
+// (or maxThreads), both into memory and through a chunked sink as saveSvgFile
+// does, and fails unless every result is byte-identical to the serial output.
+// Usage: SvgEngineBench parallel-write [elements] [repetitions] [maxThreads]
+int runParallelWriteBench(int argc, char* argv[]) {
+    int elements = argc > 0 ? std::atoi(argv[0]) : 1000000;
+    int repetitions = argc > 1 ? std::atoi(argv[1]) : 3;
+    int maxThreads = svgResolveThreadCount(argc > 2 ? std::atoi(argv[2]) : 0);
+    if (elements <= 0 || repetitions <= 0) {
+        std::fprintf(stderr, "parallel-write: arguments must be positive\n");
+        return 1;
+    }
+
+    SvgDocument document;
+    int shapesPerGroup = 1000;
+    document.parseSvgContent(makeGroupedSvg((elements + shapesPerGroup - 1) / shapesPerGroup, shapesPerGroup));
+    // Measure serialization itself, not copies out of the fragment cache
+    document.setFragmentCacheEnabled(false);
+    // Leave a few removed entries behind; they must not disturb the output
+    for (size_t i = 1; i < 32; ++i) {
+        document.removeElement(document.getElements()[i * document.getElements().size() / 32].get());
+    }
+    std::string serial = document.generateSvgContent();
+    std::printf("parallel-write: %zu elements, %.1f MiB, best of %d\n",
+                document.getElementCount(), serial.size() / (1024.0 * 1024.0), repetitions);
+
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    std::printf("%8s %12s %10s %10s\n", "threads", "ms", "MiB/s", "speedup");
+    double serialMs = 0;
+    for (int threads : threadCounts) {
+        std::string output;
+        double ms = benchBestOfMs(repetitions, [&]() {
+            output = document.generateSvgContent(threads);
+        });
+
+        std::string streamed;
+        {
+            SvgWriter writer([&streamed](std::string_view chunk) {
+                streamed.append(chunk);
+                return true;
+            });
+            document.writeSvgContent(writer, threads);
+        }
+        if (output != serial || streamed != serial) {
+            std::fprintf(stderr, "parallel-write: output with %d threads differs from the serial output\n", threads);
+            return 1;
+        }
+
+        if (threads == 1) {
+            serialMs = ms;
+        }
+        std::printf("%8d %12.2f %10.1f %9.2fx\n", threads, ms,
+                    serial.size() / (1024.0 * 1024.0) / (ms / 1000.0), serialMs / ms);
+    }
+    std::printf("all outputs identical\n");
+    return 0;
+}
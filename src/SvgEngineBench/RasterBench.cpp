@@ -0,0 +1,76 @@
+#include "benchcommon.h"
+#include "svgdocument.h"
+#include "svgparallel.h"
+#include "svgrasterizer.h"
+#include "svgtext.h"
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Renders `images` copies of one document with 1, 2, 4, ... threads up to the
+// core count (or maxThreads), every thread painting the same shared document
+// into its own QImage, and fails unless every image matches the serial one.
+// Usage: SvgEngineBench raster [elements] [images] [maxThreads] [scale]
+int runRasterBench(int argc, char* argv[]) {
+    int elements = argc > 0 ? std::atoi(argv[0]) : 20000;
+    int images = argc > 1 ? std::atoi(argv[1]) : 32;
+    int maxThreads = svgResolveThreadCount(argc > 2 ? std::atoi(argv[2]) : 0);
+    double scale = argc > 3 ? std::atof(argv[3]) : 0.25;
+    if (elements <= 0 || images <= 0 || !(scale > 0)) {
+        std::fprintf(stderr, "raster: arguments must be positive\n");
+        return 1;
+    }
+
+    SvgDocument document;
+    int shapesPerGroup = 1000;
+    document.parseSvgContent(makeGroupedSvg((elements + shapesPerGroup - 1) / shapesPerGroup, shapesPerGroup));
+    // Text goes through the font engine, the part most likely to serialize threads
+    for (int i = 0; i < elements / 50; ++i) {
+        Point position{static_cast<double>((i * 53) % 4000), static_cast<double>((i * 97) % 4000)};
+        auto text = std::make_unique<SvgText>(position, "label " + std::to_string(i));
+        text->setFontSize(12 + i % 24);
+        document.addElement(std::move(text));
+    }
+
+    SvgRasterOptions options;
+    options.scale = scale;
+    QImage reference = svgRenderImage(document, options);
+    if (reference.isNull()) {
+        std::fprintf(stderr, "raster: cannot render the document\n");
+        return 1;
+    }
+    std::printf("raster: %zu elements into %dx%d images, %d images per run\n",
+                document.getElementCount(), reference.width(), reference.height(), images);
+
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    std::printf("%8s %12s %10s %10s\n", "threads", "ms", "images/s", "speedup");
+    double serialMs = 0;
+    for (int threads : threadCounts) {
+        std::vector<QImage> rendered(images);
+        double ms = benchBestOfMs(1, [&]() {
+            svgParallelFor(rendered.size(), threads, [&](size_t index) {
+                rendered[index] = svgRenderImage(document, options);
+            });
+        });
+        for (const QImage& image : rendered) {
+            if (image != reference) {
+                std::fprintf(stderr, "raster: an image rendered on %d threads differs from the serial one\n", threads);
+                return 1;
+            }
+        }
+
+        if (threads == 1) {
+            serialMs = ms;
+        }
+        std::printf("%8d %12.2f %10.1f %9.2fx\n", threads, ms, images / (ms / 1000.0), serialMs / ms);
+    }
+    std::printf("all images identical\n");
+    return 0;
+}
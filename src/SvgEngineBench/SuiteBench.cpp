@@ -0,0 +1,319 @@
+#include "benchcommon.h"
+#include "coresvgengine.h"
+#include "svgdocument.h"
+#include <QCoreApplication>
+#include <QProcess>
+#include <QStringList>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// One shape per line, every one with an id so removal by id can be measured
+// on any mix; "mixed" cycles through the other kinds
+static const char* const suiteMixes[] = {"mixed", "rect", "circle", "ellipse", "line", "polyline", "polygon", "text"};
+static const int suiteSizes[] = {1000, 10000, 100000, 1000000};
+static constexpr int SUITE_REMOVALS = 1000;
+static constexpr int SUITE_COLOR_VALUES = 1000000;
+
+static std::string makeMixSvg(const char* mix, int elements) {
+    std::string svg = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                      "<svg width=\"4000\" height=\"4000\" xmlns=\"http://www.w3.org/2000/svg\">\n";
+    bool mixed = std::strcmp(mix, "mixed") == 0;
+    for (int i = 0; i < elements; ++i) {
+        const char* kind = mixed ? suiteMixes[1 + i % 7] : mix;
+        std::string id = " id=\"e" + std::to_string(i) + "\"";
+        std::string x = std::to_string((i * 37) % 4000);
+        std::string y = std::to_string((i * 29) % 4000);
+        if (std::strcmp(kind, "rect") == 0) {
+            svg += "  <rect" + id + " x=\"" + x + "\" y=\"" + y + "\" width=\"20\" height=\"10\" fill=\"#3366cc\" stroke=\"black\"/>\n";
+        } else if (std::strcmp(kind, "circle") == 0) {
+            svg += "  <circle" + id + " cx=\"" + x + "\" cy=\"" + y + "\" r=\"7.5\" fill=\"rgb(200,40,40)\" opacity=\"0.8\"/>\n";
+        } else if (std::strcmp(kind, "ellipse") == 0) {
+            svg += "  <ellipse" + id + " cx=\"" + x + "\" cy=\"" + y + "\" rx=\"12\" ry=\"6.25\" fill=\"orange\" transform=\"rotate(15)\"/>\n";
+        } else if (std::strcmp(kind, "line") == 0) {
+            svg += "  <line" + id + " x1=\"" + x + "\" y1=\"" + y + "\" x2=\"" + y + "\" y2=\"" + x + "\" stroke=\"green\" stroke-width=\"2\"/>\n";
+        } else if (std::strcmp(kind, "polyline") == 0) {
+            svg += "  <polyline" + id + " points=\"" + x + "," + y + " " + y + "," + x + " 10.5,20.25 30,40\" stroke=\"blue\"/>\n";
+        } else if (std::strcmp(kind, "polygon") == 0) {
+            svg += "  <polygon" + id + " points=\"" + x + "," + y + " " + y + "," + x + " 10.5,20.25 30,40 5,5\" fill=\"#80ff0080\"/>\n";
+        } else {
+            svg += "  <text" + id + " x=\"" + x + "\" y=\"" + y + "\" font-family=\"Arial\" font-size=\"14\">label " + x + "</text>\n";
+        }
+    }
+    svg += "</svg>\n";
+    return svg;
+}
+
+struct SuiteResult {
+    std::string name;
+    std::string mix;
+    int elements = 0;
+    uint64_t bytes = 0;
+    double bestMs = 0;
+    double itemsPerSecond = 0;
+    double mbPerSecond = 0;
+    uint64_t allocations = 0;
+    uint64_t allocatedBytes = 0;
+    uint64_t peakRssBytes = 0;
+};
+
+// Runs setup() then a timed fn() `repetitions` times. Allocations are taken
+// from the first run, which is what a user opening or saving once would see.
+// The peak RSS is that of the process, which runs a single mix and size.
+template <typename Setup, typename Fn>
+static SuiteResult runSuiteCase(int repetitions, Setup&& setup, Fn&& fn) {
+    SuiteResult result;
+    result.bestMs = std::numeric_limits<double>::max();
+    for (int i = 0; i < repetitions; ++i) {
+        setup();
+        BenchAllocations before = benchAllocations();
+        double ms = benchBestOfMs(1, fn);
+        BenchAllocations after = benchAllocations();
+        result.bestMs = std::min(result.bestMs, ms);
+        if (i == 0) {
+            result.allocations = after.count - before.count;
+            result.allocatedBytes = after.bytes - before.bytes;
+        }
+    }
+    result.peakRssBytes = benchPeakRssBytes();
+    return result;
+}
+
+static void recordSuiteResult(std::vector<SuiteResult>& results, SuiteResult result, const char* name,
+                              const char* mix, int elements, uint64_t bytes, double items) {
+    result.name = name;
+    result.mix = mix;
+    result.elements = elements;
+    result.bytes = bytes;
+    double seconds = result.bestMs / 1000.0;
+    result.itemsPerSecond = seconds > 0 ? items / seconds : 0;
+    result.mbPerSecond = seconds > 0 ? bytes / seconds / (1024.0 * 1024.0) : 0;
+    std::string allocations = benchCountsAllocations() ? std::to_string(result.allocations) : "n/a";
+    std::printf("%-14s %-9s %8d %10.2f ms %12.0f /s %9.1f MiB/s %10s allocs %8.1f MiB rss\n", name, mix, elements,
+                result.bestMs, result.itemsPerSecond, result.mbPerSecond, allocations.c_str(),
+                result.peakRssBytes / (1024.0 * 1024.0));
+    std::fflush(stdout);
+    results.push_back(std::move(result));
+}
+
+// One result per line and a fixed key order, so two runs diff cleanly
+static bool writeSuiteJson(const std::string& path, const std::vector<SuiteResult>& results, int repetitions) {
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        return false;
+    }
+    std::fprintf(file, "{\n  \"suite\": \"SvgEngineBench\",\n  \"repetitions\": %d,\n  \"results\": [\n", repetitions);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const SuiteResult& r = results[i];
+        // null where allocations are not counted, so a missing count never reads as zero
+        std::string allocations = benchCountsAllocations() ? std::to_string(r.allocations) : "null";
+        std::string allocatedBytes = benchCountsAllocations() ? std::to_string(r.allocatedBytes) : "null";
+        std::fprintf(file,
+                     "    {\"benchmark\": \"%s\", \"mix\": \"%s\", \"elements\": %d, \"bytes\": %llu, \"bestMs\": %.3f, "
+                     "\"itemsPerSecond\": %.0f, \"mbPerSecond\": %.2f, \"allocations\": %s, \"allocatedBytes\": %s, "
+                     "\"peakRssBytes\": %llu}%s\n",
+                     r.name.c_str(), r.mix.c_str(), r.elements, static_cast<unsigned long long>(r.bytes), r.bestMs,
+                     r.itemsPerSecond, r.mbPerSecond, allocations.c_str(), allocatedBytes.c_str(),
+                     static_cast<unsigned long long>(r.peakRssBytes), i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+    return std::fclose(file) == 0;
+}
+
+// Parse, file load, serialization and removal by id of one mix and size,
+// appended to `results`. "load-file" is CoreSvgEngine::loadSvgFile, the engine
+// side of CanvasArea::openFileWithEngine; building scene items needs a GUI application.
+static bool runSuiteCases(const char* mix, int elements, int repetitions, const std::filesystem::path& filePath,
+                          std::vector<SuiteResult>& results) {
+    std::string svg = makeMixSvg(mix, elements);
+    double count = static_cast<double>(elements);
+
+    std::unique_ptr<SvgDocument> document;
+    SuiteResult parse = runSuiteCase(
+        repetitions, [&]() { document = std::make_unique<SvgDocument>(); },
+        [&]() { document->parseSvgContent(svg); });
+    if (document->getElementCount() != static_cast<size_t>(elements)) {
+        std::fprintf(stderr, "suite: %s/%d parsed %zu elements\n", mix, elements, document->getElementCount());
+        return false;
+    }
+    recordSuiteResult(results, parse, "parse", mix, elements, svg.size(), count);
+
+    {
+        std::ofstream out(filePath, std::ios::binary | std::ios::trunc);
+        out.write(svg.data(), static_cast<std::streamsize>(svg.size()));
+        if (!out.flush()) {
+            std::fprintf(stderr, "suite: cannot write %s\n", filePath.string().c_str());
+            return false;
+        }
+    }
+    std::unique_ptr<CoreSvgEngine> engine;
+    bool loaded = true;
+    SuiteResult load = runSuiteCase(
+        repetitions, [&]() { engine = std::make_unique<CoreSvgEngine>(); },
+        [&]() { loaded = engine->loadSvgFile(filePath.string()) && loaded; });
+    engine.reset();
+    if (!loaded) {
+        std::fprintf(stderr, "suite: %s/%d failed to load from disk\n", mix, elements);
+        return false;
+    }
+    recordSuiteResult(results, load, "load-file", mix, elements, svg.size(), count);
+
+    // Without the fragment cache every run serializes every element
+    document->setFragmentCacheEnabled(false);
+    std::string generated;
+    SuiteResult generate = runSuiteCase(
+        repetitions, [&]() { generated.clear(); generated.shrink_to_fit(); },
+        [&]() { generated = document->generateSvgContent(); });
+    recordSuiteResult(results, generate, "generate", mix, elements, generated.size(), count);
+    generated.clear();
+    generated.shrink_to_fit();
+
+    // Ids spread evenly over the document, removed from a fresh parse each run
+    int removals = std::min(elements, SUITE_REMOVALS);
+    std::vector<std::string> ids;
+    for (int i = 0; i < removals; ++i) {
+        ids.push_back("e" + std::to_string(static_cast<long long>(i) * elements / removals));
+    }
+    bool removed = true;
+    SuiteResult remove = runSuiteCase(
+        repetitions,
+        [&]() {
+            document = std::make_unique<SvgDocument>();
+            document->parseSvgContent(svg);
+        },
+        [&]() {
+            for (const auto& id : ids) {
+                removed = document->removeElementById(id) && removed;
+            }
+        });
+    if (!removed || document->getElementCount() != static_cast<size_t>(elements - removals)) {
+        std::fprintf(stderr, "suite: %s/%d removal by id missed elements\n", mix, elements);
+        return false;
+    }
+    recordSuiteResult(results, remove, "remove-by-id", mix, elements, 0, removals);
+    return true;
+}
+
+// Results of one mix and size, passed from the suite-case process to the suite
+static bool writeSuiteCaseResults(const std::string& path, const std::vector<SuiteResult>& results) {
+    std::ofstream out(path, std::ios::trunc);
+    out.precision(17);
+    for (const SuiteResult& r : results) {
+        out << r.name << ' ' << r.mix << ' ' << r.elements << ' ' << r.bytes << ' ' << r.bestMs << ' '
+            << r.itemsPerSecond << ' ' << r.mbPerSecond << ' ' << r.allocations << ' ' << r.allocatedBytes << ' '
+            << r.peakRssBytes << '\n';
+    }
+    return static_cast<bool>(out.flush());
+}
+
+static bool readSuiteCaseResults(const std::string& path, std::vector<SuiteResult>& results) {
+    std::ifstream in(path);
+    std::string line;
+    size_t read = 0;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        SuiteResult r;
+        if (!(fields >> r.name >> r.mix >> r.elements >> r.bytes >> r.bestMs >> r.itemsPerSecond >> r.mbPerSecond >>
+              r.allocations >> r.allocatedBytes >> r.peakRssBytes)) {
+            return false;
+        }
+        results.push_back(std::move(r));
+        ++read;
+    }
+    return read > 0;
+}
+
+// Child process of the suite: one mix and size, so its peak RSS is theirs alone.
+// Usage: SvgEngineBench suite-case <mix> <elements> <repetitions> <results file>
+int runSuiteCaseBench(int argc, char* argv[]) {
+    if (argc < 4) {
+        std::fprintf(stderr, "suite-case: expected <mix> <elements> <repetitions> <results file>\n");
+        return 1;
+    }
+    int elements = std::atoi(argv[1]);
+    int repetitions = std::atoi(argv[2]);
+    std::error_code error;
+    // Named after this process so concurrent suites do not share the file
+    std::filesystem::path filePath = std::filesystem::temp_directory_path(error) /
+        ("svgenginebench-suite-" + std::to_string(QCoreApplication::applicationPid()) + ".svg");
+    std::vector<SuiteResult> results;
+    if (error || elements <= 0 || repetitions <= 0 ||
+        !runSuiteCases(argv[0], elements, repetitions, filePath, results)) {
+        return 1;
+    }
+    std::filesystem::remove(filePath, error);
+    return writeSuiteCaseResults(argv[3], results) ? 0 : 1;
+}
+
+// Every element mix at 1k to 1M elements, plus fill/stroke color parsing. Each
+// mix and size runs in a suite-case child process, so the peak RSS recorded
+// with a case is what that mix and size needed rather than the largest so far.
+// Usage: SvgEngineBench suite [output.json] [maxElements] [repetitions]
+int runSuiteBench(int argc, char* argv[]) {
+    std::string outputPath = argc > 0 ? argv[0] : "svgenginebench.json";
+    int maxElements = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    int repetitions = argc > 2 ? std::atoi(argv[2]) : 3;
+    if (maxElements <= 0 || repetitions <= 0) {
+        std::fprintf(stderr, "suite: arguments must be positive\n");
+        return 1;
+    }
+
+    std::error_code error;
+    std::filesystem::path resultsPath = std::filesystem::temp_directory_path(error) /
+        ("svgenginebench-suite-case-" + std::to_string(QCoreApplication::applicationPid()) + ".txt");
+    if (error) {
+        std::fprintf(stderr, "suite: no temporary directory: %s\n", error.message().c_str());
+        return 1;
+    }
+
+    std::printf("suite: up to %d elements, best of %d, writing %s\n", maxElements, repetitions, outputPath.c_str());
+    std::fflush(stdout);
+    std::vector<SuiteResult> results;
+    for (int elements : suiteSizes) {
+        if (elements > maxElements) {
+            break;
+        }
+        for (const char* mix : suiteMixes) {
+            std::filesystem::remove(resultsPath, error);
+            // The child prints its own result lines to the shared console
+            int exitCode = QProcess::execute(QCoreApplication::applicationFilePath(),
+                                             QStringList{"suite-case", mix, QString::number(elements),
+                                                         QString::number(repetitions),
+                                                         QString::fromStdString(resultsPath.string())});
+            if (exitCode != 0 || !readSuiteCaseResults(resultsPath.string(), results)) {
+                std::fprintf(stderr, "suite: %s/%d failed\n", mix, elements);
+                return 1;
+            }
+        }
+    }
+    std::filesystem::remove(resultsPath, error);
+
+    const std::vector<std::string> colors = {
+        "black", "cornflowerblue", "none", "#3366cc", "#fff", "#11223344",
+        "rgb(200,40,40)", "rgb(0, 128, 255)", "rgba(10,20,30,0.5)", "rgb(100%, 50%, 0%)",
+    };
+    uint64_t checksum = 0;
+    SuiteResult colorParse = runSuiteCase(
+        repetitions, []() {},
+        [&]() {
+            for (int i = 0; i < SUITE_COLOR_VALUES; ++i) {
+                checksum += Color::fromString(colors[i % colors.size()]).r;
+            }
+        });
+    recordSuiteResult(results, colorParse, "color-parse", "colors", SUITE_COLOR_VALUES, 0, SUITE_COLOR_VALUES);
+
+    if (!writeSuiteJson(outputPath, results, repetitions)) {
+        std::fprintf(stderr, "suite: cannot write %s\n", outputPath.c_str());
+        return 1;
+    }
+    // Keeps the color loop from being optimized away
+    volatile uint64_t sink = checksum;
+    (void)sink;
+    return 0;
+}
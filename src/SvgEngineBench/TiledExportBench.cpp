@@ -0,0 +1,110 @@
+#include "benchcommon.h"
+#include "svgdocument.h"
+#include "svgparallel.h"
+#include "svgtiledexport.h"
+#include <QImage>
+#include <QString>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <system_error>
+
+// Largest difference of any channel between two images of the same size, in
+// premultiplied form; -1 if the sizes differ
+static int maxChannelDifference(const QImage& first, const QImage& second) {
+    if (first.size() != second.size()) {
+        return -1;
+    }
+    QImage a = first.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    QImage b = second.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    int difference = 0;
+    for (int y = 0; y < a.height(); ++y) {
+        const uchar* rowA = a.constScanLine(y);
+        const uchar* rowB = b.constScanLine(y);
+        for (int i = 0; i < a.width() * 4; ++i) {
+            difference = std::max(difference, std::abs(rowA[i] - rowB[i]));
+        }
+    }
+    return difference;
+}
+
+// Checks that a tiled export decodes to what svgRenderImage draws, then
+// exports a poster at `scale` (20000x20000 pixels by default) and reports the
+// time and peak memory next to what a single image of that size would take.
+// Usage: SvgEngineBench tiled-export [scale] [elements] [tileSize] [threads]
+int runTiledExportBench(int argc, char* argv[]) {
+    double scale = argc > 0 ? std::atof(argv[0]) : 5.0;
+    int elements = argc > 1 ? std::atoi(argv[1]) : 100000;
+    int tileSize = argc > 2 ? std::atoi(argv[2]) : 512;
+    int threads = svgResolveThreadCount(argc > 3 ? std::atoi(argv[3]) : 0);
+    if (!(scale > 0) || elements <= 0 || tileSize <= 0) {
+        std::fprintf(stderr, "tiled-export: arguments must be positive\n");
+        return 1;
+    }
+
+    std::error_code error;
+    std::filesystem::path filePath = std::filesystem::temp_directory_path(error) / "svgenginebench-export.png";
+    if (error) {
+        std::fprintf(stderr, "tiled-export: no temporary directory: %s\n", error.message().c_str());
+        return 1;
+    }
+
+    SvgDocument document;
+    int shapesPerGroup = 1000;
+    document.parseSvgContent(makeGroupedSvg((elements + shapesPerGroup - 1) / shapesPerGroup, shapesPerGroup));
+
+    // Small tiles, so the check crosses many tile and band edges
+    SvgRasterOptions checkOptions;
+    checkOptions.scale = 0.3;
+    SvgTiledExportOptions checkExport;
+    checkExport.tileSize = 64;
+    checkExport.threads = threads;
+    if (!svgExportPng(document, filePath.string(), checkOptions, checkExport)) {
+        std::fprintf(stderr, "tiled-export: cannot write %s\n", filePath.string().c_str());
+        return 1;
+    }
+    QImage reference = svgRenderImage(document, checkOptions);
+    int difference = maxChannelDifference(QImage(QString::fromStdString(filePath.string())), reference);
+    // Straight-alpha PNG storage may round a premultiplied channel by one
+    if (difference < 0 || difference > 1) {
+        std::fprintf(stderr, "tiled-export: the exported image differs from svgRenderImage (by %d)\n", difference);
+        return 1;
+    }
+    std::printf("tiled-export: %dx%d check image matches svgRenderImage\n", reference.width(), reference.height());
+    reference = QImage();
+
+    SvgRasterOptions options;
+    options.scale = scale;
+    SvgTiledExportOptions exportOptions;
+    exportOptions.tileSize = tileSize;
+    exportOptions.threads = threads;
+    int progressCalls = 0;
+    exportOptions.progress = [&progressCalls](int, int) {
+        ++progressCalls;
+        return true;
+    };
+    QSize size = svgRasterSize(document, options);
+    uint64_t rssBefore = benchPeakRssBytes();
+    auto start = std::chrono::steady_clock::now();
+    bool exported = svgExportPng(document, filePath.string(), options, exportOptions);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    uint64_t rssAfter = benchPeakRssBytes();
+    uint64_t fileBytes = exported ? std::filesystem::file_size(filePath, error) : 0;
+    std::filesystem::remove(filePath, error);
+    if (!exported) {
+        std::fprintf(stderr, "tiled-export: export of %dx%d failed\n", size.width(), size.height());
+        return 1;
+    }
+
+    double megapixels = static_cast<double>(size.width()) * size.height() / 1e6;
+    std::printf("%zu elements into %dx%d (%.0f Mpixel), %d px tiles, %d threads\n", document.getElementCount(),
+                size.width(), size.height(), megapixels, tileSize, threads);
+    std::printf("%.0f ms, %.1f Mpixel/s, %.1f MiB PNG, %d progress callbacks\n", ms, megapixels / (ms / 1000.0),
+                fileBytes / (1024.0 * 1024.0), progressCalls);
+    std::printf("tile memory %.1f MiB, peak RSS grew by %.1f MiB; one image would be %.1f MiB\n",
+                svgTiledExportMemory(size, exportOptions) / (1024.0 * 1024.0),
+                (rssAfter - std::min(rssBefore, rssAfter)) / (1024.0 * 1024.0), megapixels * 4 * 1e6 / (1024.0 * 1024.0));
+    return 0;
+}
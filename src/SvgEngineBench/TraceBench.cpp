@@ -0,0 +1,54 @@
+#include "benchcommon.h"
+#include "svgdocument.h"
+#include "svgshapes.h"
+#include "svgtrace.h"
+#include <cstdio>
+#include <cstdlib>
+
+// Cost of SVG_TRACE on the parse and setter paths, comparing runs with the
+// runtime switch on and off, then prints the newest records of the dump.
+// Usage: SvgEngineBench trace [groups] [shapesPerGroup] [repetitions] [dumpLines]
+int runTraceBench(int argc, char* argv[]) {
+    int groups = argc > 0 ? std::atoi(argv[0]) : 100;
+    int shapesPerGroup = argc > 1 ? std::atoi(argv[1]) : 1000;
+    int repetitions = argc > 2 ? std::atoi(argv[2]) : 5;
+    int dumpLines = argc > 3 ? std::atoi(argv[3]) : 10;
+    if (groups <= 0 || shapesPerGroup <= 0 || repetitions <= 0 || dumpLines < 0) {
+        std::fprintf(stderr, "trace: arguments must be positive\n");
+        return 1;
+    }
+
+    std::string svg = makeGroupedSvg(groups, shapesPerGroup);
+    const int setterCalls = groups * shapesPerGroup;
+    std::printf("trace: %d elements, %d setter calls, SVG_TRACE_LEVEL %d, best of %d\n",
+                setterCalls, setterCalls, SVG_TRACE_LEVEL, repetitions);
+
+    SvgDocument document;
+    SvgRectangle rectangle({0, 0}, 10, 10);
+    std::printf("%-8s %12s %12s %12s\n", "tracing", "parse ms", "setters ms", "ns/setter");
+    for (bool enabled : {false, true}) {
+        svgTraceSetEnabled(enabled);
+        double parseMs = benchBestOfMs(repetitions, [&]() { document.parseSvgContent(svg); });
+        if (document.getElementCount() != static_cast<size_t>(setterCalls)) {
+            std::fprintf(stderr, "trace: parsed %zu elements\n", document.getElementCount());
+            return 1;
+        }
+        document.clearElements();
+        double setterMs = benchBestOfMs(repetitions, [&]() {
+            for (int i = 0; i < setterCalls; ++i) {
+                rectangle.setWidth(static_cast<double>(i & 1023));
+            }
+        });
+        std::printf("%-8s %12.2f %12.2f %12.1f\n", enabled ? "on" : "off", parseMs, setterMs,
+                    setterMs * 1e6 / setterCalls);
+    }
+
+    std::string dump = svgTraceDump();
+    size_t start = dump.size();
+    for (int line = 0; line < dumpLines && start > 0; ++line) {
+        size_t previous = start > 1 ? dump.rfind('\n', start - 2) : std::string::npos;
+        start = previous == std::string::npos ? 0 : previous + 1;
+    }
+    std::printf("\nNewest trace records:\n%s", dump.c_str() + start);
+    return 0;
+}
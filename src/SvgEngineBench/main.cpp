@@ -0,0 +1,76 @@
+#include "svgtrace.h"
+#include <QGuiApplication>
+#include <QLoggingCategory>
+#include <cstdio>
+#include <cstring>
+
+int runParallelParseBench(int argc, char* argv[]);
+int runIdIndexBench(int argc, char* argv[]);
+int runLoadClearBench(int argc, char* argv[]);
+int runAttributeMemoryBench(int argc, char* argv[]);
+int runColorParseBench(int argc, char* argv[]);
+int runParallelWriteBench(int argc, char* argv[]);
+int runIncrementalSaveBench(int argc, char* argv[]);
+int runBinaryFormatBench(int argc, char* argv[]);
+int runTraceBench(int argc, char* argv[]);
+int runSuiteBench(int argc, char* argv[]);
+int runSuiteCaseBench(int argc, char* argv[]);
+int runRasterBench(int argc, char* argv[]);
+int runTiledExportBench(int argc, char* argv[]);
+
+struct BenchCommand {
+    const char* name;
+    int (*run)(int argc, char* argv[]);
+    const char* description;
+};
+
+static const BenchCommand benchCommands[] = {
+    {"parallel-parse", runParallelParseBench, "parse time vs. thread count for grouped documents"},
+    {"id-index", runIdIndexBench, "lookup and removal by id in large documents"},
+    {"load-clear", runLoadClearBench, "parse and clear time, dominated by element allocation"},
+    {"attribute-memory", runAttributeMemoryBench, "bytes per element for unmodelled attributes"},
+    {"color-parse", runColorParseBench, "fill/stroke color parsing against the sscanf-based parser"},
+    {"parallel-write", runParallelWriteBench, "serialization time vs. thread count; checks output identity"},
+    {"incremental-save", runIncrementalSaveBench, "save after a few edits, with and without the fragment cache"},
+    {"binary-format", runBinaryFormatBench, "load and save as SVG vs. .svgb; checks lossless round trip"},
+    {"trace", runTraceBench, "parse and setter time with element tracing on and off"},
+    {"suite", runSuiteBench, "all core operations at 1k-1M elements per shape mix; writes JSON"},
+    {"suite-case", runSuiteCaseBench, "one shape mix and size of the suite; run by suite in a child process"},
+    {"raster", runRasterBench, "images/s vs. thread count for offscreen rendering; checks identity"},
+    {"tiled-export", runTiledExportBench, "poster-sized PNG export in tiles: time and peak memory"},
+};
+
+static void printUsage() {
+    std::printf("Usage: SvgEngineBench <command> [args...]\n\nCommands:\n");
+    for (const auto& command : benchCommands) {
+        std::printf("  %-16s %s\n", command.name, command.description);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // The raster command paints text, which needs a GUI application; the
+    // offscreen platform keeps the benchmarks runnable without a display
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+
+    // Keep element tracing (see svgtrace.h; the trace command turns it on for
+    // itself) and the per-operation summary logs out of the timings
+    QLoggingCategory::setFilterRules("*.debug=false\n*.info=false");
+    svgTraceSetEnabled(false);
+
+    if (argc < 2) {
+        printUsage();
+        return 1;
+    }
+    for (const auto& command : benchCommands) {
+        if (std::strcmp(argv[1], command.name) == 0) {
+            return command.run(argc - 2, argv + 2);
+        }
+    }
+    std::fprintf(stderr, "Unknown command: %s\n\n", argv[1]);
+    printUsage();
+    return 1;
+}
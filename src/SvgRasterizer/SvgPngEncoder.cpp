@@ -0,0 +1,203 @@
+﻿#include "svgpngencoder.h"
+#include <algorithm>
+#include <cstdlib>
+#include <zlib.h>
+#include <QLoggingCategory>
+Q_DECLARE_LOGGING_CATEGORY(svgPngEncoderLog)
+Q_LOGGING_CATEGORY(svgPngEncoderLog, "SvgPngEncoder")
+
+static constexpr std::size_t PNG_OUTPUT_CHUNK = 64 * 1024;
+static constexpr int PNG_BYTES_PER_PIXEL = 4;
+// Highest width or height the format allows
+static constexpr int PNG_MAX_DIMENSION = 0x7fffffff;
+
+enum PngFilter : unsigned char { FilterNone, FilterSub, FilterUp, FilterAverage, FilterPaeth, FilterCount };
+
+static void putBigEndian(unsigned char* out, uint32_t value) {
+    out[0] = static_cast<unsigned char>(value >> 24);
+    out[1] = static_cast<unsigned char>(value >> 16);
+    out[2] = static_cast<unsigned char>(value >> 8);
+    out[3] = static_cast<unsigned char>(value);
+}
+
+static unsigned char paethPredictor(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = std::abs(p - a);
+    int pb = std::abs(p - b);
+    int pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) {
+        return static_cast<unsigned char>(a);
+    }
+    return static_cast<unsigned char>(pb <= pc ? b : c);
+}
+
+// Filters `row` against `previous` into `out` (without the type byte)
+static void applyFilter(PngFilter filter, const unsigned char* row, const unsigned char* previous,
+                        unsigned char* out, std::size_t size) {
+    for (std::size_t i = 0; i < size; ++i) {
+        int a = i >= PNG_BYTES_PER_PIXEL ? row[i - PNG_BYTES_PER_PIXEL] : 0;
+        int b = previous[i];
+        int c = i >= PNG_BYTES_PER_PIXEL ? previous[i - PNG_BYTES_PER_PIXEL] : 0;
+        unsigned char predicted = 0;
+        switch (filter) {
+        case FilterSub: predicted = static_cast<unsigned char>(a); break;
+        case FilterUp: predicted = static_cast<unsigned char>(b); break;
+        case FilterAverage: predicted = static_cast<unsigned char>((a + b) / 2); break;
+        case FilterPaeth: predicted = paethPredictor(a, b, c); break;
+        default: break;
+        }
+        out[i] = static_cast<unsigned char>(row[i] - predicted);
+    }
+}
+
+// The usual heuristic for picking a filter: the smallest sum of the filtered
+// bytes read as signed values, i.e. the row closest to all zeros
+static uint64_t filterCost(const unsigned char* filtered, std::size_t size) {
+    uint64_t cost = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+        cost += static_cast<uint64_t>(std::abs(static_cast<int>(static_cast<signed char>(filtered[i]))));
+    }
+    return cost;
+}
+
+SvgPngEncoder::SvgPngEncoder(SvgWriter::Sink sink, int width, int height, int level)
+    : m_stream(std::make_unique<z_stream_s>()), m_sink(std::move(sink)), m_width(width), m_height(height) {
+    if (width <= 0 || height <= 0 || width > PNG_MAX_DIMENSION / PNG_BYTES_PER_PIXEL) {
+        qCWarning(svgPngEncoderLog) << "Invalid PNG size" << width << "x" << height;
+        m_stream.reset();
+        m_ok = false;
+        return;
+    }
+    if (deflateInit(m_stream.get(), level) != Z_OK) {
+        qCWarning(svgPngEncoderLog) << "Failed to initialize PNG encoder";
+        m_stream.reset();
+        m_ok = false;
+        return;
+    }
+    std::size_t rowBytes = static_cast<std::size_t>(width) * PNG_BYTES_PER_PIXEL;
+    m_row.resize(rowBytes);
+    m_previous.assign(rowBytes, 0);
+    m_filtered.resize(2 * (rowBytes + 1));
+    m_output.resize(PNG_OUTPUT_CHUNK);
+
+    static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    unsigned char header[13];
+    putBigEndian(header, static_cast<uint32_t>(width));
+    putBigEndian(header + 4, static_cast<uint32_t>(height));
+    header[8] = 8;  // bits per channel
+    header[9] = 6;  // truecolor with alpha
+    header[10] = 0; // deflate
+    header[11] = 0; // adaptive filtering
+    header[12] = 0; // not interlaced
+    m_ok = m_sink(std::string_view(reinterpret_cast<const char*>(signature), sizeof(signature))) &&
+           writeChunk("IHDR", header, sizeof(header));
+}
+
+SvgPngEncoder::~SvgPngEncoder() {
+    if (m_stream) {
+        deflateEnd(m_stream.get());
+    }
+}
+
+bool SvgPngEncoder::writeRow(const uint32_t* pixels) {
+    if (!m_ok || m_rows >= m_height) {
+        m_ok = false;
+        return false;
+    }
+
+    // PNG stores straight alpha
+    unsigned char* out = m_row.data();
+    for (int x = 0; x < m_width; ++x, out += PNG_BYTES_PER_PIXEL) {
+        uint32_t pixel = pixels[x];
+        uint32_t alpha = pixel >> 24;
+        uint32_t red = (pixel >> 16) & 0xff;
+        uint32_t green = (pixel >> 8) & 0xff;
+        uint32_t blue = pixel & 0xff;
+        if (alpha != 0xff && alpha != 0) {
+            red = std::min<uint32_t>((red * 0xff + alpha / 2) / alpha, 0xff);
+            green = std::min<uint32_t>((green * 0xff + alpha / 2) / alpha, 0xff);
+            blue = std::min<uint32_t>((blue * 0xff + alpha / 2) / alpha, 0xff);
+        }
+        out[0] = static_cast<unsigned char>(red);
+        out[1] = static_cast<unsigned char>(green);
+        out[2] = static_cast<unsigned char>(blue);
+        out[3] = static_cast<unsigned char>(alpha);
+    }
+
+    // Keep the cheapest filter in the first half of m_filtered, try the next in the second
+    std::size_t size = m_row.size();
+    unsigned char* best = m_filtered.data();
+    unsigned char* candidate = best + size + 1;
+    uint64_t bestCost = UINT64_MAX;
+    for (int filter = FilterNone; filter < FilterCount; ++filter) {
+        candidate[0] = static_cast<unsigned char>(filter);
+        applyFilter(static_cast<PngFilter>(filter), m_row.data(), m_previous.data(), candidate + 1, size);
+        uint64_t cost = filterCost(candidate + 1, size);
+        if (cost < bestCost) {
+            bestCost = cost;
+            std::swap(best, candidate);
+        }
+    }
+
+    m_stream->next_in = best;
+    m_stream->avail_in = static_cast<uInt>(size + 1);
+    deflateInput(Z_NO_FLUSH);
+    std::swap(m_row, m_previous);
+    ++m_rows;
+    return m_ok;
+}
+
+bool SvgPngEncoder::finish() {
+    if (m_ok && !m_finished) {
+        if (m_rows != m_height) {
+            qCWarning(svgPngEncoderLog) << "PNG finished after" << m_rows << "of" << m_height << "rows";
+            m_ok = false;
+            return false;
+        }
+        m_stream->next_in = nullptr;
+        m_stream->avail_in = 0;
+        m_finished = deflateInput(Z_FINISH) && writeChunk("IEND", nullptr, 0);
+    }
+    return m_ok;
+}
+
+bool SvgPngEncoder::writeChunk(const char type[4], const unsigned char* data, std::size_t size) {
+    unsigned char head[8];
+    putBigEndian(head, static_cast<uint32_t>(size));
+    std::copy(type, type + 4, head + 4);
+    uLong crc = crc32(0L, head + 4, 4);
+    if (size > 0) {
+        crc = crc32(crc, data, static_cast<uInt>(size));
+    }
+    unsigned char tail[4];
+    putBigEndian(tail, static_cast<uint32_t>(crc));
+    if (!m_sink(std::string_view(reinterpret_cast<const char*>(head), sizeof(head))) ||
+        (size > 0 && !m_sink(std::string_view(reinterpret_cast<const char*>(data), size))) ||
+        !m_sink(std::string_view(reinterpret_cast<const char*>(tail), sizeof(tail)))) {
+        m_ok = false;
+    }
+    return m_ok;
+}
+
+// Runs deflate until the pending input is consumed (or the stream is finished),
+// writing each full output buffer as an IDAT chunk
+bool SvgPngEncoder::deflateInput(int flush) {
+    z_stream_s& stream = *m_stream;
+    while (true) {
+        stream.next_out = reinterpret_cast<Bytef*>(m_output.data());
+        stream.avail_out = static_cast<uInt>(m_output.size());
+        int result = deflate(&stream, flush);
+        if (result == Z_STREAM_ERROR) {
+            qCWarning(svgPngEncoderLog) << "Compression failed";
+            m_ok = false;
+            return false;
+        }
+        std::size_t produced = m_output.size() - stream.avail_out;
+        if (produced > 0 && !writeChunk("IDAT", reinterpret_cast<const unsigned char*>(m_output.data()), produced)) {
+            return false;
+        }
+        if (flush == Z_FINISH ? result == Z_STREAM_END : stream.avail_out > 0) {
+            return true;
+        }
+    }
+}
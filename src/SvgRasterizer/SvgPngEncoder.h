@@ -0,0 +1,51 @@
+﻿#pragma once
+#include "svgwriter.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct z_stream_s;
+
+// Encodes an 8-bit RGBA PNG one row at a time, top to bottom, handing the file
+// bytes to `sink` as they are produced. Only the current and previous rows are
+// kept, so images of any height stream through in constant memory. finish()
+// writes the end of the file and must be called after the last row.
+class SvgPngEncoder {
+public:
+    SvgPngEncoder(SvgWriter::Sink sink, int width, int height, int level = DEFAULT_LEVEL);
+    ~SvgPngEncoder();
+
+    SvgPngEncoder(const SvgPngEncoder&) = delete;
+    SvgPngEncoder& operator=(const SvgPngEncoder&) = delete;
+
+    // `width` pixels in premultiplied 0xAARRGGBB form, as in a QImage of
+    // Format_ARGB32_Premultiplied
+    bool writeRow(const uint32_t* pixels);
+    // Fails unless exactly `height` rows were written
+    bool finish();
+    bool ok() const { return m_ok; }
+
+    // Below zlib's default: rendered images compress nearly as well and
+    // deflate dominates the export time
+    static constexpr int DEFAULT_LEVEL = 3;
+
+private:
+    bool writeChunk(const char type[4], const unsigned char* data, std::size_t size);
+    bool deflateInput(int flush);
+
+    std::unique_ptr<z_stream_s> m_stream;
+    SvgWriter::Sink m_sink;
+    int m_width;
+    int m_height;
+    int m_rows = 0;
+    // Unfiltered bytes of the current and previous row
+    std::vector<unsigned char> m_row;
+    std::vector<unsigned char> m_previous;
+    // Filter type byte plus the row, once for each filter tried
+    std::vector<unsigned char> m_filtered;
+    std::string m_output;
+    bool m_ok = true;
+    bool m_finished = false;
+};
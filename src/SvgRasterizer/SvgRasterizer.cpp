@@ -0,0 +1,231 @@
+﻿#include "svgrasterizer.h"
+#include "../CoreSvgEngine/svgdocument.h"
+#include "../CoreSvgEngine/svgshapes.h"
+#include "../CoreSvgEngine/svgtext.h"
+#include <QLoggingCategory>
+#include <QPainter>
+#include <QPainterPath>
+#include <QPolygonF>
+#include <QFont>
+#include <QFontMetricsF>
+#include <QBrush>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+Q_LOGGING_CATEGORY(svgRasterizerLog, "SvgRasterizer")
+
+QColor svgQColor(const Color& color) {
+    return QColor(color.r, color.g, color.b, color.alpha);
+}
+
+QPen svgStrokePen(const SvgElement& element) {
+    QPen pen;
+    pen.setWidth(element.getStrokeWidth());
+    pen.setColor(svgQColor(element.getStrokeColor()));
+    return pen;
+}
+
+QSize svgRasterSize(const SvgDocument& document, const SvgRasterOptions& options) {
+    if (!options.size.isEmpty()) {
+        return options.size;
+    }
+    double width = std::ceil(document.getWidth() * options.scale);
+    double height = std::ceil(document.getHeight() * options.scale);
+    // QImage dimensions are ints; anything near the limit cannot be allocated anyway
+    if (!(width >= 1 && height >= 1 && width <= INT_MAX && height <= INT_MAX)) {
+        return QSize();
+    }
+    return QSize(static_cast<int>(width), static_cast<int>(height));
+}
+
+QTransform svgRasterTransform(const SvgDocument& document, const SvgRasterOptions& options) {
+    double width = document.getWidth();
+    double height = document.getHeight();
+    if (options.size.isEmpty() || width <= 0 || height <= 0) {
+        return QTransform::fromScale(options.scale, options.scale);
+    }
+    double scaleX = options.size.width() / width;
+    double scaleY = options.size.height() / height;
+    if (!options.keepAspectRatio) {
+        return QTransform::fromScale(scaleX, scaleY);
+    }
+    double scale = std::min(scaleX, scaleY);
+    return QTransform(scale, 0, 0, scale,
+                      (options.size.width() - width * scale) / 2, (options.size.height() - height * scale) / 2);
+}
+
+// Same setup as the scene's QGraphicsSimpleTextItem
+static QFont textFont(const SvgText& text) {
+    QFont font;
+    font.setFamily(QString::fromStdString(text.getFontFamily()));
+    font.setPointSizeF(text.getFontSize());
+    font.setBold(text.isBold());
+    font.setItalic(text.isItalic());
+    return font;
+}
+
+// Where an element may leave paint, in its own coordinates before the stroke.
+// Text is laid out as in the editor, with the top of the line at the
+// position, so the model's baseline-centred estimate does not cover it; a
+// point size of fontSize is also a third larger than fontSize pixels.
+static BoundingBox paintBounds(const SvgElement& element) {
+    if (element.getType() != SvgElementType::Text) {
+        return element.getBoundingBox();
+    }
+    const auto& text = static_cast<const SvgText&>(element);
+    Point position = text.getPosition();
+    double em = text.getFontSize() * 2;
+    return {position.x, position.y, position.x + em * static_cast<double>(text.getTextContent().size()), position.y + em};
+}
+
+BoundingBox svgPaintExtent(const SvgElement& element, double margin) {
+    BoundingBox box = paintBounds(element);
+    double stroke = element.getStrokeWidth();
+    box = element.getTransform().mapBoundingBox({box.minX - stroke, box.minY - stroke, box.maxX + stroke, box.maxY + stroke});
+    return {box.minX - margin, box.minY - margin, box.maxX + margin, box.maxY + margin};
+}
+
+double svgPixelsToDocument(const QPainter& painter, double pixels) {
+    double determinant = std::abs(painter.worldTransform().determinant());
+    return determinant > 0 ? pixels / std::sqrt(determinant) : 0.0;
+}
+
+void svgPaintElement(QPainter& painter, const SvgElement& element) {
+    painter.save();
+    const Transform& transform = element.getTransform();
+    if (!transform.isIdentity()) {
+        painter.setTransform(QTransform(transform.a, transform.b, transform.c, transform.d, transform.e, transform.f), true);
+    }
+    painter.setOpacity(element.getOpacity());
+    painter.setPen(svgStrokePen(element));
+    painter.setBrush(QBrush(svgQColor(element.getFillColor())));
+
+    switch (element.getType()) {
+    case SvgElementType::Line: {
+        const auto& line = static_cast<const SvgLine&>(element);
+        painter.drawLine(QPointF(line.getP1().x, line.getP1().y), QPointF(line.getP2().x, line.getP2().y));
+        break;
+    }
+    case SvgElementType::Rectangle: {
+        const auto& rect = static_cast<const SvgRectangle&>(element);
+        painter.drawRect(QRectF(rect.getTopLeft().x, rect.getTopLeft().y, rect.getWidth(), rect.getHeight()));
+        break;
+    }
+    case SvgElementType::Circle: {
+        const auto& circle = static_cast<const SvgCircle&>(element);
+        painter.drawEllipse(QPointF(circle.getCenter().x, circle.getCenter().y), circle.getRadius(), circle.getRadius());
+        break;
+    }
+    case SvgElementType::Ellipse: {
+        const auto& ellipse = static_cast<const SvgEllipse&>(element);
+        painter.drawEllipse(QPointF(ellipse.getCenter().x, ellipse.getCenter().y), ellipse.getRx(), ellipse.getRy());
+        break;
+    }
+    case SvgElementType::Polygon:
+    case SvgElementType::Pentagon:
+    case SvgElementType::Hexagon:
+    case SvgElementType::Star: {
+        const auto& polygon = static_cast<const SvgPolygon&>(element);
+        QPolygonF qPolygon;
+        qPolygon.reserve(static_cast<int>(polygon.getPoints().size()));
+        for (const auto& point : polygon.getPoints()) {
+            qPolygon << QPointF(point.x, point.y);
+        }
+        painter.drawPolygon(qPolygon);
+        break;
+    }
+    case SvgElementType::Polyline: {
+        const auto& polyline = static_cast<const SvgPolyline&>(element);
+        QPolygonF qPolyline;
+        qPolyline.reserve(static_cast<int>(polyline.getPoints().size()));
+        for (const auto& point : polyline.getPoints()) {
+            qPolyline << QPointF(point.x, point.y);
+        }
+        // Polylines are open paths and are never filled
+        painter.drawPolyline(qPolyline);
+        break;
+    }
+    case SvgElementType::Text: {
+        const auto& text = static_cast<const SvgText&>(element);
+        QFont font = textFont(text);
+        QString content = QString::fromStdString(text.getTextContent());
+        QPointF baseline(text.getPosition().x, text.getPosition().y + QFontMetricsF(font).ascent());
+
+        // Text is painted with the fill colour, falling back to the stroke colour
+        Color textColor = text.getFillColor();
+        QColor color = svgQColor(textColor.alpha > 0 ? textColor : text.getStrokeColor());
+
+        // Outline only when a visible stroke is set
+        Color strokeColor = text.getStrokeColor();
+        if (strokeColor.alpha > 0 && text.getStrokeWidth() > 0) {
+            QPainterPath path;
+            path.addText(baseline, font, content);
+            painter.setBrush(color);
+            painter.drawPath(path);
+        } else {
+            painter.setPen(color);
+            painter.setFont(font);
+            painter.drawText(baseline, content);
+        }
+        break;
+    }
+    }
+    painter.restore();
+}
+
+void svgPaintBackground(QPainter& painter, const SvgDocument& document, const SvgRasterOptions& options) {
+    if (options.background.isValid()) {
+        painter.save();
+        painter.resetTransform();
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.fillRect(QRect(0, 0, painter.device()->width(), painter.device()->height()), options.background);
+        painter.restore();
+        return;
+    }
+    painter.fillRect(QRectF(0, 0, document.getWidth(), document.getHeight()), svgQColor(document.getBackgroundColor()));
+}
+
+void svgPaintDocument(QPainter& painter, const SvgDocument& document, const QRectF& area) {
+    bool cull = !area.isEmpty();
+    BoundingBox visible{area.left(), area.top(), area.right(), area.bottom()};
+    // Cosmetic pens and antialiasing reach about a pixel beyond the geometry,
+    // however small a pixel is in document units
+    double margin = svgPixelsToDocument(painter, 2.0);
+
+    size_t painted = 0;
+    for (const auto& element : document.getElements()) {
+        if (!element) {
+            continue;
+        }
+        if (cull && !svgPaintExtent(*element, margin).intersects(visible)) {
+            continue;
+        }
+        svgPaintElement(painter, *element);
+        ++painted;
+    }
+    qCDebug(svgRasterizerLog) << "Painted" << painted << "of" << document.getElementCount() << "elements";
+}
+
+QImage svgRenderImage(const SvgDocument& document, const SvgRasterOptions& options) {
+    QSize size = svgRasterSize(document, options);
+    if (size.isEmpty()) {
+        qCWarning(svgRasterizerLog) << "Nothing to render: empty document or image size";
+        return QImage();
+    }
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    if (image.isNull()) {
+        qCWarning(svgRasterizerLog) << "Cannot allocate a" << size.width() << "x" << size.height() << "image";
+        return image;
+    }
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing, options.antialiasing);
+    painter.setRenderHint(QPainter::TextAntialiasing, options.antialiasing);
+    painter.setTransform(svgRasterTransform(document, options));
+    svgPaintBackground(painter, document, options);
+    svgPaintDocument(painter, document, painter.transform().inverted().mapRect(QRectF(image.rect())));
+    painter.end();
+    return image;
+}
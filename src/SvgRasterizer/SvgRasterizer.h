@@ -0,0 +1,65 @@
+﻿#pragma once
+#include <QColor>
+#include <QImage>
+#include <QPen>
+#include <QRectF>
+#include <QSize>
+#include <QTransform>
+#include "../CoreSvgEngine/coresvgstructs.h"
+
+class QPainter;
+class SvgDocument;
+class SvgElement;
+
+// Offscreen rendering of the SvgDocument model with QPainter, without a scene
+// or widgets. Elements are drawn the way SvgSceneAdapter's items show them, so
+// an image matches the editor's view of the document.
+//
+// Everything here is safe to call from any thread, for different documents or
+// concurrently for the same one, as long as no thread modifies that document
+// meanwhile. Rendering only reads elements; writing a document is not
+// read-only in this sense, see SvgDocument::writeSvgContent. Text needs a
+// QGuiApplication to exist (fonts come from the platform plugin); headless
+// processes can use the "offscreen" platform.
+
+struct SvgRasterOptions {
+    // Output size in pixels; when empty it is the document size times `scale`
+    QSize size;
+    // Pixels per document unit, used when `size` is empty
+    double scale = 1.0;
+    // With an explicit size: scale both axes alike and center the document,
+    // rather than stretch it to fill the image
+    bool keepAspectRatio = true;
+    // Fills the whole image when valid. Otherwise the image is transparent
+    // outside the document and the document shows its own background color.
+    QColor background;
+    bool antialiasing = true;
+};
+
+QColor svgQColor(const Color& color);
+// Pen for an element's stroke, shared with the scene items
+QPen svgStrokePen(const SvgElement& element);
+
+// Image size the options give for `document`; empty for an empty document
+QSize svgRasterSize(const SvgDocument& document, const SvgRasterOptions& options);
+// Maps document coordinates to the pixels of an image of svgRasterSize()
+QTransform svgRasterTransform(const SvgDocument& document, const SvgRasterOptions& options);
+
+// Document area `element` may paint to, widened by `margin` document units on
+// every side for antialiasing and cosmetic pens
+BoundingBox svgPaintExtent(const SvgElement& element, double margin);
+// Document units covered by `pixels` pixels at the painter's current scale
+double svgPixelsToDocument(const QPainter& painter, double pixels);
+
+// Draws one element in document coordinates, on top of the painter's transform
+void svgPaintElement(QPainter& painter, const SvgElement& element);
+// Fills what lies behind the elements, as described for
+// SvgRasterOptions::background; the painter maps document coordinates to the device
+void svgPaintBackground(QPainter& painter, const SvgDocument& document, const SvgRasterOptions& options);
+// Draws every element in document order. With a non-empty `area` (document
+// coordinates) elements that cannot reach into it are skipped.
+void svgPaintDocument(QPainter& painter, const SvgDocument& document, const QRectF& area = QRectF());
+
+// Renders `document` into a new ARGB32 premultiplied image; a null image if
+// the size is empty or the image cannot be allocated
+QImage svgRenderImage(const SvgDocument& document, const SvgRasterOptions& options = SvgRasterOptions());
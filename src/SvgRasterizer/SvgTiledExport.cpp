@@ -0,0 +1,166 @@
+﻿#include "svgtiledexport.h"
+#include "../CoreSvgEngine/svgdocument.h"
+#include "../CoreSvgEngine/svgparallel.h"
+#include <QLoggingCategory>
+#include <QPainter>
+#include <QSaveFile>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+Q_DECLARE_LOGGING_CATEGORY(svgTiledExportLog)
+Q_LOGGING_CATEGORY(svgTiledExportLog, "SvgTiledExport")
+
+static constexpr int MIN_TILE_SIZE = 16;
+// A band holds the pixels of this many tiles per thread (at least
+// MIN_BAND_TILES); wider images get bands fewer rows high instead
+static constexpr int BAND_TILES_PER_THREAD = 2;
+static constexpr int MIN_BAND_TILES = 8;
+
+struct TileLayout {
+    int tileSize;
+    int bandHeight;
+    int columns;
+};
+
+static TileLayout tileLayout(QSize size, int threads, int tileSize) {
+    TileLayout layout;
+    layout.tileSize = std::max(tileSize, MIN_TILE_SIZE);
+    int64_t bandPixels = int64_t{layout.tileSize} * layout.tileSize * std::max(BAND_TILES_PER_THREAD * threads, MIN_BAND_TILES);
+    layout.bandHeight = static_cast<int>(std::clamp<int64_t>(bandPixels / std::max(size.width(), 1), 1, layout.tileSize));
+    layout.columns = (size.width() + layout.tileSize - 1) / layout.tileSize;
+    return layout;
+}
+
+uint64_t svgTiledExportMemory(QSize size, const SvgTiledExportOptions& exportOptions) {
+    if (size.isEmpty()) {
+        return 0;
+    }
+    TileLayout layout = tileLayout(size, svgResolveThreadCount(exportOptions.threads), exportOptions.tileSize);
+    return uint64_t{4} * layout.columns * layout.tileSize * layout.bandHeight;
+}
+
+bool svgExportPng(const SvgDocument& document, const std::string& filePath, const SvgRasterOptions& options,
+                  const SvgTiledExportOptions& exportOptions) {
+    auto startTime = std::chrono::steady_clock::now();
+    QSize size = svgRasterSize(document, options);
+    if (size.isEmpty()) {
+        qCWarning(svgTiledExportLog) << "Nothing to export: empty document or image size";
+        return false;
+    }
+    const int width = size.width();
+    const int height = size.height();
+    const int threads = svgResolveThreadCount(exportOptions.threads);
+    const TileLayout layout = tileLayout(size, threads, exportOptions.tileSize);
+    const int tileSize = layout.tileSize;
+    const int bandHeight = layout.bandHeight;
+    const int columns = layout.columns;
+    const int bands = (height + bandHeight - 1) / bandHeight;
+    const QTransform transform = svgRasterTransform(document, options);
+
+    // Which elements each band needs, found once instead of per tile; a
+    // margin of two pixels covers antialiasing and cosmetic pens
+    double determinant = std::abs(transform.determinant());
+    double margin = determinant > 0 ? 2.0 / std::sqrt(determinant) : 0.0;
+    // An element that reaches into the image, with the pixels it may paint to
+    struct PlacedElement {
+        const SvgElement* element;
+        QRectF bounds;
+    };
+    std::vector<PlacedElement> placed;
+    std::vector<std::vector<uint32_t>> bandElements(bands);
+    for (const auto& element : document.getElements()) {
+        if (!element) {
+            continue;
+        }
+        BoundingBox box = svgPaintExtent(*element, margin);
+        QRectF bounds = transform.mapRect(QRectF(box.minX, box.minY, box.maxX - box.minX, box.maxY - box.minY));
+        // Written so that non-finite bounds are skipped as well
+        if (!(bounds.right() > 0 && bounds.bottom() > 0 && bounds.left() < width && bounds.top() < height)) {
+            continue;
+        }
+        int firstBand = static_cast<int>(std::max(bounds.top(), 0.0) / bandHeight);
+        int lastBand = static_cast<int>(std::min(bounds.bottom(), height - 1.0) / bandHeight);
+        uint32_t index = static_cast<uint32_t>(placed.size());
+        placed.push_back({element.get(), bounds});
+        for (int band = firstBand; band <= lastBand; ++band) {
+            bandElements[band].push_back(index);
+        }
+    }
+
+    std::vector<QImage> tiles;
+    tiles.reserve(columns);
+    for (int column = 0; column < columns; ++column) {
+        tiles.emplace_back(tileSize, bandHeight, QImage::Format_ARGB32_Premultiplied);
+        if (tiles.back().isNull()) {
+            qCWarning(svgTiledExportLog) << "Cannot allocate" << columns << "tiles of" << tileSize << "x" << bandHeight;
+            return false;
+        }
+    }
+
+    // QSaveFile writes to a temporary file; commit() syncs it to disk and renames it over the target
+    QSaveFile file(QString::fromStdString(filePath));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(svgTiledExportLog) << "Failed to open file for writing:" << QString::fromStdString(filePath) << file.errorString();
+        return false;
+    }
+    SvgPngEncoder encoder([&file](std::string_view chunk) {
+        return file.write(chunk.data(), static_cast<qint64>(chunk.size())) == static_cast<qint64>(chunk.size());
+    }, width, height, exportOptions.compressionLevel);
+
+    std::vector<uint32_t> row(static_cast<size_t>(width));
+    bool cancelled = false;
+    for (int band = 0; band < bands && encoder.ok() && !cancelled; ++band) {
+        const int top = band * bandHeight;
+        const int rows = std::min(bandHeight, height - top);
+        const std::vector<uint32_t>& elements = bandElements[band];
+
+        svgParallelFor(tiles.size(), threads, [&](size_t column) {
+            QImage& tile = tiles[column];
+            const int left = static_cast<int>(column) * tileSize;
+            QRectF tileRect(left, top, tileSize, bandHeight);
+            tile.fill(Qt::transparent);
+            QPainter painter(&tile);
+            painter.setRenderHint(QPainter::Antialiasing, options.antialiasing);
+            painter.setRenderHint(QPainter::TextAntialiasing, options.antialiasing);
+            // Whole-pixel offsets, so tiles meet without seams
+            painter.setTransform(transform * QTransform::fromTranslate(-left, -top));
+            svgPaintBackground(painter, document, options);
+            for (uint32_t index : elements) {
+                if (placed[index].bounds.intersects(tileRect)) {
+                    svgPaintElement(painter, *placed[index].element);
+                }
+            }
+        });
+
+        for (int y = 0; y < rows && encoder.ok(); ++y) {
+            for (int column = 0; column < columns; ++column) {
+                const int left = column * tileSize;
+                const auto* pixels = reinterpret_cast<const uint32_t*>(tiles[column].constScanLine(y));
+                std::copy(pixels, pixels + std::min(tileSize, width - left), row.begin() + left);
+            }
+            encoder.writeRow(row.data());
+        }
+        if (exportOptions.progress && !exportOptions.progress(top + rows, height)) {
+            cancelled = true;
+        }
+    }
+
+    if (cancelled || !encoder.finish()) {
+        // commit() then discards the temporary file and leaves the target untouched
+        file.cancelWriting();
+    }
+    if (!file.commit()) {
+        if (cancelled) {
+            qCInfo(svgTiledExportLog) << "Export cancelled:" << QString::fromStdString(filePath);
+        } else {
+            qCWarning(svgTiledExportLog) << "Failed to write file:" << QString::fromStdString(filePath) << file.errorString();
+        }
+        return false;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    qCDebug(svgTiledExportLog) << "Exported" << width << "x" << height << "PNG in" << bands << "bands of"
+                               << columns << "tiles on" << threads << "threads in" << seconds * 1000.0 << "ms";
+    return true;
+}
@@ -0,0 +1,32 @@
+﻿#pragma once
+#include "svgrasterizer.h"
+#include "svgpngencoder.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// Called on the exporting thread after each band of rows is written, with the
+// rows done so far; returning false cancels the export
+using SvgExportProgress = std::function<bool(int rowsDone, int rowsTotal)>;
+
+struct SvgTiledExportOptions {
+    // Edge length of the square tiles rendered independently
+    int tileSize = 512;
+    // Tiles rendered at once; 0 = one per core
+    int threads = 0;
+    int compressionLevel = SvgPngEncoder::DEFAULT_LEVEL;
+    SvgExportProgress progress;
+};
+
+// Writes `document` as a PNG of any size without ever holding the whole image.
+// The image is cut into bands one tile high; the tiles of a band are rendered
+// in parallel and its rows then go straight into the PNG encoder, so memory
+// stays at one band of tiles (fewer rows per band for very wide images) plus
+// an index of the element bounds. Renders as svgRenderImage() does with the
+// same options. Like writeSvgFile, the file is replaced only once complete; false
+// on errors and when cancelled, leaving any existing file untouched.
+bool svgExportPng(const SvgDocument& document, const std::string& filePath, const SvgRasterOptions& options,
+                  const SvgTiledExportOptions& exportOptions = SvgTiledExportOptions());
+
+// Bytes of tile images an export of an image of `size` holds at once
+uint64_t svgTiledExportMemory(QSize size, const SvgTiledExportOptions& exportOptions = SvgTiledExportOptions());
@@ -0,0 +1,369 @@
+﻿#include "svgsceneadapter.h"
+#include "../CoreSvgEngine/svgdocument.h"
+#include "../CoreSvgEngine/svgshapes.h"
+#include "../CoreSvgEngine/svgtext.h"
+#include "../SvgRasterizer/svgrasterizer.h"
+#include <QLoggingCategory>
+#include <QPen>
+#include <QBrush>
+#include <QFont>
+#include <QColor>
+#include <QPointF>
+#include <QPolygonF>
+#include <QPainterPath>
+#include <QTransform>
+#include <QGraphicsScene>
+#include <QGraphicsLineItem>
+#include <QGraphicsRectItem>
+#include <QGraphicsEllipseItem>
+#include <QGraphicsPolygonItem>
+#include <QGraphicsPathItem>
+#include <QGraphicsSimpleTextItem>
+#include <algorithm>
+#include <cmath>
+
+Q_LOGGING_CATEGORY(svgSceneAdapterLog, "SvgSceneAdapter")
+
+SvgSceneAdapter::~SvgSceneAdapter() {
+    clear();
+}
+
+void SvgSceneAdapter::build(SvgDocument& document, QGraphicsScene* scene) {
+    clear();
+    m_document = &document;
+    document.clearViewItems();
+    m_lazy = document.getElementCount() > static_cast<size_t>(LAZY_THRESHOLD);
+
+    if (!m_lazy) {
+        int built = 0;
+        for (const auto& element : document.getElements()) {
+            QGraphicsItem* item = element ? createItem(*element) : nullptr;
+            if (item) {
+                document.bindViewItem(element.get(), item);
+                scene->addItem(item);
+                ++built;
+            }
+        }
+        qCDebug(svgSceneAdapterLog) << "Built" << built << "graphics items";
+        return;
+    }
+
+    m_slots.reserve(document.getElementCount());
+    m_slotIndex.reserve(document.getElementCount());
+    for (const auto& element : document.getElements()) {
+        if (element) {
+            m_slotIndex.emplace(element.get(), static_cast<int>(m_slots.size()));
+            m_slots.push_back({element.get(), element->getTransform().mapBoundingBox(element->getBoundingBox())});
+        }
+    }
+    buildGrid();
+    qCDebug(svgSceneAdapterLog) << "Indexed" << m_slots.size() << "elements for lazy materialization,"
+                                << m_columns << "x" << m_rows << "cells";
+}
+
+void SvgSceneAdapter::buildGrid() {
+    BoundingBox extent;
+    bool first = true;
+    for (const auto& slot : m_slots) {
+        if (first) {
+            extent = slot.bounds;
+            first = false;
+        } else {
+            extent.minX = std::min(extent.minX, slot.bounds.minX);
+            extent.minY = std::min(extent.minY, slot.bounds.minY);
+            extent.maxX = std::max(extent.maxX, slot.bounds.maxX);
+            extent.maxY = std::max(extent.maxY, slot.bounds.maxY);
+        }
+    }
+
+    // Aim for a handful of elements per cell, within a bounded cell count
+    static constexpr int MAX_CELLS_PER_AXIS = 1024;
+    static constexpr int MAX_CELLS_PER_ELEMENT = 64;
+    double width = std::max(extent.maxX - extent.minX, 1.0);
+    double height = std::max(extent.maxY - extent.minY, 1.0);
+    m_cellSize = std::sqrt(width * height * 4.0 / std::max<std::size_t>(m_slots.size(), 1));
+    m_cellSize = std::max({m_cellSize, width / MAX_CELLS_PER_AXIS, height / MAX_CELLS_PER_AXIS});
+    m_gridX = extent.minX;
+    m_gridY = extent.minY;
+    m_columns = std::clamp(static_cast<int>(width / m_cellSize) + 1, 1, MAX_CELLS_PER_AXIS);
+    m_rows = std::clamp(static_cast<int>(height / m_cellSize) + 1, 1, MAX_CELLS_PER_AXIS);
+    m_cells.assign(static_cast<std::size_t>(m_columns) * m_rows, {});
+
+    for (int i = 0; i < static_cast<int>(m_slots.size()); ++i) {
+        const Slot& slot = m_slots[i];
+        int x0 = std::clamp(static_cast<int>((slot.bounds.minX - m_gridX) / m_cellSize), 0, m_columns - 1);
+        int y0 = std::clamp(static_cast<int>((slot.bounds.minY - m_gridY) / m_cellSize), 0, m_rows - 1);
+        int x1 = std::clamp(static_cast<int>((slot.bounds.maxX - m_gridX) / m_cellSize), 0, m_columns - 1);
+        int y1 = std::clamp(static_cast<int>((slot.bounds.maxY - m_gridY) / m_cellSize), 0, m_rows - 1);
+        if ((x1 - x0 + 1) * (y1 - y0 + 1) > MAX_CELLS_PER_ELEMENT) {
+            m_oversized.push_back(i);
+            continue;
+        }
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                m_cells[static_cast<std::size_t>(y) * m_columns + x].push_back(i);
+            }
+        }
+    }
+}
+
+void SvgSceneAdapter::materialize(int index, QGraphicsScene* scene) {
+    SvgElement* element = m_slots[index].element;
+    if (!element || element->getViewItem()) {
+        return;
+    }
+    QGraphicsItem* item = createItem(*element);
+    if (!item) {
+        return;
+    }
+    // Items arrive in viewport order, so the stacking order of the document
+    // is kept through the Z value: between the background at -1 and the
+    // items the editor adds at 0
+    item->setZValue(-1.0 + (index + 1.0) / (m_slots.size() + 1.0));
+    m_slots[index].createdPos = item->pos();
+    m_document->bindViewItem(element, item);
+    m_live.push_back(index);
+    scene->addItem(item);
+}
+
+void SvgSceneAdapter::visitSlot(int index, const BoundingBox& area, QGraphicsScene* scene) {
+    Slot& slot = m_slots[index];
+    if (slot.visitStamp == m_stamp || !slot.element) {
+        return;
+    }
+    slot.visitStamp = m_stamp;
+    if (slot.bounds.intersects(area)) {
+        slot.areaStamp = m_stamp;
+        materialize(index, scene);
+    }
+}
+
+void SvgSceneAdapter::updateViewport(const QRectF& visibleRect, QGraphicsScene* scene) {
+    if (!m_lazy || !m_document || visibleRect.isEmpty()) {
+        return;
+    }
+
+    // Half a viewport of margin on every side so short scrolls find items ready
+    QRectF range = visibleRect.adjusted(-visibleRect.width() / 2, -visibleRect.height() / 2,
+                                        visibleRect.width() / 2, visibleRect.height() / 2);
+    BoundingBox area{range.left(), range.top(), range.right(), range.bottom()};
+    ++m_stamp;
+    std::size_t liveBefore = m_live.size();
+
+    if (area.maxX >= m_gridX && area.maxY >= m_gridY) {
+        int x0 = std::clamp(static_cast<int>((area.minX - m_gridX) / m_cellSize), 0, m_columns - 1);
+        int y0 = std::clamp(static_cast<int>((area.minY - m_gridY) / m_cellSize), 0, m_rows - 1);
+        int x1 = std::clamp(static_cast<int>((area.maxX - m_gridX) / m_cellSize), 0, m_columns - 1);
+        int y1 = std::clamp(static_cast<int>((area.maxY - m_gridY) / m_cellSize), 0, m_rows - 1);
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                for (int index : m_cells[static_cast<std::size_t>(y) * m_columns + x]) {
+                    visitSlot(index, area, scene);
+                }
+            }
+        }
+    }
+    for (int index : m_oversized) {
+        visitSlot(index, area, scene);
+    }
+
+    // Release what is out of range. Items the user has selected or moved may
+    // be referenced by commands and panels, so they are pinned instead.
+    int released = 0;
+    int pinned = 0;
+    for (std::size_t i = 0; i < m_live.size();) {
+        int index = m_live[i];
+        Slot& slot = m_slots[index];
+        QGraphicsItem* item = itemForElement(slot.element);
+        if (item->isSelected() || item->pos() != slot.createdPos) {
+            m_slotIndex.erase(slot.element);
+            slot.element = nullptr;
+            ++pinned;
+        } else if (slot.areaStamp == m_stamp) {
+            ++i;
+            continue;
+        } else {
+            m_document->bindViewItem(slot.element, nullptr);
+            if (item->scene()) {
+                item->scene()->removeItem(item);
+            }
+            delete item;
+            ++released;
+        }
+        m_live[i] = m_live.back();
+        m_live.pop_back();
+    }
+    qCDebug(svgSceneAdapterLog) << "Viewport update:" << m_live.size() + released + pinned - liveBefore << "created,"
+                                << released << "released," << pinned << "pinned," << m_live.size() << "live";
+}
+
+void SvgSceneAdapter::materializeAll(QGraphicsScene* scene) {
+    if (!m_lazy || !m_document) {
+        return;
+    }
+    for (int i = 0; i < static_cast<int>(m_slots.size()); ++i) {
+        materialize(i, scene);
+    }
+}
+
+QGraphicsItem* SvgSceneAdapter::createItem(const SvgElement& element) {
+    QAbstractGraphicsShapeItem* shapeItem = nullptr;
+    QGraphicsItem* item = nullptr;
+
+    switch (element.getType()) {
+    case SvgElementType::Line: {
+        const auto& line = static_cast<const SvgLine&>(element);
+        auto lineItem = new QGraphicsLineItem(line.getP1().x, line.getP1().y, line.getP2().x, line.getP2().y);
+        lineItem->setPen(svgStrokePen(element));
+        item = lineItem;
+        break;
+    }
+    case SvgElementType::Rectangle: {
+        const auto& rect = static_cast<const SvgRectangle&>(element);
+        shapeItem = new QGraphicsRectItem(rect.getTopLeft().x, rect.getTopLeft().y, rect.getWidth(), rect.getHeight());
+        break;
+    }
+    case SvgElementType::Circle: {
+        const auto& circle = static_cast<const SvgCircle&>(element);
+        Point c = circle.getCenter();
+        double r = circle.getRadius();
+        shapeItem = new QGraphicsEllipseItem(c.x - r, c.y - r, 2 * r, 2 * r);
+        break;
+    }
+    case SvgElementType::Ellipse: {
+        const auto& ellipse = static_cast<const SvgEllipse&>(element);
+        Point c = ellipse.getCenter();
+        shapeItem = new QGraphicsEllipseItem(c.x - ellipse.getRx(), c.y - ellipse.getRy(), 2 * ellipse.getRx(), 2 * ellipse.getRy());
+        break;
+    }
+    case SvgElementType::Polygon:
+    case SvgElementType::Pentagon:
+    case SvgElementType::Hexagon:
+    case SvgElementType::Star: {
+        const auto& polygon = static_cast<const SvgPolygon&>(element);
+        QPolygonF qPolygon;
+        qPolygon.reserve(static_cast<int>(polygon.getPoints().size()));
+        for (const auto& point : polygon.getPoints()) {
+            qPolygon << QPointF(point.x, point.y);
+        }
+        shapeItem = new QGraphicsPolygonItem(qPolygon);
+        break;
+    }
+    case SvgElementType::Polyline: {
+        const auto& polyline = static_cast<const SvgPolyline&>(element);
+        const std::vector<Point>& points = polyline.getPoints();
+        QPainterPath path;
+        if (!points.empty()) {
+            path.moveTo(points[0].x, points[0].y);
+            for (size_t i = 1; i < points.size(); ++i) {
+                path.lineTo(points[i].x, points[i].y);
+            }
+        }
+        auto pathItem = new QGraphicsPathItem(path);
+        pathItem->setPen(svgStrokePen(element));
+        // Polylines are open paths and are never filled
+        pathItem->setBrush(Qt::NoBrush);
+        item = pathItem;
+        break;
+    }
+    case SvgElementType::Text: {
+        const auto& text = static_cast<const SvgText&>(element);
+        auto textItem = new QGraphicsSimpleTextItem(QString::fromStdString(text.getTextContent()));
+        textItem->setPos(text.getPosition().x, text.getPosition().y);
+
+        QFont font;
+        font.setFamily(QString::fromStdString(text.getFontFamily()));
+        font.setPointSizeF(text.getFontSize());
+        font.setBold(text.isBold());
+        font.setItalic(text.isItalic());
+        textItem->setFont(font);
+
+        // Text is painted with the fill colour, falling back to the stroke colour
+        Color textColor = text.getFillColor();
+        textItem->setBrush(QBrush(svgQColor(textColor.alpha > 0 ? textColor : text.getStrokeColor())));
+
+        // Outline only when a visible stroke is set
+        Color strokeColor = text.getStrokeColor();
+        if (strokeColor.alpha > 0 && text.getStrokeWidth() > 0) {
+            textItem->setPen(svgStrokePen(element));
+        } else {
+            textItem->setPen(Qt::NoPen);
+        }
+        item = textItem;
+        break;
+    }
+    }
+
+    if (shapeItem) {
+        shapeItem->setPen(svgStrokePen(element));
+        shapeItem->setBrush(QBrush(svgQColor(element.getFillColor())));
+        item = shapeItem;
+    }
+    if (!item) {
+        qCWarning(svgSceneAdapterLog) << "No graphics item for element type" << static_cast<int>(element.getType());
+        return nullptr;
+    }
+
+    const Transform& transform = element.getTransform();
+    if (!transform.isIdentity()) {
+        // The SVG matrix applies to scene coordinates, while an item's transform
+        // applies before its position; conjugate by the position so both agree
+        QPointF pos = item->pos();
+        item->setTransform(QTransform::fromTranslate(pos.x(), pos.y())
+            * QTransform(transform.a, transform.b, transform.c, transform.d, transform.e, transform.f)
+            * QTransform::fromTranslate(-pos.x(), -pos.y()));
+    }
+    item->setOpacity(element.getOpacity());
+    item->setFlag(QGraphicsItem::ItemIsSelectable, true);
+    item->setFlag(QGraphicsItem::ItemIsMovable, true);
+    return item;
+}
+
+SvgElement* SvgSceneAdapter::elementForItem(const QGraphicsItem* item) const {
+    return m_document && item ? m_document->findElementByViewItem(item) : nullptr;
+}
+
+QGraphicsItem* SvgSceneAdapter::itemForElement(const SvgElement* element) {
+    // Only this adapter binds view items, so the opaque pointer is always a QGraphicsItem
+    return element ? static_cast<QGraphicsItem*>(const_cast<void*>(element->getViewItem())) : nullptr;
+}
+
+void SvgSceneAdapter::bind(QGraphicsItem* item, SvgElement* element) {
+    if (!m_document || !item || !element) {
+        return;
+    }
+    forget(element);
+    m_document->bindViewItem(element, item);
+}
+
+void SvgSceneAdapter::unbind(QGraphicsItem* item) {
+    SvgElement* element = elementForItem(item);
+    if (!element) {
+        return;
+    }
+    forget(element);
+    m_document->bindViewItem(element, nullptr);
+}
+
+void SvgSceneAdapter::forget(const SvgElement* element) {
+    auto it = m_slotIndex.find(element);
+    if (it == m_slotIndex.end()) {
+        return;
+    }
+    int index = it->second;
+    m_slots[index].element = nullptr;
+    m_slotIndex.erase(it);
+    m_live.erase(std::remove(m_live.begin(), m_live.end(), index), m_live.end());
+}
+
+void SvgSceneAdapter::clear() {
+    m_document = nullptr;
+    m_lazy = false;
+    m_slots.clear();
+    m_slotIndex.clear();
+    m_cells.clear();
+    m_oversized.clear();
+    m_live.clear();
+    m_columns = 0;
+    m_rows = 0;
+}
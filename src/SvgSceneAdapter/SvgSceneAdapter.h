@@ -0,0 +1,91 @@
+﻿#pragma once
+#include <QRectF>
+#include <unordered_map>
+#include <vector>
+#include "../CoreSvgEngine/coresvgstructs.h"
+
+class QGraphicsItem;
+class QGraphicsScene;
+class SvgDocument;
+class SvgElement;
+
+// Builds Qt graphics items from the SvgDocument model. The engine itself is
+// widget-free; only the editor links this layer, and items are created when
+// a document is shown rather than while it is parsed. Items are bound to their
+// elements through the document's view item mapping in both directions.
+//
+// Large documents are shown lazily: only elements whose bounds meet the
+// viewport (plus a margin) get an item, and items are released again once
+// they scroll out of range. The elements stay authoritative; itemForElement()
+// is nullptr while an element is not materialized.
+class SvgSceneAdapter {
+public:
+    SvgSceneAdapter() = default;
+    ~SvgSceneAdapter();
+
+    SvgSceneAdapter(const SvgSceneAdapter&) = delete;
+    SvgSceneAdapter& operator=(const SvgSceneAdapter&) = delete;
+
+    // Replaces the current items with those of `document`. Small documents get
+    // every item added to `scene`; above LAZY_THRESHOLD elements items are only
+    // created by updateViewport()
+    void build(SvgDocument& document, QGraphicsScene* scene);
+    // Materializes the elements that intersect `visibleRect` (scene coordinates)
+    // and releases lazily created items that are out of range. Items that get
+    // selected or moved are kept from then on, as are items bound by the editor.
+    void updateViewport(const QRectF& visibleRect, QGraphicsScene* scene);
+    // Creates every missing item, e.g. before rendering the whole scene
+    void materializeAll(QGraphicsScene* scene);
+    bool isLazy() const { return m_lazy; }
+    const SvgDocument* document() const { return m_document; }
+    // Creates a selectable, movable item for one element; the caller owns it.
+    // Returns nullptr for element types that have no item representation.
+    static QGraphicsItem* createItem(const SvgElement& element);
+
+    SvgElement* elementForItem(const QGraphicsItem* item) const;
+    static QGraphicsItem* itemForElement(const SvgElement* element);
+    bool contains(const QGraphicsItem* item) const { return elementForItem(item) != nullptr; }
+    // Binds an item the editor created (or restored) to its element; it is never released lazily
+    void bind(QGraphicsItem* item, SvgElement* element);
+    // Drops the binding of `item`, e.g. before its element leaves the document
+    void unbind(QGraphicsItem* item);
+    // Forgets the document and all lazy bookkeeping; the items belong to the scene
+    void clear();
+
+    static constexpr int LAZY_THRESHOLD = 2000;
+
+private:
+    // Lazy mode bookkeeping for one element of the document
+    struct Slot {
+        SvgElement* element = nullptr; // nullptr once the element is unbound or pinned
+        BoundingBox bounds;
+        // Where the item was placed when created; text items start away from the origin
+        QPointF createdPos;
+        unsigned visitStamp = 0;
+        unsigned areaStamp = 0;
+    };
+
+    SvgDocument* m_document = nullptr;
+    bool m_lazy = false;
+    std::vector<Slot> m_slots;
+    std::unordered_map<const SvgElement*, int> m_slotIndex;
+
+    // Uniform grid over the element extent; cells hold slot indices
+    double m_gridX = 0.0;
+    double m_gridY = 0.0;
+    double m_cellSize = 1.0;
+    int m_columns = 0;
+    int m_rows = 0;
+    std::vector<std::vector<int>> m_cells;
+    // Elements covering too many cells to be worth registering in each of them
+    std::vector<int> m_oversized;
+    // Slots whose item was created by updateViewport and may be released again
+    std::vector<int> m_live;
+    unsigned m_stamp = 0;
+
+    void buildGrid();
+    void materialize(int index, QGraphicsScene* scene);
+    void visitSlot(int index, const BoundingBox& area, QGraphicsScene* scene);
+    // Takes an element out of lazy management, keeping whatever item it has
+    void forget(const SvgElement* element);
+};
@@ -0,0 +1,233 @@
+#include "filetask.h"
+#include "memorybudget.h"
+#include "coresvgengine.h"
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <unordered_set>
+
+static const char* const elementTypeNames[ELEMENT_TYPE_COUNT] = {
+    "line", "rect", "circle", "ellipse", "polygon", "text", "polyline", "pentagon", "hexagon", "star",
+};
+
+// Loaded documents take a few times their SVG size; compressed files inflate
+// several times over first. Only a starting point: the measured size of the
+// document replaces it once loaded.
+static constexpr uint64_t SVG_MEMORY_FACTOR = 3;
+static constexpr uint64_t SVGZ_MEMORY_FACTOR = 20;
+static constexpr uint64_t SVGB_MEMORY_FACTOR = 2;
+
+static bool hasExtension(const std::filesystem::path& path, const char* extension) {
+    std::string actual = path.extension().string();
+    for (char& ch : actual) {
+        ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+    }
+    return actual == extension;
+}
+
+static uint64_t estimateFileMemory(const std::filesystem::path& path, uint64_t bytes) {
+    if (hasExtension(path, ".svgz")) {
+        return bytes * SVGZ_MEMORY_FACTOR;
+    }
+    if (hasExtension(path, ".svgb")) {
+        return bytes * SVGB_MEMORY_FACTOR;
+    }
+    return bytes * SVG_MEMORY_FACTOR;
+}
+
+static double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool isFinite(const BoundingBox& box) {
+    return std::isfinite(box.minX) && std::isfinite(box.minY) && std::isfinite(box.maxX) && std::isfinite(box.maxY);
+}
+
+static void inspectDocument(const SvgDocument& document, FileResult& result) {
+    result.elements = document.getElementCount();
+    result.width = document.getWidth();
+    result.height = document.getHeight();
+    result.memoryBytes = document.getMemoryUsage();
+
+    BoundingBox canvas{0, 0, result.width, result.height};
+    std::unordered_set<std::string> ids;
+    bool first = true;
+    for (const auto& element : document.getElements()) {
+        if (!element) {
+            continue;
+        }
+        SvgElementType type = element->getType();
+        ++result.typeCounts[static_cast<size_t>(type)];
+
+        std::string id = element->getID();
+        if (!id.empty() && !ids.insert(std::move(id)).second) {
+            ++result.duplicateIds;
+        }
+
+        BoundingBox box = element->getTransform().mapBoundingBox(element->getBoundingBox());
+        if (!isFinite(box)) {
+            ++result.nonFinite;
+            continue;
+        }
+        // Nothing to draw: a zero-length line, or any other shape without area
+        bool flatX = box.maxX <= box.minX;
+        bool flatY = box.maxY <= box.minY;
+        bool lineLike = type == SvgElementType::Line || type == SvgElementType::Polyline;
+        if (lineLike ? (flatX && flatY) : (flatX || flatY)) {
+            ++result.degenerate;
+        }
+        if (!box.intersects(canvas)) {
+            ++result.outsideCanvas;
+        }
+        if (first) {
+            result.bounds = box;
+            first = false;
+        } else {
+            result.bounds.minX = std::min(result.bounds.minX, box.minX);
+            result.bounds.minY = std::min(result.bounds.minY, box.minY);
+            result.bounds.maxX = std::max(result.bounds.maxX, box.maxX);
+            result.bounds.maxY = std::max(result.bounds.maxY, box.maxY);
+        }
+    }
+}
+
+FileResult processFile(const FileTask& task, const ToolOptions& options, MemoryBudget& budget) {
+    FileResult result;
+    std::error_code error;
+    result.inputBytes = std::filesystem::file_size(task.inputPath, error);
+    if (error) {
+        result.error = error.message();
+        return result;
+    }
+
+    uint64_t reserved = estimateFileMemory(task.inputPath, result.inputBytes);
+    budget.acquire(reserved);
+
+    CoreSvgEngine engine;
+    auto start = std::chrono::steady_clock::now();
+    bool loaded = engine.loadSvgFile(task.inputPath);
+    result.loadMs = elapsedMs(start);
+    const SvgDocument* document = engine.getCurrentDocument();
+    if (!loaded || !document) {
+        budget.release(reserved);
+        result.error = "not a loadable SVG, .svgz or .svgb file";
+        return result;
+    }
+    inspectDocument(*document, result);
+    QSize imageSize;
+    SvgTiledExportOptions tiledOptions;
+    tiledOptions.threads = options.renderThreads;
+    uint64_t measured = result.memoryBytes;
+    if (options.command == ToolCommand::Render) {
+        imageSize = svgRasterSize(*document, options.raster);
+        measured += svgTiledExportMemory(imageSize, tiledOptions);
+    }
+    budget.adjust(reserved, measured);
+    reserved = measured;
+
+    result.ok = true;
+    std::filesystem::path output(task.outputPath);
+    bool writes = options.command == ToolCommand::Convert || options.command == ToolCommand::Render;
+    if (writes && output.has_parent_path()) {
+        std::filesystem::create_directories(output.parent_path(), error);
+    }
+    if (options.command == ToolCommand::Render) {
+        result.imageWidth = imageSize.width();
+        result.imageHeight = imageSize.height();
+        start = std::chrono::steady_clock::now();
+        result.ok = svgExportPng(*document, task.outputPath, options.raster, tiledOptions);
+        result.renderMs = elapsedMs(start);
+        if (result.ok) {
+            result.outputBytes = std::filesystem::file_size(output, error);
+        } else {
+            result.error = "cannot render a " + std::to_string(result.imageWidth) + "x" +
+                           std::to_string(result.imageHeight) + " image to " + task.outputPath;
+        }
+    } else if (options.command == ToolCommand::Convert) {
+        start = std::chrono::steady_clock::now();
+        result.ok = CoreSvgEngine::writeSvgFile(*document, task.outputPath);
+        result.saveMs = elapsedMs(start);
+        if (result.ok) {
+            result.outputBytes = std::filesystem::file_size(output, error);
+        } else {
+            result.error = "cannot write " + task.outputPath;
+        }
+    } else if (options.command == ToolCommand::Validate && options.strict && result.warnings() > 0) {
+        result.ok = false;
+        result.error = "validation warnings";
+    }
+    budget.release(reserved);
+    return result;
+}
+
+static std::string formatBytes(uint64_t bytes) {
+    char text[32];
+    if (bytes >= 1024 * 1024) {
+        std::snprintf(text, sizeof(text), "%.1f MiB", bytes / (1024.0 * 1024.0));
+    } else {
+        std::snprintf(text, sizeof(text), "%.1f KiB", bytes / 1024.0);
+    }
+    return text;
+}
+
+std::string formatFileResult(const FileTask& task, const FileResult& result, const ToolOptions& options) {
+    char text[256];
+    if (result.elements == 0 && !result.ok) {
+        return "FAIL " + task.inputPath + ": " + result.error;
+    }
+    const char* status = !result.ok ? "FAIL" : (options.command == ToolCommand::Validate && result.warnings() > 0) ? "warn" : "ok  ";
+    double seconds = result.loadMs / 1000.0;
+    std::snprintf(text, sizeof(text), " %zu elements, %s, load %.1f ms (%.1f MiB/s)", result.elements,
+                  formatBytes(result.inputBytes).c_str(), result.loadMs,
+                  seconds > 0 ? result.inputBytes / seconds / (1024.0 * 1024.0) : 0.0);
+    std::string line = std::string(status) + " " + task.inputPath + ":" + text;
+
+    switch (options.command) {
+    case ToolCommand::Stats:
+        std::snprintf(text, sizeof(text), ", canvas %gx%g, memory %s", result.width, result.height,
+                      formatBytes(result.memoryBytes).c_str());
+        line += text;
+        if (result.elements > 0) {
+            std::snprintf(text, sizeof(text), ", bounds [%g,%g %g,%g]", result.bounds.minX, result.bounds.minY,
+                          result.bounds.maxX, result.bounds.maxY);
+            line += text;
+        }
+        for (size_t i = 0; i < ELEMENT_TYPE_COUNT; ++i) {
+            if (result.typeCounts[i] > 0) {
+                line += " " + std::string(elementTypeNames[i]) + "=" + std::to_string(result.typeCounts[i]);
+            }
+        }
+        break;
+    case ToolCommand::Validate:
+        if (result.warnings() == 0) {
+            line += ", no issues";
+        } else {
+            std::snprintf(text, sizeof(text),
+                          ", %zu duplicate ids, %zu non-finite, %zu without area, %zu outside the canvas",
+                          result.duplicateIds, result.nonFinite, result.degenerate, result.outsideCanvas);
+            line += text;
+        }
+        break;
+    case ToolCommand::Render:
+        if (result.ok) {
+            std::snprintf(text, sizeof(text), ", rendered %dx%d (%s) in %.1f ms to ", result.imageWidth,
+                          result.imageHeight, formatBytes(result.outputBytes).c_str(), result.renderMs);
+            line += text + task.outputPath;
+        } else {
+            line += ", " + result.error;
+        }
+        break;
+    case ToolCommand::Convert:
+        if (result.ok) {
+            std::snprintf(text, sizeof(text), ", wrote %s in %.1f ms to ", formatBytes(result.outputBytes).c_str(),
+                          result.saveMs);
+            line += text + task.outputPath;
+        } else {
+            line += ", " + result.error;
+        }
+        break;
+    }
+    return line;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include "coresvgstructs.h"
+#include "svgtiledexport.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class MemoryBudget;
+
+enum class ToolCommand { Stats, Validate, Convert, Render };
+
+struct ToolOptions {
+    ToolCommand command = ToolCommand::Stats;
+    // Files processed at once; 0 = one per core
+    int threads = 0;
+    // Soft cap on the memory of documents being processed at once
+    uint64_t memoryBudget = 1024ull * 1024 * 1024;
+    // convert and render: where to write; empty writes next to the input
+    std::string outputDirectory;
+    // convert: "svg", "svgz" or "svgb"; empty keeps each input's format
+    std::string format;
+    // convert: allow writing over the input file
+    bool inPlace = false;
+    // validate: count warnings as failures
+    bool strict = false;
+    // render: image size, scale and background
+    SvgRasterOptions raster;
+    // render: tiles of one image rendered at once; 1 while files run in parallel
+    int renderThreads = 1;
+};
+
+struct FileTask {
+    std::string inputPath;
+    // convert and render only
+    std::string outputPath;
+};
+
+static constexpr size_t ELEMENT_TYPE_COUNT = static_cast<size_t>(SvgElementType::Star) + 1;
+
+struct FileResult {
+    bool ok = false;
+    std::string error;
+    uint64_t inputBytes = 0;
+    uint64_t outputBytes = 0;
+    size_t elements = 0;
+    size_t typeCounts[ELEMENT_TYPE_COUNT] = {};
+    // Union of the transformed element bounds; only valid with elements
+    BoundingBox bounds;
+    double width = 0;
+    double height = 0;
+    // SvgDocument::getMemoryUsage() after loading
+    size_t memoryBytes = 0;
+    double loadMs = 0;
+    double saveMs = 0;
+    // render only; renderMs includes encoding and writing the PNG
+    int imageWidth = 0;
+    int imageHeight = 0;
+    double renderMs = 0;
+
+    // Validation findings
+    size_t duplicateIds = 0;
+    size_t nonFinite = 0;
+    size_t degenerate = 0;
+    size_t outsideCanvas = 0;
+    size_t warnings() const { return duplicateIds + nonFinite + degenerate + outsideCanvas; }
+};
+
+// Loads and inspects one file, then re-saves it for convert or writes a PNG
+// for render, holding an estimate of the memory it needs in `budget`
+// meanwhile. Thread-safe: every call works on its own engine instance.
+FileResult processFile(const FileTask& task, const ToolOptions& options, MemoryBudget& budget);
+
+// The per-file report line, without a trailing newline
+std::string formatFileResult(const FileTask& task, const FileResult& result, const ToolOptions& options);
@@ -0,0 +1,52 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// Keeps the memory reserved by concurrent file jobs under a limit by making
+// acquire() wait for others to release. A job that finds nothing else held is
+// always let through, so a single file larger than the limit still gets
+// processed, just on its own.
+class MemoryBudget {
+public:
+    explicit MemoryBudget(uint64_t limit) : m_limit(limit) {}
+
+    void acquire(uint64_t bytes) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_released.wait(lock, [&]() { return m_inUse == 0 || m_inUse + bytes <= m_limit; });
+        m_inUse += bytes;
+        m_peak = std::max(m_peak, m_inUse);
+    }
+
+    // Replaces a reservation with a measured figure without waiting
+    void adjust(uint64_t from, uint64_t to) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_inUse = m_inUse - from + to;
+        m_peak = std::max(m_peak, m_inUse);
+        if (to < from) {
+            m_released.notify_all();
+        }
+    }
+
+    void release(uint64_t bytes) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_inUse -= bytes;
+        }
+        m_released.notify_all();
+    }
+
+    // Most memory reserved at any one time
+    uint64_t peak() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_peak;
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::condition_variable m_released;
+    uint64_t m_limit;
+    uint64_t m_inUse = 0;
+    uint64_t m_peak = 0;
+};
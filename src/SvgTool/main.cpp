@@ -0,0 +1,249 @@
+#include "filetask.h"
+#include "memorybudget.h"
+#include "svgparallel.h"
+#include "svgtrace.h"
+#include <QCoreApplication>
+#include <QGuiApplication>
+#include <QLoggingCategory>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+static void printUsage() {
+    std::printf(
+        "Usage: svgtool <command> [options] <file or directory>...\n\n"
+        "Commands:\n"
+        "  stats      element counts by type, canvas, element bounds and memory\n"
+        "  validate   load and check for duplicate ids, non-finite geometry, shapes\n"
+        "             without area and shapes outside the canvas\n"
+        "  convert    load and save again through the engine, which normalizes the\n"
+        "             markup; the format follows --format or the input's\n"
+        "  render     rasterize to PNG next to the input or below -o, in tiles\n"
+        "             streamed to the file, so any image size fits in memory\n\n"
+        "Options:\n"
+        "  -j N               files processed at once (default: one per core)\n"
+        "  --max-memory MiB   memory for documents in flight (default 1024); a file\n"
+        "                     that needs more is processed on its own\n"
+        "  -o DIR             convert, render: output directory (default: next to\n"
+        "                     the input)\n"
+        "  --format F         convert: svg, svgz or svgb\n"
+        "  --in-place         convert: allow replacing an input file with its output,\n"
+        "                     e.g. without -o or --format\n"
+        "  --strict           validate: fail files that have warnings\n"
+        "  --scale S          render: pixels per document unit (default 1)\n"
+        "  --size WxH         render: fit the document into WxH pixels instead\n"
+        "  --stretch          render: fill --size exactly, ignoring the aspect ratio\n"
+        "  --background C     render: color behind the document, e.g. white, #ff8800\n"
+        "                     or transparent (default: the document's background)\n\n"
+        "Directories are searched recursively for .svg, .svgz and .svgb files.\n"
+        "Exits with 1 if any file failed.\n");
+}
+
+static bool isDocumentFile(const std::filesystem::path& path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
+    return extension == ".svg" || extension == ".svgz" || extension == ".svgb";
+}
+
+// Inputs with their output paths; a directory's files keep their place below
+// it in the output directory
+static bool collectTasks(const std::vector<std::string>& inputs, const ToolOptions& options,
+                         std::vector<FileTask>& tasks) {
+    auto outputFor = [&options](const std::filesystem::path& input, const std::filesystem::path& relative) {
+        std::filesystem::path output = options.outputDirectory.empty()
+            ? input
+            : std::filesystem::path(options.outputDirectory) / relative;
+        if (options.command == ToolCommand::Render) {
+            output.replace_extension(".png");
+        } else if (!options.format.empty()) {
+            output.replace_extension("." + options.format);
+        }
+        return output.string();
+    };
+
+    for (const std::string& input : inputs) {
+        std::error_code error;
+        std::filesystem::path root(input);
+        if (std::filesystem::is_directory(root, error)) {
+            std::vector<std::filesystem::path> found;
+            for (auto it = std::filesystem::recursive_directory_iterator(root, error);
+                 !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+                if (it->is_regular_file() && isDocumentFile(it->path())) {
+                    found.push_back(it->path());
+                }
+            }
+            if (error) {
+                std::fprintf(stderr, "Cannot read directory %s: %s\n", input.c_str(), error.message().c_str());
+                return false;
+            }
+            // Directory order varies between file systems; keep runs comparable
+            std::sort(found.begin(), found.end());
+            for (const auto& path : found) {
+                tasks.push_back({path.string(), outputFor(path, path.lexically_relative(root))});
+            }
+        } else if (std::filesystem::exists(root, error)) {
+            tasks.push_back({input, outputFor(root, root.filename())});
+        } else {
+            std::fprintf(stderr, "No such file or directory: %s\n", input.c_str());
+            return false;
+        }
+    }
+
+    // A convert that only normalizes the markup would otherwise overwrite its source
+    if (options.command == ToolCommand::Convert && !options.inPlace) {
+        for (const FileTask& task : tasks) {
+            std::error_code error;
+            if (std::filesystem::equivalent(task.inputPath, task.outputPath, error)) {
+                std::fprintf(stderr, "Refusing to overwrite %s; pass -o, --format or --in-place\n",
+                             task.inputPath.c_str());
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2) {
+        printUsage();
+        return 2;
+    }
+    ToolOptions options;
+    if (std::strcmp(argv[1], "stats") == 0) {
+        options.command = ToolCommand::Stats;
+    } else if (std::strcmp(argv[1], "validate") == 0) {
+        options.command = ToolCommand::Validate;
+    } else if (std::strcmp(argv[1], "convert") == 0) {
+        options.command = ToolCommand::Convert;
+    } else if (std::strcmp(argv[1], "render") == 0) {
+        options.command = ToolCommand::Render;
+    } else {
+        printUsage();
+        return std::strcmp(argv[1], "--help") == 0 || std::strcmp(argv[1], "-h") == 0 ? 0 : 2;
+    }
+
+    std::vector<std::string> inputs;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-j" && hasValue) {
+            options.threads = std::atoi(argv[++i]);
+        } else if (arg == "--max-memory" && hasValue) {
+            options.memoryBudget = std::strtoull(argv[++i], nullptr, 10) * 1024 * 1024;
+        } else if (arg == "-o" && hasValue) {
+            options.outputDirectory = argv[++i];
+        } else if (arg == "--format" && hasValue) {
+            options.format = argv[++i];
+            if (options.format != "svg" && options.format != "svgz" && options.format != "svgb") {
+                std::fprintf(stderr, "Unknown format: %s\n", options.format.c_str());
+                return 2;
+            }
+        } else if (arg == "--in-place") {
+            options.inPlace = true;
+        } else if (arg == "--strict") {
+            options.strict = true;
+        } else if (arg == "--scale" && hasValue) {
+            options.raster.scale = std::atof(argv[++i]);
+            if (!(options.raster.scale > 0)) {
+                std::fprintf(stderr, "Scale must be positive: %s\n", argv[i]);
+                return 2;
+            }
+        } else if (arg == "--size" && hasValue) {
+            int width = 0;
+            int height = 0;
+            if (std::sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+                std::fprintf(stderr, "Size must be WIDTHxHEIGHT in pixels: %s\n", argv[i]);
+                return 2;
+            }
+            options.raster.size = QSize(width, height);
+        } else if (arg == "--stretch") {
+            options.raster.keepAspectRatio = false;
+        } else if (arg == "--background" && hasValue) {
+            options.raster.background = QColor(QString::fromUtf8(argv[++i]));
+            if (!options.raster.background.isValid()) {
+                std::fprintf(stderr, "Unknown color: %s\n", argv[i]);
+                return 2;
+            }
+        } else if (!arg.empty() && arg[0] == '-') {
+            std::fprintf(stderr, "Unknown option: %s\n\n", arg.c_str());
+            printUsage();
+            return 2;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    if (inputs.empty() || options.threads < 0 || options.memoryBudget == 0) {
+        printUsage();
+        return 2;
+    }
+
+    // Rendering text needs the font database of a GUI application; without a
+    // display it runs on the offscreen platform plugin
+    std::unique_ptr<QCoreApplication> app;
+    if (options.command == ToolCommand::Render) {
+        if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        }
+        app = std::make_unique<QGuiApplication>(argc, argv);
+    } else {
+        app = std::make_unique<QCoreApplication>(argc, argv);
+    }
+
+    // The report replaces the engine's per-document logging
+    QLoggingCategory::setFilterRules("*.debug=false\n*.info=false");
+    svgTraceSetEnabled(false);
+
+    std::vector<FileTask> tasks;
+    if (!collectTasks(inputs, options, tasks)) {
+        return 2;
+    }
+
+    // A single image gets every thread for its tiles instead
+    if (tasks.size() == 1) {
+        options.renderThreads = options.threads;
+    }
+
+    MemoryBudget budget(options.memoryBudget);
+    std::mutex reportMutex;
+    size_t failed = 0;
+    size_t warnings = 0;
+    size_t elements = 0;
+    uint64_t inputBytes = 0;
+    uint64_t outputBytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    int threads = svgResolveThreadCount(options.threads);
+
+    svgParallelFor(tasks.size(), threads, [&](size_t index) {
+        FileResult result = processFile(tasks[index], options, budget);
+        std::string line = formatFileResult(tasks[index], result, options);
+        std::lock_guard<std::mutex> lock(reportMutex);
+        std::printf("%s\n", line.c_str());
+        std::fflush(stdout);
+        failed += result.ok ? 0 : 1;
+        warnings += result.warnings();
+        elements += result.elements;
+        inputBytes += result.inputBytes;
+        outputBytes += result.outputBytes;
+    });
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("\n%zu files, %zu failed, %zu warnings, %zu elements, %.1f MiB in",
+                tasks.size(), failed, warnings, elements, inputBytes / (1024.0 * 1024.0));
+    if (options.command == ToolCommand::Convert || options.command == ToolCommand::Render) {
+        std::printf(", %.1f MiB out", outputBytes / (1024.0 * 1024.0));
+    }
+    std::printf("\n%.2f s on %d threads: %.1f files/s, %.0f elements/s, %.1f MiB/s; peak document memory %.1f MiB\n",
+                seconds, threads, seconds > 0 ? tasks.size() / seconds : 0.0, seconds > 0 ? elements / seconds : 0.0,
+                seconds > 0 ? inputBytes / seconds / (1024.0 * 1024.0) : 0.0, budget.peak() / (1024.0 * 1024.0));
+    return failed > 0 ? 1 : 0;
+}